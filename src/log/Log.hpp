@@ -68,6 +68,12 @@ public:
 	}
 	void setDetail(Detail detail);
 
+	/// Сообщения уровня будут записаны (чтобы не готовить аргументы впустую)
+	bool enabled(Detail detail) const
+	{
+		return _detail <= detail;
+	}
+
 	void trace(const std::string& message);
 	void trace(const char* fmt, ...);
 
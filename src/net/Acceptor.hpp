@@ -26,6 +26,7 @@
 #include "../configs/Setting.hpp"
 #include "../utils/Named.hpp"
 #include "../transport/ServerTransport.hpp"
+#include "../telemetry/Metric.hpp"
 
 class Acceptor : public Connection
 {
@@ -38,4 +39,6 @@ public:
 
 	explicit Acceptor(const std::shared_ptr<ServerTransport>& transport);
 	~Acceptor() override = default;
+
+	std::shared_ptr<Metric> metricAcceptRate;
 };
@@ -19,13 +19,22 @@
 // AcceptorFactory.cpp
 
 
+#include <cstdlib>
+#include <sys/socket.h>
 #include "../configs/Setting.hpp"
 #include "Acceptor.hpp"
 #include "SslAcceptor.hpp"
+#include "UnixAcceptor.hpp"
 #include "../utils/SslHelper.hpp"
 
 std::shared_ptr<AcceptorFactory::Creator> AcceptorFactory::creator(const Setting& setting)
 {
+	// Локальный UNIX-сокет вместо TCP
+	if (setting.exists("path"))
+	{
+		return unixCreator(setting);
+	}
+
 	std::string host;
 	if (!setting.lookupValue("host", host) || host.empty())
 	{
@@ -57,22 +66,123 @@ std::shared_ptr<AcceptorFactory::Creator> AcceptorFactory::creator(const Setting
 	{
 	}
 
+	int backlog = SOMAXCONN;
+	if (setting.exists("backlog"))
+	{
+		setting.lookupValue("backlog", backlog);
+		if (backlog <= 0)
+		{
+			throw std::runtime_error("Bad config: wrong backlog");
+		}
+	}
+
+	bool reusePort = false;
+	if (setting.exists("reuseport"))
+	{
+		setting.lookupValue("reuseport", reusePort);
+	}
+
 	if (secure)
 	{
 		return std::make_shared<Creator>(
-			[host = std::move(host), port](const std::shared_ptr<ServerTransport>& transport)
+			[host = std::move(host), port, backlog, reusePort](const std::shared_ptr<ServerTransport>& transport)
 			{
-				return SslAcceptor::create(transport, host, port, SslHelper::getServerContext());
+				return SslAcceptor::create(transport, host, port, backlog, reusePort, SslHelper::getServerContext());
 			}
 		);
 	}
 	else
 	{
 		return std::make_shared<Creator>(
-			[host = std::move(host), port](const std::shared_ptr<ServerTransport>& transport)
+			[host = std::move(host), port, backlog, reusePort](const std::shared_ptr<ServerTransport>& transport)
 			{
-				return TcpAcceptor::create(transport, host, port);
+				return TcpAcceptor::create(transport, host, port, backlog, reusePort);
 			}
 		);
 	}
 }
+
+std::shared_ptr<AcceptorFactory::Creator> AcceptorFactory::unixCreator(const Setting& setting)
+{
+	std::string path;
+	setting.lookupValue("path", path);
+	if (path.empty())
+	{
+		throw std::runtime_error("Bad config: empty path");
+	}
+
+	bool secure = false;
+	if (setting.exists("secure"))
+	{
+		setting.lookupValue("secure", secure);
+	}
+	if (secure)
+	{
+		throw std::runtime_error("Bad config: secure isn't supported on unix socket");
+	}
+
+	int backlog = SOMAXCONN;
+	if (setting.exists("backlog"))
+	{
+		setting.lookupValue("backlog", backlog);
+		if (backlog <= 0)
+		{
+			throw std::runtime_error("Bad config: wrong backlog");
+		}
+	}
+
+	// Права на файл сокета задаются восьмеричной строкой (например, "0660")
+	mode_t mode = 0;
+	if (setting.exists("mode"))
+	{
+		std::string modeStr;
+		setting.lookupValue("mode", modeStr);
+		char* end = nullptr;
+		auto value = strtoul(modeStr.c_str(), &end, 8);
+		if (modeStr.empty() || *end != '\0' || value > 07777)
+		{
+			throw std::runtime_error("Bad config: wrong mode");
+		}
+		mode = static_cast<mode_t>(value);
+	}
+
+	return std::make_shared<Creator>(
+		[path = std::move(path), backlog, mode](const std::shared_ptr<ServerTransport>& transport)
+		{
+			return UnixAcceptor::create(transport, path, backlog, mode);
+		}
+	);
+}
+
+size_t AcceptorFactory::listeners(const Setting& setting)
+{
+	// UNIX-сокет по одному пути может слушать только один сокет
+	if (setting.exists("path"))
+	{
+		return 1;
+	}
+
+	bool reusePort = false;
+	if (setting.exists("reuseport"))
+	{
+		setting.lookupValue("reuseport", reusePort);
+	}
+
+	// Без SO_REUSEPORT второй сокет на тот же порт не забиндить
+	if (!reusePort)
+	{
+		return 1;
+	}
+
+	int listeners = 0;
+	if (setting.exists("listeners"))
+	{
+		setting.lookupValue("listeners", listeners);
+		if (listeners < 0)
+		{
+			throw std::runtime_error("Bad config: wrong count of listeners");
+		}
+	}
+
+	return static_cast<size_t>(listeners);
+}
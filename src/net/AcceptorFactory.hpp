@@ -52,4 +52,10 @@ private:
 
 public:
 	static std::shared_ptr<AcceptorFactory::Creator> creator(const Setting& setting);
+
+	/// Создатель слушающего UNIX-сокета (в том числе в абстрактном пространстве имен)
+	static std::shared_ptr<AcceptorFactory::Creator> unixCreator(const Setting& setting);
+
+	/// Количество слушающих сокетов (0 - по одному на реактор)
+	static size_t listeners(const Setting& setting);
 };
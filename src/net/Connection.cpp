@@ -22,22 +22,23 @@
 #include <unistd.h>
 #include "Connection.hpp"
 #include "ConnectionManager.hpp"
+#include "../utils/ObjectPool.hpp"
 
-static uint64_t id4noname = 0;
+static std::atomic<uint64_t> id4noname(0);
 
 Connection::Connection(const std::shared_ptr<Transport>& transport)
-: _log("Connection")
+: _id(++id4noname)
+, _log("Connection")
 , _transport(transport)
 , _sock(-1)
 , _timeout(false)
 , _closed(true)
 , _error(false)
 {
-	_captured = false;
+	_state = 0;
+	_reactorId = 0;
 	_events = 0;
-	_postponedEvents = 0;
-
-	_name = "Connection[" + std::to_string(++id4noname) + "]";
+	_pendingEvents = 0;
 
 	_ready = false;
 }
@@ -50,11 +51,21 @@ Connection::~Connection()
 	}
 }
 
+std::string Connection::formatName() const
+{
+	// Имя, заданное наследником явно
+	if (!_name.empty())
+	{
+		return _name;
+	}
+	return "Connection[" + std::to_string(_id) + "]";
+}
+
 void Connection::setTtl(std::chrono::milliseconds ttl)
 {
 	if (!_timeoutForClose)
 	{
-		_timeoutForClose = std::make_shared<Timer>(
+		_timeoutForClose = makePooled<Timer>(
 			[wp = std::weak_ptr<std::remove_reference<decltype(*this)>::type>(ptr())](){
 				if (auto connection = wp.lock())
 				{
@@ -22,9 +22,12 @@
 #pragma once
 
 #include <mutex>
+#include <atomic>
+#include <functional>
 #include <sys/epoll.h>
 #include "../utils/Shareable.hpp"
 #include "../utils/Named.hpp"
+#include "../utils/IntrusiveQueue.hpp"
 #include "../log/Log.hpp"
 #include "../transport/Transport.hpp"
 #include "../utils/Context.hpp"
@@ -32,12 +35,38 @@
 #include "../utils/Timer.hpp"
 #include <unistd.h>
 
-class Connection: public Shareable<Connection>, public Named
+class Connection: public Shareable<Connection>, public Named, public IntrusiveQueue::Node
 {
+public:
+	/// Биты состояния соединения в менеджере соединений
+	enum StateBit : uint32_t
+	{
+		REGISTERED	= 1<<0,
+		READY		= 1<<1,
+		CAPTURED	= 1<<2,
+		SUSPENDED	= 1<<3
+	};
+
 private:
-	bool _captured;
+	std::atomic<uint32_t> _state;
+	size_t _reactorId;
+
+	/// События текущего цикла обработки (меняет только захвативший поток)
 	uint32_t _events;
-	uint32_t _postponedEvents;
+
+	/// Накопленные, но еще не взятые в обработку события
+	std::atomic<uint32_t> _pendingEvents;
+
+	/// Удерживает соединение, пока оно стоит в очереди готовых
+	std::shared_ptr<Connection> _readyHolder;
+
+	/// Передача обработки другому исполнителю: запускается после выхода из processing() (меняет только захвативший поток)
+	std::function<void()> _continuation;
+
+	/// Порядковый номер (для имени по умолчанию)
+	const uint64_t _id;
+
+	mutable std::once_flag _nameFormatted;
 
 protected:
 	Log _log;
@@ -62,6 +91,10 @@ protected:
 	/// Таймаут закрытия
 	std::shared_ptr<Timer> _timeoutForClose;
 
+	/// Сформировать имя соединения. Вызывается один раз, при первом обращении к имени,
+	/// чтобы не тратиться на форматирование, когда имя нужно только отладочному логу
+	virtual std::string formatName() const;
+
 public:
 	Connection() = delete;
 	Connection(const Connection&) = delete;
@@ -77,6 +110,12 @@ public:
 		return _sock;
 	}
 
+	const std::string& name() const
+	{
+		std::call_once(_nameFormatted, [this](){ _name = formatName(); });
+		return _name;
+	}
+
 	void setTtl(std::chrono::milliseconds ttl);
 
 	std::shared_ptr<Context> getContext()
@@ -106,39 +145,105 @@ public:
 		return _closed;
 	}
 
+	inline size_t reactorId() const
+	{
+		return _reactorId;
+	}
+	inline void setReactorId(size_t reactorId)
+	{
+		_reactorId = reactorId;
+	}
+
+	/// Пометить зарегистрированным. false - соединение уже зарегистрировано (другим вызовом)
+	inline bool setRegistered()
+	{
+		return (_state.fetch_or(REGISTERED) & REGISTERED) == 0;
+	}
+	inline void setUnregistered()
+	{
+		_state.fetch_and(~static_cast<uint32_t>(REGISTERED));
+	}
+	inline bool isRegistered() const
+	{
+		return (_state.load() & REGISTERED) != 0;
+	}
+
+	/// Пометить готовым к обработке. true - вызвавший обязан поставить соединение в очередь готовых
+	bool markReady(const std::shared_ptr<Connection>& holder)
+	{
+		uint32_t state = _state.load();
+		do
+		{
+			// Уже в очереди, в обработке или снято с регистрации
+			if ((state & REGISTERED) == 0 || (state & (READY | CAPTURED)) != 0)
+			{
+				return false;
+			}
+		}
+		while (!_state.compare_exchange_weak(state, state | READY));
+
+		_readyHolder = holder;
+		return true;
+	}
+	/// Забрать удерживающую ссылку (после извлечения из очереди готовых)
+	inline std::shared_ptr<Connection> takeReadyHolder()
+	{
+		return std::move(_readyHolder);
+	}
+	/// Снять пометку готовности без захвата
+	inline void resetReady()
+	{
+		_state.fetch_and(~static_cast<uint32_t>(READY));
+	}
+
 	inline void setReleased()
 	{
-		_captured = false;
 		_events = 0;
+		_state.fetch_and(~static_cast<uint32_t>(CAPTURED));
 	}
 	inline void setCaptured()
 	{
-		_captured = true;
+		_events = _pendingEvents.exchange(0);
+		// Сначала захват, потом снятие готовности: иначе соединение могут поставить в очередь повторно
+		_state.fetch_or(CAPTURED);
+		_state.fetch_and(~static_cast<uint32_t>(READY));
+	}
+	/// Обработка передана другому исполнителю - захват сохраняется до возобновления
+	inline void setSuspended(std::function<void()>&& continuation)
+	{
+		_continuation = std::move(continuation);
+		_state.fetch_or(SUSPENDED);
+	}
+	inline bool takeSuspended()
+	{
+		return (_state.fetch_and(~static_cast<uint32_t>(SUSPENDED)) & SUSPENDED) != 0;
+	}
+	inline std::function<void()> takeContinuation()
+	{
+		std::function<void()> continuation;
+		continuation.swap(_continuation);
+		return continuation;
 	}
 	inline bool isCaptured() const
 	{
-		return _captured;
+		return (_state.load() & CAPTURED) != 0;
 	}
 
 	uint32_t events()
 	{
 		return _events;
 	}
+	inline bool hasPendingEvents() const
+	{
+		return _pendingEvents.load() != 0;
+	}
 	void appendEvents(uint32_t events)
 	{
-		if (_captured)
-		{
-			_postponedEvents |= events;
-		}
-		else
-		{
-			_events |= events;
-		}
+		_pendingEvents.fetch_or(events);
 	}
 	uint32_t rotateEvents()
 	{
-		_events = _postponedEvents;
-		_postponedEvents = 0;
+		_events = _pendingEvents.exchange(0);
 		return _events;
 	}
 
@@ -173,9 +278,17 @@ public:
 		return static_cast<bool>(_events & static_cast<uint32_t>(ConnectionEvent::Type::TIMEOUT));
 	}
 
+	inline bool isIdle() const
+	{
+		return static_cast<bool>(_events & static_cast<uint32_t>(ConnectionEvent::Type::IDLE));
+	}
+
 	virtual void watch(epoll_event &ev) = 0;
 
 	virtual bool processing() = 0;
 
+	/// Учесть системные вызовы механизма событий, сделанные ради соединения (add/modify/remove)
+	virtual void addEngineSyscalls(size_t) {};
+
 	virtual void close() {};
 };
@@ -28,6 +28,7 @@ struct ConnectionEvent
 		WRITE	= 1<<1,
 		HUP		= 1<<2,
 		HALFHUP	= 1<<3,
+		IDLE	= 1<<5,
 		TIMEOUT	= 1<<6,
 		ERROR	= 1<<7
 	};
@@ -39,6 +40,7 @@ struct ConnectionEvent
 		if (events & static_cast<uint32_t>(Type::WRITE))	result.push_back('W');
 		if (events & static_cast<uint32_t>(Type::HUP))		result.push_back('C');
 		if (events & static_cast<uint32_t>(Type::HALFHUP))	result.push_back('H');
+		if (events & static_cast<uint32_t>(Type::IDLE))		result.push_back('I');
 		if (events & static_cast<uint32_t>(Type::TIMEOUT))	result.push_back('T');
 		if (events & static_cast<uint32_t>(Type::ERROR))	result.push_back('E');
 		return result;
@@ -26,58 +26,230 @@
 #include "../utils/Daemon.hpp"
 #include "../thread/RollbackStackAndRestoreContext.hpp"
 #include "../thread/TaskManager.hpp"
+#include "../utils/TimerWheel.hpp"
+
+ConnectionManager::Reactor::Reactor(size_t id_, const std::string& engineType)
+: id(id_)
+, engine(EventEngine::create(engineType, poolSize))
+{
+	memset(epev, 0, sizeof(epev));
+}
+
+ConnectionManager::Reactor::~Reactor()
+{
+	// Отпускаем соединения, оставшиеся в очереди готовых
+	while (auto node = readyConnections.pop())
+	{
+		auto connection = static_cast<Connection*>(node);
+		auto holder = connection->takeReadyHolder();
+		connection->resetReady();
+	}
+}
+
+bool ConnectionManager::Reactor::ready(const std::shared_ptr<Connection>& connection)
+{
+	if (!connection->markReady(connection))
+	{
+		return false;
+	}
+
+	readyConnections.push(connection.get());
+	return true;
+}
+
+std::shared_ptr<Connection> ConnectionManager::Reactor::capture()
+{
+	while (auto node = readyConnections.pop())
+	{
+		auto connection = static_cast<Connection*>(node);
+		auto holder = connection->takeReadyHolder();
+
+		// Снятые с регистрации за время ожидания в очереди просто отпускаем
+		if (!connection->isRegistered())
+		{
+			connection->resetReady();
+			continue;
+		}
+
+		connection->setCaptured();
+
+		return holder;
+	}
+
+	return nullptr;
+}
 
 ConnectionManager::ConnectionManager()
 : _log("ConnectionManager")
+, _engineType("epoll")
+, _nextReactor(0)
+, _connectionCount(0)
 {
-	_epfd = epoll_create(poolSize);
-	memset(_epev, 0, sizeof(_epev));
+	_reactors.emplace_back(new Reactor(0, _engineType));
 }
 
 ConnectionManager::~ConnectionManager()
 {
-	std::lock_guard<std::recursive_mutex> guard(_mutex);
 	std::vector<std::shared_ptr<Connection>> connections;
-	for (auto& i : _allConnections)
+	for (auto& reactor : _reactors)
 	{
-		connections.emplace_back(i.second);
+		std::lock_guard<std::recursive_mutex> guard(reactor->mutex);
+		for (auto& i : reactor->connections)
+		{
+			connections.emplace_back(i.second);
+		}
 	}
 	for (auto& connection : connections)
 	{
 		remove(connection);
 	}
-	close(_epfd);
-	_epfd = -1;
+	_reactors.clear();
+}
+
+/// Задать количество реакторов (до регистрации первого соединения)
+void ConnectionManager::setReactorCount(size_t count)
+{
+	auto& instance = getInstance();
+
+	std::lock_guard<std::mutex> guard(instance._mutex);
+
+	if (count == 0)
+	{
+		count = 1;
+	}
+
+	if (count == instance._reactors.size())
+	{
+		return;
+	}
+
+	// Набор реакторов меняем только пока нет соединений - дальше он читается без блокировки
+	if (instance._connectionCount > 0)
+	{
+		instance._log.warn("Can't change count of reactors: some connections already registered");
+		return;
+	}
+
+	instance._reactors.clear();
+	for (size_t id = 0; id < count; ++id)
+	{
+		instance._reactors.emplace_back(new Reactor(id, instance._engineType));
+	}
+
+	instance._log.debug("Use %zu reactor(s)", count);
+}
+
+size_t ConnectionManager::reactorCount()
+{
+	return getInstance()._reactors.size();
+}
+
+/// Выбрать механизм событий
+void ConnectionManager::setEngine(const std::string& type)
+{
+	auto& instance = getInstance();
+
+	std::lock_guard<std::mutex> guard(instance._mutex);
+
+	std::string engineType = type.empty() ? "epoll" : type;
+
+	if (engineType == instance._engineType)
+	{
+		return;
+	}
+
+	if (instance._connectionCount > 0)
+	{
+		instance._log.warn("Can't change event engine: some connections already registered");
+		return;
+	}
+
+	// Пробуем создать механизм заранее, чтобы откатиться на epoll один раз, а не в каждом реакторе
+	try
+	{
+		EventEngine::create(engineType, poolSize);
+	}
+	catch (const std::exception& exception)
+	{
+		if (engineType == "epoll")
+		{
+			throw;
+		}
+		instance._log.warn("Event engine '%s' is unavailable, fallback to epoll ← %s", engineType.c_str(), exception.what());
+		engineType = "epoll";
+	}
+
+	if (engineType == instance._engineType)
+	{
+		return;
+	}
+
+	instance._engineType = engineType;
+
+	auto count = instance._reactors.size();
+	instance._reactors.clear();
+	for (size_t id = 0; id < count; ++id)
+	{
+		instance._reactors.emplace_back(new Reactor(id, instance._engineType));
+	}
+
+	instance._log.info("Use '%s' event engine", instance._engineType.c_str());
+}
+
+const std::string& ConnectionManager::engine()
+{
+	return getInstance()._engineType;
+}
+
+EventEngine& ConnectionManager::engineOf(const std::shared_ptr<Connection>& connection)
+{
+	return *getInstance().reactorOf(connection).engine;
+}
+
+ConnectionManager::Reactor& ConnectionManager::reactorOf(const std::shared_ptr<Connection>& connection)
+{
+	return *_reactors[connection->reactorId() % _reactors.size()];
 }
 
 /// Зарегистрировать соединение
 void ConnectionManager::add(const std::shared_ptr<Connection>& connection)
 {
-	std::lock_guard<std::recursive_mutex> guard(getInstance()._mutex);
+	auto& instance = getInstance();
 
-	if (getInstance()._allConnections.find(connection.get()) != getInstance()._allConnections.end())
+	// Проверка и пометка одной операцией: параллельные вызовы не зарегистрируют соединение в двух реакторах
+	if (!connection->setRegistered())
 	{
-		getInstance()._log.warn("%s already registered in manager", connection->name().c_str());
+		instance._log.warn("%s already registered in manager", connection->name().c_str());
 		return;
 	}
 
-	getInstance()._allConnections.emplace(connection.get(), connection);
+	// Закрепляем соединение за реактором (по кругу)
+	auto& reactor = *instance._reactors[instance._nextReactor++ % instance._reactors.size()];
+
+	std::lock_guard<std::recursive_mutex> guard(reactor.mutex);
+
+	connection->setReactorId(reactor.id);
 
-	getInstance()._log.debug("%s registered in manager", connection->name().c_str());
+	reactor.connections.emplace(connection.get(), connection);
+	++instance._connectionCount;
+
+	if (instance._log.enabled(Log::Detail::DEBUG)) instance._log.debug("%s registered in manager (reactor #%zu)", connection->name().c_str(), reactor.id);
 
 	epoll_event ev{};
 
 	connection->watch(ev);
 
 	// Включаем наблюдение
-	if (epoll_ctl(getInstance()._epfd, EPOLL_CTL_ADD, connection->fd(), &ev) == -1)
+	auto syscalls = EventEngine::syscalls();
+	if (!reactor.engine->add(connection->fd(), ev))
 	{
-		getInstance()._log.warn("Fail add %s for watching (error: '%s')", connection->name().c_str(), strerror(errno));
+		instance._log.warn("Fail add %s for watching (error: '%s')", connection->name().c_str(), strerror(errno));
 	}
 	else
 	{
-		getInstance()._log.trace("Add %s for watching", connection->name().c_str());
+		if (instance._log.enabled(Log::Detail::TRACE)) instance._log.trace("Add %s for watching", connection->name().c_str());
 	}
+	connection->addEngineSyscalls(EventEngine::syscalls() - syscalls);
 }
 
 /// Удалить регистрацию соединения
@@ -88,37 +260,47 @@ bool ConnectionManager::remove(const std::shared_ptr<Connection>& connection)
 		return false;
 	}
 
+	auto& instance = getInstance();
+
+	auto& reactor = instance.reactorOf(connection);
+
 	// Удаляем из очереди событий
-	if (epoll_ctl(getInstance()._epfd, EPOLL_CTL_DEL, connection->fd(), nullptr) == -1)
+	auto syscalls = EventEngine::syscalls();
+	if (!reactor.engine->remove(connection->fd(), connection.get()))
 	{
-		getInstance()._log.warn("Fail remove %s from watching (error: '%s')", connection->name().c_str(), strerror(errno));
+		instance._log.warn("Fail remove %s from watching (error: '%s')", connection->name().c_str(), strerror(errno));
 	}
 	else
 	{
-		getInstance()._log.trace("Remove %s from watching", connection->name().c_str());
+		if (instance._log.enabled(Log::Detail::TRACE)) instance._log.trace("Remove %s from watching", connection->name().c_str());
+	}
+	connection->addEngineSyscalls(EventEngine::syscalls() - syscalls);
+
+	std::lock_guard<std::recursive_mutex> guard(reactor.mutex);
+	if (reactor.connections.erase(connection.get()))
+	{
+		--instance._connectionCount;
 	}
 
-	std::lock_guard<std::recursive_mutex> guard(getInstance()._mutex);
-	getInstance()._allConnections.erase(connection.get());
-	getInstance()._readyConnections.erase(connection);
-	getInstance()._capturedConnections.erase(connection);
+	// Если соединение стоит в очереди готовых, оно будет отброшено при извлечении
+	connection->setUnregistered();
 
-	getInstance()._log.debug("%s unregistered from manager", connection->name().c_str());
+	if (instance._log.enabled(Log::Detail::DEBUG)) instance._log.debug("%s unregistered from manager", connection->name().c_str());
 
 	return true;
 }
 
 uint32_t ConnectionManager::rotateEvents(const std::shared_ptr<Connection>& connection)
 {
-	std::lock_guard<std::recursive_mutex> guard(getInstance()._mutex);
 	uint32_t events = connection->rotateEvents();
 	return events;
 }
 
 void ConnectionManager::watch(const std::shared_ptr<Connection>& connection)
 {
-	// Для известных соенинений проверяем состояние захваченности
-	std::lock_guard<std::recursive_mutex> guard(getInstance()._mutex);
+	auto& instance = getInstance();
+
+	auto& reactor = instance.reactorOf(connection);
 
 	// Те, что в обработке, не трогаем
 	if (connection->isCaptured())
@@ -131,103 +313,98 @@ void ConnectionManager::watch(const std::shared_ptr<Connection>& connection)
 
 	connection->watch(ev);
 
-	// Включаем наблюдение
-	if (epoll_ctl(getInstance()._epfd, EPOLL_CTL_MOD, connection->fd(), &ev) == -1)
+	// Включаем наблюдение (вызовы механизма учитываются в телеметрии соединения)
+	auto syscalls = EventEngine::syscalls();
+	if (!reactor.engine->modify(connection->fd(), ev))
 	{
-		getInstance()._log.warn("Fail modify watching on %s (error: '%s')", connection->name().c_str(), strerror(errno));
+		instance._log.warn("Fail modify watching on %s (error: '%s')", connection->name().c_str(), strerror(errno));
 	}
 	else
 	{
-		getInstance()._log.trace("Modify watching on %s", connection->name().c_str());
+		if (instance._log.enabled(Log::Detail::TRACE)) instance._log.trace("Modify watching on %s", connection->name().c_str());
 	}
+	connection->addEngineSyscalls(EventEngine::syscalls() - syscalls);
 }
 
-/// Ожидать события на соединениях
-void ConnectionManager::wait()
+/// Ожидать события на соединениях реактора
+void ConnectionManager::wait(Reactor& reactor)
 {
-	// Если набор готовых соединений не пустой, то выходим
-	if (!_readyConnections.empty())
-	{
-		return;
-	}
-
-	_mutex.unlock();
-
-	_epool_mutex.lock();
-
 	int n = 0;
 
-	while ([&](){std::lock_guard<std::recursive_mutex> lockGuard(_mutex); return _readyConnections.empty();}())
+	for (;;)
 	{
-		if ([&](){std::lock_guard<std::recursive_mutex> lockGuard(_mutex); return _allConnections.empty();}())
+		{
+			std::lock_guard<std::mutex> consumerGuard(reactor.consumerMutex);
+
+			// Если очередь готовых соединений не пуста, то выходим
+			if (!reactor.readyConnections.empty())
+			{
+				return;
+			}
+		}
+
+		if (_connectionCount == 0)
 		{
 			std::this_thread::sleep_for(std::chrono::milliseconds(100));
-			break;
+			return;
 		}
-		n = epoll_wait(_epfd, _epev, poolSize, 50);
+
+		// Проворачиваем колесо таймеров и ждем событий не дольше, чем до его следующего тика
+		TimerWheel::advance();
+
+		auto untilTimer = std::chrono::duration_cast<std::chrono::milliseconds>(
+			TimerWheel::nextExpiry() - std::chrono::steady_clock::now() + std::chrono::microseconds(999)
+		).count();
+		int timeoutMs = static_cast<int>(std::max<decltype(untilTimer)>(0, std::min<decltype(untilTimer)>(50, untilTimer)));
+
+		n = reactor.engine->wait(reactor.epev, poolSize, timeoutMs);
 		if (n < 0)
 		{
 			if (errno != EINTR)
 			{
-				_log.warn("Error waiting events of connections: fail epoll_wait (%s)", strerror(errno));
-				break;
+				_log.warn("Error waiting events of connections: fail %s (%s)", reactor.engine->name(), strerror(errno));
+				return;
 			}
 			continue;
 		}
 		if (n > 0)
 		{
-			_log.trace("Catch events on %d connection(s)", n);
+			_log.trace("Catch events on %d connection(s) by reactor #%zu", n, reactor.id);
 			break;
 		}
 		if (Daemon::shutingdown())
 		{
 			// Закрываем оставшееся
-			_epool_mutex.unlock();
-
-			_mutex.lock();
+			std::lock_guard<std::recursive_mutex> lockGuard(reactor.mutex);
 
-			if (_allConnections.empty())
+			if (reactor.connections.empty())
 			{
 				_log.debug("Interrupt waiting");
 				return;
 			}
 
-			for (auto& i : _allConnections)
+			for (auto& i : reactor.connections)
 			{
 				i.second->setTtl(std::chrono::seconds(1));
 			}
-
-//			std::vector<std::shared_ptr<Connection>> connections;
-//			for (auto& i : _allConnections)
-//			{
-//				connections.emplace_back(i.second);
-//			}
-//			for (auto& connection : connections)
-//			{
-//				remove(connection);
-//			}
-
-			_mutex.unlock();
-
-			_epool_mutex.lock();
 		}
 	}
 
-	_mutex.lock();
+	std::lock_guard<std::recursive_mutex> lockGuard(reactor.mutex);
 
 	// Перебираем полученые события
 	for (int i = 0; i < n; i++)
 	{
 		// Игнорируем незарегистрированные соединения
-		auto it = _allConnections.find(static_cast<const Connection *>(_epev[i].data.ptr));
-		if (it == _allConnections.end())
+		auto it = reactor.connections.find(static_cast<const Connection *>(reactor.epev[i].data.ptr));
+		if (it == reactor.connections.end())
 		{
-			_log.trace("Skip catching of unregistered Connection %p", _epev[i].data.ptr);
+			_log.trace("Skip catching of unregistered Connection %p", reactor.epev[i].data.ptr);
 			continue;
 		}
 		auto connection = it->second;
 
-		uint32_t fdEvent = _epev[i].events;
+		uint32_t fdEvent = reactor.epev[i].events;
 		uint32_t events = 0;
 
 		if (fdEvent & (EPOLLIN | EPOLLRDNORM))
@@ -251,62 +428,117 @@ void ConnectionManager::wait()
 			events |= static_cast<uint32_t>(ConnectionEvent::Type::ERROR);
 		}
 
-		_log.trace("Catch events `%s` (%04x) on %s", ConnectionEvent::code(events).c_str(), fdEvent, connection->name().c_str());
+		if (_log.enabled(Log::Detail::TRACE)) _log.trace("Catch events `%s` (%04x) on %s", ConnectionEvent::code(events).c_str(), fdEvent, connection->name().c_str());
 
 		connection->appendEvents(events);
 
-		// Если не в списке захваченых...
-		if (_capturedConnections.find(connection) == _capturedConnections.end())
+		// Захваченные заберут события сами, остальные ставим в очередь готовых
+		if (reactor.ready(connection))
 		{
-			_log.trace("Insert %s into ready connection list and will be processed now (by events)", connection->name().c_str());
-
-			// ...добавляем в список готовых
-			_readyConnections.insert(connection);
+			if (_log.enabled(Log::Detail::TRACE)) _log.trace("Insert %s into ready connection list and will be processed now (by events)", connection->name().c_str());
 		}
 	}
-
-	_epool_mutex.unlock();
 }
 
 /// Зарегистрировать таймаут
 void ConnectionManager::timeout(const std::shared_ptr<Connection>& connection)
 {
-	auto& instance = getInstance();
+	getInstance().inject(connection, ConnectionEvent::Type::TIMEOUT);
+}
+
+void ConnectionManager::idle(const std::shared_ptr<Connection>& connection)
+{
+	getInstance().inject(connection, ConnectionEvent::Type::IDLE);
+}
+
+size_t ConnectionManager::connectionCount()
+{
+	return getInstance()._connectionCount;
+}
+
+void ConnectionManager::inject(const std::shared_ptr<Connection>& connection, ConnectionEvent::Type event)
+{
+	auto& reactor = reactorOf(connection);
+
+	std::lock_guard<std::recursive_mutex> lockGuard(reactor.mutex);
 
-	std::lock_guard<std::recursive_mutex> lockGuard(instance._mutex);
+	auto code = ConnectionEvent::code(static_cast<uint32_t>(event));
 
 	// Игнорируем незарегистрированные соединения
-	auto it = instance._allConnections.find(connection.get());
-	if (it == instance._allConnections.end())
+	auto it = reactor.connections.find(connection.get());
+	if (it == reactor.connections.end())
 	{
-		instance._log.trace("Skip timeout adding for noregistered Connection %p", connection.get());
+		_log.trace("Skip event `%s` adding for noregistered Connection %p", code.c_str(), connection.get());
 		return;
 	}
 
-	connection->appendEvents(static_cast<uint32_t>(ConnectionEvent::Type::TIMEOUT));
+	connection->appendEvents(static_cast<uint32_t>(event));
 
-	instance._log.trace("Catch event `T` on %s", connection->name().c_str());
+	if (_log.enabled(Log::Detail::TRACE)) _log.trace("Catch event `%s` on %s", code.c_str(), connection->name().c_str());
 
-	// Если не в списке захваченых...
-	if (instance._capturedConnections.find(connection) == instance._capturedConnections.end())
+	// Захваченные заберут событие сами, остальные ставим в очередь готовых
+	if (reactor.ready(connection))
+	{
+		if (_log.enabled(Log::Detail::TRACE)) _log.trace("Insert %s into ready connection list and will be processed now (by event `%s`)", connection->name().c_str(), code.c_str());
+	}
+}
+
+/// Забрать готовое соединение у другого реактора
+std::shared_ptr<Connection> ConnectionManager::steal(Reactor& thief)
+{
+	for (size_t i = 1; i < _reactors.size(); ++i)
 	{
-		instance._log.trace("Insert %s into ready connection list and will be processed now (by timeout)", connection->name().c_str());
+		auto& victim = *_reactors[(thief.id + i) % _reactors.size()];
+
+		// Занятого соседа не ждем - идем к следующему
+		std::unique_lock<std::mutex> lock(victim.consumerMutex, std::try_to_lock);
+		if (!lock.owns_lock())
+		{
+			continue;
+		}
+
+		// Соединение остается закрепленным за своим реактором, меняется лишь исполнитель
+		auto connection = victim.capture();
+		if (!connection)
+		{
+			continue;
+		}
 
-		// ...добавляем в список готовых
-		instance._readyConnections.insert(connection);
+		if (_log.enabled(Log::Detail::TRACE)) _log.trace("Reactor #%zu steal %s from reactor #%zu", thief.id, connection->name().c_str(), victim.id);
+
+		return connection;
 	}
+
+	return nullptr;
 }
 
 /// Захватить соединение
-std::shared_ptr<Connection> ConnectionManager::capture()
+std::shared_ptr<Connection> ConnectionManager::capture(Reactor& reactor)
 {
-	std::lock_guard<std::recursive_mutex> lockGuard(_mutex);
-
-	// Если нет готовых...
-	while (_readyConnections.empty())
+	for (;;)
 	{
-		// то выходим при остановке сервера
-		if (Daemon::shutingdown() && _allConnections.empty())
+		{
+			std::lock_guard<std::mutex> consumerGuard(reactor.consumerMutex);
+
+			// Берем соединение из очереди готовых к обработке
+			auto connection = reactor.capture();
+			if (connection)
+			{
+				if (_log.enabled(Log::Detail::TRACE)) _log.trace("Capture %s", connection->name().c_str());
+
+				return connection;
+			}
+		}
+
+		// Своих готовых нет - пробуем забрать у соседей
+		auto connection = steal(reactor);
+		if (connection)
+		{
+			return connection;
+		}
+
+		// Выходим при остановке сервера
+		if (Daemon::shutingdown() && _connectionCount == 0)
 		{
 			return nullptr;
 		}
@@ -314,61 +546,120 @@ std::shared_ptr<Connection> ConnectionManager::capture()
 		_log.trace("Not found ready connection");
 
 		// а в штатном режиме ожидаем появления готового соединения
-		wait();
+		wait(reactor);
 	}
+}
+
+/// Освободить соединение
+void ConnectionManager::release(const std::shared_ptr<Connection>& connection)
+{
+	auto& reactor = reactorOf(connection);
 
-	_log.trace("Found ready connection");
+	if (_log.enabled(Log::Detail::TRACE)) _log.trace("Release %s", connection->name().c_str());
 
-	if (_readyConnections.empty())
+	connection->setReleased();
+
+	// События, пришедшие после последней ротации, не теряем
+	if (connection->hasPendingEvents())
 	{
-		return nullptr;
+		reactor.ready(connection);
+	}
+
+	if (!connection->isClosed())
+	{
+		watch(connection);
 	}
+}
 
-	// Берем соединение из набора готовых к обработке
-	auto it = _readyConnections.begin();
+void ConnectionManager::process(const std::shared_ptr<Connection>& connection)
+{
+	if (getInstance()._log.enabled(Log::Detail::TRACE)) getInstance()._log.trace("Begin processing on %s", connection->name().c_str());
 
-	auto connection = *it;
+	bool status;
+	try
+	{
+		status = connection->processing();
+	}
+	catch (const RollbackStackAndRestoreContext& exception)
+	{
+		getInstance().release(connection);
+		throw;
+	}
+	catch (const std::exception& exception)
+	{
+		status = false;
+		getInstance()._log.warn("Uncatched exception at processing on %s: %s", connection->name().c_str(), exception.what());
+	}
 
-	// Перемещаем соединение из набора готовых к обработке в набор захваченных
-	_readyConnections.erase(it);
-	_capturedConnections.insert(connection);
+	// Обработка продолжится в другом месте - соединение освободит возобновленная обработка
+	if (connection->takeSuspended())
+	{
+		if (getInstance()._log.enabled(Log::Detail::TRACE)) getInstance()._log.trace("Suspend processing on %s", connection->name().c_str());
 
-	_log.trace("Capture %s", connection->name().c_str());
+		// Соединение уже вне processing() и остается захваченным - теперь работу можно передавать
+		auto continuation = connection->takeContinuation();
+		if (continuation)
+		{
+			continuation();
+		}
+		return;
+	}
 
-	connection->setCaptured();
+	getInstance().release(connection);
 
-	return std::move(connection);
+	if (getInstance()._log.enabled(Log::Detail::TRACE)) getInstance()._log.trace("End processing on %s: %s", connection->name().c_str(), status ? "success" : "fail");
 }
 
-/// Освободить соединение
-void ConnectionManager::release(const std::shared_ptr<Connection>& connection)
+void ConnectionManager::suspend(const std::shared_ptr<Connection>& connection, std::function<void()>&& continuation)
 {
-	std::lock_guard<std::recursive_mutex> guard(_mutex);
+	connection->setSuspended(std::move(continuation));
+}
 
-	_log.trace("Release %s", connection->name().c_str());
+void ConnectionManager::resume(const std::shared_ptr<Connection>& connection)
+{
+	TaskManager::enqueue(
+		[connection]
+		{
+			process(connection);
+		},
+		"Resume processing on Connection"
+	);
+}
 
-	_capturedConnections.erase(connection);
+/// Обработка событий (запуск реакторов)
+void ConnectionManager::dispatch()
+{
+	auto& instance = getInstance();
 
-	connection->setReleased();
+	instance._log.debug("Start %zu reactor(s)", instance._reactors.size());
 
-	if (!connection->isClosed())
+	for (auto& reactor : instance._reactors)
 	{
-		watch(connection);
+		TaskManager::enqueue(
+			[&reactor = *reactor]
+			{
+				run(reactor);
+			},
+			"Dispatch events of reactor"
+		);
 	}
 }
 
-/// Обработка событий
-void ConnectionManager::dispatch()
+/// Обработка событий реактора
+void ConnectionManager::run(Reactor& reactor)
 {
+	// Цикл реактора занимает поток до остановки - порожденные им задачи выполнят другие потоки
+	TaskManager::setLongRunning(true);
+
 	for (;;)
 	{
-		std::shared_ptr<Connection> connection = getInstance().capture();
+		std::shared_ptr<Connection> connection = getInstance().capture(reactor);
 		if (!connection)
 		{
 			break;
 		}
 
-		getInstance()._log.debug("Enqueue %s for '%s' events processing", connection->name().c_str(), ConnectionEvent::code(connection->events()).c_str());
+		if (getInstance()._log.enabled(Log::Detail::DEBUG)) getInstance()._log.debug("Enqueue %s for '%s' events processing", connection->name().c_str(), ConnectionEvent::code(connection->events()).c_str());
 
 		TaskManager::enqueue(
 			[wp = std::weak_ptr<Connection>(connection)]
@@ -380,29 +671,11 @@ void ConnectionManager::dispatch()
 					return;
 				}
 
-				getInstance()._log.trace("Begin processing on %s", connection->name().c_str());
-
-				bool status;
-				try
-				{
-					status = connection->processing();
-				}
-				catch (const RollbackStackAndRestoreContext& exception)
-				{
-					getInstance().release(connection);
-					throw;
-				}
-				catch (const std::exception& exception)
-				{
-					status = false;
-					getInstance()._log.warn("Uncatched exception at processing on %s: %s", connection->name().c_str(), exception.what());
-				}
-
-				getInstance().release(connection);
-
-				getInstance()._log.trace("End processing on %s: %s", connection->name().c_str(), status ? "success" : "fail");
+				process(connection);
 			},
 			"Dispatch event on Connection"
 		);
 	}
+
+	TaskManager::setLongRunning(false);
 }
@@ -22,11 +22,13 @@
 #pragma once
 
 #include <mutex>
-#include <set>
 #include <string>
 #include <mutex>
 #include <map>
+#include <vector>
+#include <atomic>
 #include "Connection.hpp"
+#include "EventEngine.hpp"
 
 class ConnectionManager final
 {
@@ -46,37 +48,100 @@ private:
 		return instance;
 	}
 
-	static const int poolSize = 1u<<17;
+	static const int poolSize = 1u<<12;
+
+	/// Реактор: собственный механизм событий, очередь готовых соединений и блокировки
+	class Reactor final
+	{
+	public:
+		Reactor(const Reactor&) = delete;
+		Reactor& operator=(const Reactor&) = delete;
+		Reactor(Reactor&& tmp) noexcept = delete;
+		Reactor& operator=(Reactor&& tmp) noexcept = delete;
+
+		Reactor(size_t id, const std::string& engineType);
+		~Reactor();
+
+		const size_t id;
+
+		/// Мютекс реестра подключений
+		std::recursive_mutex mutex;
+
+		/// Подключения, закрепленные за реактором
+		std::map<const Connection *, const std::shared_ptr<Connection>> connections;
+
+		/// Мютекс потребителя очереди готовых (владелец или забирающий работу сосед)
+		std::mutex consumerMutex;
+
+		/// Готовые подключения (имеющие необработанные события)
+		IntrusiveQueue readyConnections;
+
+		std::unique_ptr<EventEngine> engine;
+		epoll_event epev[poolSize];
+
+		/// Поставить соединение в очередь готовых, если оно еще не там и не в обработке
+		bool ready(const std::shared_ptr<Connection>& connection);
+
+		/// Извлечь и захватить готовое соединение (под consumerMutex)
+		std::shared_ptr<Connection> capture();
+	};
 
 	Log _log;
 
-	std::recursive_mutex _mutex;
+	/// Мютекс для изменения набора реакторов
+	std::mutex _mutex;
+
+	std::vector<std::unique_ptr<Reactor>> _reactors;
 
-	/// Мютекс для эксклюзивного ожидания событий
-	std::mutex _epool_mutex;
+	/// Тип механизма событий реакторов
+	std::string _engineType;
 
-	/// Реестр подключений
-	std::map<const Connection *, const std::shared_ptr<Connection>> _allConnections;
+	/// Счетчик для распределения подключений по реакторам
+	std::atomic_size_t _nextReactor;
 
-	/// Захваченные подключения
-	std::set<std::shared_ptr<Connection>> _capturedConnections;
+	/// Общее количество зарегистрированных подключений
+	std::atomic_size_t _connectionCount;
 
-	/// Готовые подключения (имеющие необработанные события)
-	std::set<std::shared_ptr<Connection>> _readyConnections;
+	/// Реактор, за которым закреплено соединение
+	Reactor& reactorOf(const std::shared_ptr<Connection>& connection);
 
-	int _epfd;
-	epoll_event _epev[poolSize];
+	/// Ожидать события на соединениях реактора
+	void wait(Reactor& reactor);
 
-	/// Ожидать события на соединениях
-	void wait();
+	/// Добавить соединению событие не от механизма событий (таймаут, простой)
+	void inject(const std::shared_ptr<Connection>& connection, ConnectionEvent::Type event);
+
+	/// Забрать готовое соединение у другого реактора
+	std::shared_ptr<Connection> steal(Reactor& thief);
 
 	/// Захватить соединение
-	std::shared_ptr<Connection> capture();
+	std::shared_ptr<Connection> capture(Reactor& reactor);
 
 	/// Освободить соединение
 	void release(const std::shared_ptr<Connection>& conn);
 
+	/// Обработка событий реактора
+	static void run(Reactor& reactor);
+
+	/// Обработать захваченное соединение и освободить его (если обработка не приостановлена)
+	static void process(const std::shared_ptr<Connection>& connection);
+
 public:
+	/// Задать количество реакторов (до регистрации первого соединения)
+	static void setReactorCount(size_t count);
+
+	/// Количество реакторов
+	static size_t reactorCount();
+
+	/// Выбрать механизм событий (epoll, io_uring). Недоступный io_uring заменяется на epoll
+	static void setEngine(const std::string& type);
+
+	/// Используемый механизм событий
+	static const std::string& engine();
+
+	/// Механизм событий реактора соединения (для приема и чтения силами ядра)
+	static EventEngine& engineOf(const std::shared_ptr<Connection>& connection);
+
 	/// Добавить соединение для наблюдения
 	static void watch(const std::shared_ptr<Connection>& connection);
 
@@ -89,9 +154,24 @@ public:
 	/// Зарегистрировать таймаут
 	static void timeout(const std::shared_ptr<Connection>& connection);
 
+	/// Зарегистрировать простой соединения (для возврата неиспользуемой памяти)
+	static void idle(const std::shared_ptr<Connection>& connection);
+
+	/// Общее количество зарегистрированных подключений
+	static size_t connectionCount();
+
+	/// Приостановить обработку: соединение остается захваченным после выхода из processing(),
+	/// события копятся до возобновления. Вызывается из processing().
+	/// continuation (передача работы исполнителю, который потом вызовет resume) запускается
+	/// уже после выхода из processing() - возобновление не может обогнать приостановку
+	static void suspend(const std::shared_ptr<Connection>& connection, std::function<void()>&& continuation);
+
+	/// Возобновить приостановленную обработку: processing() будет вызван снова рабочим потоком
+	static void resume(const std::shared_ptr<Connection>& connection);
+
 	/// Проверить и вернуть отложенные события
 	static uint32_t rotateEvents(const std::shared_ptr<Connection>& connection);
 
-	/// Обработка событий
+	/// Обработка событий (запуск реакторов)
 	static void dispatch();
 };
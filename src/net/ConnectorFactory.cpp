@@ -0,0 +1,100 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// ConnectorFactory.cpp
+
+
+#include "ConnectorFactory.hpp"
+
+#include "SslConnector.hpp"
+#include "UnixConnector.hpp"
+#include "../utils/SslHelper.hpp"
+
+std::shared_ptr<ConnectorFactory::Creator> ConnectorFactory::creator(const Setting& setting)
+{
+	// Локальный UNIX-сокет вместо TCP
+	if (setting.exists("path"))
+	{
+		return unixCreator(setting);
+	}
+
+	std::string host;
+	if (!setting.lookupValue("host", host) || host.empty())
+	{
+		throw std::runtime_error("Bad config or host undefined");
+	}
+
+	int port = 0;
+	setting.lookupValue("port", port);
+	if (port <= 0 || port > 0xFFFF)
+	{
+		throw std::runtime_error("Bad config: wrong or undefined port");
+	}
+
+	bool secure = false;
+	if (setting.exists("secure"))
+	{
+		setting.lookupValue("secure", secure);
+	}
+
+	if (secure)
+	{
+		return std::make_shared<Creator>(
+			[host = std::move(host), port](const std::shared_ptr<ClientTransport>& transport)
+			{
+				return std::make_shared<SslConnector>(transport, host, static_cast<uint16_t>(port), SslHelper::getClientContext());
+			}
+		);
+	}
+	else
+	{
+		return std::make_shared<Creator>(
+			[host = std::move(host), port](const std::shared_ptr<ClientTransport>& transport)
+			{
+				return std::make_shared<TcpConnector>(transport, host, static_cast<uint16_t>(port));
+			}
+		);
+	}
+}
+
+std::shared_ptr<ConnectorFactory::Creator> ConnectorFactory::unixCreator(const Setting& setting)
+{
+	std::string path;
+	setting.lookupValue("path", path);
+	if (path.empty())
+	{
+		throw std::runtime_error("Bad config: empty path");
+	}
+
+	bool secure = false;
+	if (setting.exists("secure"))
+	{
+		setting.lookupValue("secure", secure);
+	}
+	if (secure)
+	{
+		throw std::runtime_error("Bad config: secure isn't supported on unix socket");
+	}
+
+	return std::make_shared<Creator>(
+		[path = std::move(path)](const std::shared_ptr<ClientTransport>& transport)
+		{
+			return UnixConnector::create(transport, path);
+		}
+	);
+}
@@ -0,0 +1,49 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// ConnectorFactory.hpp
+
+
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include "../configs/Setting.hpp"
+
+class ClientTransport;
+class TcpConnector;
+
+/// Подключения к узлу, описанному в конфиге (как AcceptorFactory для слушающих сокетов)
+class ConnectorFactory final
+{
+public:
+	typedef std::function<std::shared_ptr<TcpConnector>(const std::shared_ptr<ClientTransport>&)> Creator;
+
+	ConnectorFactory() = delete;
+	ConnectorFactory(const ConnectorFactory&) = delete;
+	ConnectorFactory& operator=(const ConnectorFactory&) = delete;
+	ConnectorFactory(ConnectorFactory&&) noexcept = delete;
+	ConnectorFactory& operator=(ConnectorFactory&&) noexcept = delete;
+
+	/// Создатель подключений по host/port (secure - через TLS) или по path
+	static std::shared_ptr<ConnectorFactory::Creator> creator(const Setting& setting);
+
+	/// Создатель подключений к UNIX-сокету (в том числе в абстрактном пространстве имен)
+	static std::shared_ptr<ConnectorFactory::Creator> unixCreator(const Setting& setting);
+};
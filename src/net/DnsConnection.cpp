@@ -0,0 +1,102 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// DnsConnection.cpp
+
+
+#include "DnsConnection.hpp"
+
+#include <arpa/inet.h>
+#include <cstring>
+#include <sys/socket.h>
+#include "HostnameResolver.hpp"
+
+DnsConnection::DnsConnection(const sockaddr_in& server)
+: Connection(nullptr)
+, _server(server)
+{
+	// Создаем сокет (сразу неблокирующий)
+	_sock = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (_sock == -1)
+	{
+		throw std::runtime_error(std::string("Can't create socket ← ") + strerror(errno));
+	}
+
+	char ip[INET_ADDRSTRLEN];
+	inet_ntop(AF_INET, &_server.sin_addr, ip, sizeof(ip));
+
+	_name = "DnsConnection[" + std::to_string(_sock) + "][" + ip + ":" + std::to_string(ntohs(_server.sin_port)) + "]";
+
+	// Связанный сокет принимает датаграммы только от своего сервера
+	if (connect(_sock, reinterpret_cast<const sockaddr*>(&_server), sizeof(_server)) != 0)
+	{
+		throw std::runtime_error(std::string("Can't connect socket ← ") + strerror(errno));
+	}
+
+	_closed = false;
+}
+
+void DnsConnection::watch(epoll_event& ev)
+{
+	ev.data.ptr = this;
+	ev.events = 0;
+
+	ev.events |= EPOLLET; // Ждем появления НОВЫХ событий
+
+	ev.events |= EPOLLERR;
+	ev.events |= EPOLLIN;
+}
+
+bool DnsConnection::processing()
+{
+	// Вычитываем все пришедшие ответы
+	for (;;)
+	{
+		char packet[4096];
+
+		auto n = ::recv(_sock, packet, sizeof(packet), 0);
+		if (n == -1)
+		{
+			// Вызов прерван сигналом - повторяем
+			if (errno == EINTR)
+			{
+				continue;
+			}
+
+			// Ошибка от ICMP (сервер недоступен) - запросы переотправятся по таймауту
+			if (errno == ECONNREFUSED)
+			{
+				_log.debug("Name server unreachable on %s", name().c_str());
+				continue;
+			}
+
+			break;
+		}
+
+		HostnameResolver::onResponse(this, packet, static_cast<size_t>(n));
+	}
+
+	return true;
+}
+
+void DnsConnection::send(const std::string& packet)
+{
+	while (::send(_sock, packet.data(), packet.size(), 0) == -1 && errno == EINTR)
+	{
+	}
+}
@@ -0,0 +1,49 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// DnsConnection.hpp
+
+
+#pragma once
+
+#include <netinet/in.h>
+#include "Connection.hpp"
+
+/// UDP-сокет одного запроса к серверу имен (порт выбирает ядро). Ответы передаются резолверу
+class DnsConnection final : public Connection
+{
+private:
+	sockaddr_in _server;
+
+public:
+	DnsConnection() = delete;
+	DnsConnection(const DnsConnection&) = delete;
+	DnsConnection& operator=(const DnsConnection&) = delete;
+	DnsConnection(DnsConnection&& tmp) noexcept = delete;
+	DnsConnection& operator=(DnsConnection&& tmp) noexcept = delete;
+
+	explicit DnsConnection(const sockaddr_in& server);
+	~DnsConnection() override = default;
+
+	void watch(epoll_event& ev) override;
+
+	bool processing() override;
+
+	/// Отправить запрос (без ожидания: при переполнении буфера сокета запрос будет переотправлен по таймауту)
+	void send(const std::string& packet);
+};
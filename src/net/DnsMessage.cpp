@@ -0,0 +1,236 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// DnsMessage.cpp
+
+
+#include "DnsMessage.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+/// Размер заголовка сообщения
+static const size_t headerSize = 12;
+
+static inline uint16_t get16(const uint8_t* p)
+{
+	return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+static inline uint32_t get32(const uint8_t* p)
+{
+	return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) | (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+static inline void put16(std::string& out, uint16_t value)
+{
+	out.push_back(static_cast<char>(value >> 8));
+	out.push_back(static_cast<char>(value & 0xFF));
+}
+
+std::string DnsMessage::query(uint16_t id, const std::string& name, Type type)
+{
+	std::string out;
+	out.reserve(headerSize + name.size() + 6);
+
+	put16(out, id);
+	put16(out, 0x0100); // RD - просим рекурсию
+	put16(out, 1);      // QDCOUNT
+	put16(out, 0);      // ANCOUNT
+	put16(out, 0);      // NSCOUNT
+	put16(out, 0);      // ARCOUNT
+
+	// Имя - последовательность меток с длиной впереди
+	size_t begin = 0;
+	while (begin < name.size())
+	{
+		auto end = name.find('.', begin);
+		if (end == std::string::npos)
+		{
+			end = name.size();
+		}
+		auto length = end - begin;
+		if (length == 0 || length > 63)
+		{
+			break;
+		}
+		out.push_back(static_cast<char>(length));
+		out.append(name, begin, length);
+		begin = end + 1;
+	}
+	out.push_back('\0');
+
+	put16(out, type);
+	put16(out, 1); // IN
+
+	return out;
+}
+
+/// Прочитать имя (со сжатием ссылками) начиная с pos. Возвращает позицию за именем или 0 при ошибке
+static size_t readName(const uint8_t* data, size_t length, size_t pos, std::string* name)
+{
+	size_t next = 0;
+	size_t jumps = 0;
+
+	for (;;)
+	{
+		if (pos >= length)
+		{
+			return 0;
+		}
+
+		auto label = data[pos];
+
+		// Ссылка на имя выше по сообщению
+		if ((label & 0xC0) == 0xC0)
+		{
+			if (pos + 1 >= length || ++jumps > 16)
+			{
+				return 0;
+			}
+			if (next == 0)
+			{
+				next = pos + 2;
+			}
+			pos = static_cast<size_t>(get16(data + pos) & 0x3FFF);
+			continue;
+		}
+
+		if (label & 0xC0)
+		{
+			return 0;
+		}
+
+		++pos;
+
+		if (label == 0)
+		{
+			return next ? next : pos;
+		}
+
+		if (pos + label > length)
+		{
+			return 0;
+		}
+
+		if (name)
+		{
+			if (!name->empty())
+			{
+				name->push_back('.');
+			}
+			for (size_t i = 0; i < label; ++i)
+			{
+				name->push_back(static_cast<char>(tolower(data[pos + i])));
+			}
+		}
+
+		pos += label;
+	}
+}
+
+bool DnsMessage::parse(const char* data_, size_t length, Answer& answer)
+{
+	auto data = reinterpret_cast<const uint8_t*>(data_);
+
+	if (length < headerSize)
+	{
+		return false;
+	}
+
+	answer.id = get16(data);
+
+	auto flags = get16(data + 2);
+
+	// Это должен быть ответ
+	if (!(flags & 0x8000))
+	{
+		return false;
+	}
+
+	answer.truncated = (flags & 0x0200) != 0;
+	answer.rcode = static_cast<uint8_t>(flags & 0x000F);
+
+	auto qdcount = get16(data + 4);
+	auto ancount = get16(data + 6);
+	auto nscount = get16(data + 8);
+
+	if (qdcount != 1)
+	{
+		return false;
+	}
+
+	size_t pos = headerSize;
+
+	pos = readName(data, length, pos, &answer.name);
+	if (pos == 0 || pos + 4 > length)
+	{
+		return false;
+	}
+	answer.type = get16(data + pos);
+	pos += 4;
+
+	bool ttlSet = false;
+
+	for (size_t i = 0; i < static_cast<size_t>(ancount) + nscount; ++i)
+	{
+		pos = readName(data, length, pos, nullptr);
+		if (pos == 0 || pos + 10 > length)
+		{
+			return false;
+		}
+
+		auto type = get16(data + pos);
+		auto ttl = get32(data + pos + 4);
+		auto rdlength = get16(data + pos + 8);
+		pos += 10;
+
+		if (pos + rdlength > length)
+		{
+			return false;
+		}
+
+		if (i < ancount)
+		{
+			// CNAME пропускаем: рекурсивный сервер кладет конечные адреса в тот же ответ
+			if (type == answer.type && ((type == A && rdlength == 4) || (type == AAAA && rdlength == 16)))
+			{
+				answer.addresses.emplace_back(reinterpret_cast<const char*>(data + pos), rdlength);
+			}
+			if (type == answer.type || type == CNAME)
+			{
+				answer.ttl = ttlSet ? std::min(answer.ttl, ttl) : ttl;
+				ttlSet = true;
+			}
+		}
+		else if (type == SOA)
+		{
+			// Отрицательный TTL - меньшее из TTL записи и поля MINIMUM (RFC 2308)
+			auto end = readName(data, length, pos, nullptr);
+			end = end ? readName(data, length, end, nullptr) : 0;
+			if (end && end + 20 <= pos + rdlength)
+			{
+				answer.negativeTtl = std::min(ttl, get32(data + end + 16));
+			}
+		}
+
+		pos += rdlength;
+	}
+
+	return true;
+}
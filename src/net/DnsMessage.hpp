@@ -0,0 +1,79 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// DnsMessage.hpp
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// Сборка запросов и разбор ответов DNS (RFC 1035) - ровно то, что нужно для A/AAAA
+class DnsMessage final
+{
+public:
+	enum Type : uint16_t
+	{
+		A		= 1,
+		CNAME	= 5,
+		SOA		= 6,
+		AAAA	= 28
+	};
+
+	enum Rcode : uint8_t
+	{
+		NOERROR		= 0,
+		FORMERR		= 1,
+		SERVFAIL	= 2,
+		NXDOMAIN	= 3,
+		NOTIMP		= 4,
+		REFUSED		= 5
+	};
+
+	/// Разобранный ответ
+	struct Answer final
+	{
+		uint16_t id = 0;
+		uint8_t rcode = 0;
+		bool truncated = false;
+
+		/// Имя и тип из секции вопроса (сверяются с отправленным запросом)
+		std::string name;
+		uint16_t type = 0;
+
+		/// Адреса в сетевом порядке байт (4 байта для A, 16 для AAAA)
+		std::vector<std::string> addresses;
+
+		/// Наименьший TTL записей ответа
+		uint32_t ttl = 0;
+
+		/// TTL отрицательного ответа из SOA секции полномочий (0 - не указан)
+		uint32_t negativeTtl = 0;
+	};
+
+	DnsMessage() = delete;
+
+	/// Запрос с рекурсией
+	static std::string query(uint16_t id, const std::string& name, Type type);
+
+	/// Разобрать ответ. Возвращает false для искаженного сообщения
+	static bool parse(const char* data, size_t length, Answer& answer);
+};
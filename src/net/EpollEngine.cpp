@@ -0,0 +1,68 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// EpollEngine.cpp
+
+
+#include "EpollEngine.hpp"
+
+#include <cstring>
+#include <stdexcept>
+#include <unistd.h>
+
+EpollEngine::EpollEngine(int poolSize)
+{
+	_epfd = epoll_create(poolSize);
+	if (_epfd == -1)
+	{
+		throw std::runtime_error(std::string("Can't create epoll ← ") + strerror(errno));
+	}
+}
+
+EpollEngine::~EpollEngine()
+{
+	close(_epfd);
+	_epfd = -1;
+}
+
+bool EpollEngine::add(int fd, const epoll_event& ev)
+{
+	epoll_event tmp = ev;
+	tmp.events &= ~KERNEL_MASK;
+	++_syscalls;
+	return epoll_ctl(_epfd, EPOLL_CTL_ADD, fd, &tmp) != -1;
+}
+
+bool EpollEngine::modify(int fd, const epoll_event& ev)
+{
+	epoll_event tmp = ev;
+	tmp.events &= ~KERNEL_MASK;
+	++_syscalls;
+	return epoll_ctl(_epfd, EPOLL_CTL_MOD, fd, &tmp) != -1;
+}
+
+bool EpollEngine::remove(int fd, void*)
+{
+	++_syscalls;
+	return epoll_ctl(_epfd, EPOLL_CTL_DEL, fd, nullptr) != -1;
+}
+
+int EpollEngine::wait(epoll_event* events, int maxEvents, int timeoutMs)
+{
+	return epoll_wait(_epfd, events, maxEvents, timeoutMs);
+}
@@ -0,0 +1,50 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// EpollEngine.hpp
+
+
+#pragma once
+
+#include "EventEngine.hpp"
+
+class EpollEngine final: public EventEngine
+{
+private:
+	int _epfd;
+
+public:
+	EpollEngine() = delete;
+	EpollEngine(const EpollEngine&) = delete;
+	EpollEngine& operator=(const EpollEngine&) = delete;
+	EpollEngine(EpollEngine&&) noexcept = delete;
+	EpollEngine& operator=(EpollEngine&&) noexcept = delete;
+
+	explicit EpollEngine(int poolSize);
+	~EpollEngine() override;
+
+	const char* name() const override
+	{
+		return "epoll";
+	}
+
+	bool add(int fd, const epoll_event& ev) override;
+	bool modify(int fd, const epoll_event& ev) override;
+	bool remove(int fd, void* ptr) override;
+	int wait(epoll_event* events, int maxEvents, int timeoutMs) override;
+};
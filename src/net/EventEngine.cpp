@@ -0,0 +1,41 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// EventEngine.cpp
+
+
+#include "EventEngine.hpp"
+
+#include <stdexcept>
+#include "EpollEngine.hpp"
+#include "UringEngine.hpp"
+
+thread_local size_t EventEngine::_syscalls = 0;
+
+std::unique_ptr<EventEngine> EventEngine::create(const std::string& type, int poolSize)
+{
+	if (type.empty() || type == "epoll")
+	{
+		return std::unique_ptr<EventEngine>(new EpollEngine(poolSize));
+	}
+	if (type == "io_uring")
+	{
+		return std::unique_ptr<EventEngine>(new UringEngine(poolSize));
+	}
+	throw std::runtime_error("Unknown event engine type '" + type + "'");
+}
@@ -0,0 +1,93 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// EventEngine.hpp
+
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <sys/epoll.h>
+
+class Buffer;
+
+/// Механизм ожидания событий на дескрипторах (бэкенд реактора)
+class EventEngine
+{
+public:
+	EventEngine(const EventEngine&) = delete;
+	EventEngine& operator=(const EventEngine&) = delete;
+	EventEngine(EventEngine&&) noexcept = delete;
+	EventEngine& operator=(EventEngine&&) noexcept = delete;
+
+	EventEngine() = default;
+	virtual ~EventEngine() = default;
+
+	/// Запросы к механизму в маске epoll_event.events (epoll их не знает - снимаются перед epoll_ctl).
+	/// Принимать подключения на слушающем сокете силами механизма
+	static const uint32_t KERNEL_ACCEPT = 1u << 24;
+	/// Читать данные из сокета силами механизма
+	static const uint32_t KERNEL_RECV = 1u << 25;
+	static const uint32_t KERNEL_MASK = KERNEL_ACCEPT | KERNEL_RECV;
+
+	/// Имя механизма (значение опции core.engine)
+	virtual const char* name() const = 0;
+
+	/// Начать наблюдение за дескриптором (маска и data.ptr - как для epoll)
+	virtual bool add(int fd, const epoll_event& ev) = 0;
+
+	/// Изменить наблюдение за дескриптором
+	virtual bool modify(int fd, const epoll_event& ev) = 0;
+
+	/// Прекратить наблюдение за дескриптором
+	virtual bool remove(int fd, void* ptr) = 0;
+
+	/// Ожидать события. Возвращает количество событий, при ошибке -1 (см. errno)
+	virtual int wait(epoll_event* events, int maxEvents, int timeoutMs) = 0;
+
+	/// Забрать подключения, принятые механизмом (KERNEL_ACCEPT).
+	/// false - механизм подключения не принимает, принимать самому. error - ошибка приема (errno, 0 - нет ошибки):
+	/// прием после нее остановлен до следующего modify() с KERNEL_ACCEPT
+	virtual bool accepted(void* ptr, std::vector<int>& socks, int& error)
+	{
+		return false;
+	}
+
+	/// Дописать в buffer данные, прочитанные механизмом (KERNEL_RECV).
+	/// false - механизм не читает, читать из сокета самому. eof - данных больше не будет,
+	/// error - ошибка чтения (errno, 0 - нет ошибки)
+	virtual bool received(void* ptr, Buffer& buffer, bool& eof, int& error)
+	{
+		return false;
+	}
+
+	/// Системные вызовы, сделанные механизмом в текущем потоке из add/modify/remove
+	/// (разность показаний до и после вызова относится к соединению)
+	static size_t syscalls()
+	{
+		return _syscalls;
+	}
+
+	/// Создать механизм указанного типа. Бросает исключение, если он недоступен
+	static std::unique_ptr<EventEngine> create(const std::string& type, int poolSize);
+
+protected:
+	static thread_local size_t _syscalls;
+};
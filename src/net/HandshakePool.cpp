@@ -0,0 +1,144 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// HandshakePool.cpp
+
+
+#include "HandshakePool.hpp"
+
+#include <pthread.h>
+#include "../telemetry/TelemetryManager.hpp"
+
+HandshakePool::HandshakePool()
+: _log("HandshakePool")
+, _stop(false)
+, _queueLimit(0)
+{
+	_metricQueueDepth = TelemetryManager::metric("tls/handshake_queue", 1);
+	_metricRejects = TelemetryManager::metric("tls/handshake_rejects", std::chrono::seconds(60));
+}
+
+HandshakePool::~HandshakePool()
+{
+	{
+		std::lock_guard<std::mutex> lockGuard(_mutex);
+		_stop = true;
+	}
+	_condition.notify_all();
+
+	for (auto& thread : _threads)
+	{
+		thread.join();
+	}
+}
+
+void HandshakePool::start(size_t threads, size_t queueLimit)
+{
+	auto& instance = getInstance();
+
+	std::lock_guard<std::mutex> lockGuard(instance._mutex);
+
+	if (!instance._threads.empty())
+	{
+		throw std::runtime_error("Handshake pool already started");
+	}
+
+	instance._queueLimit = queueLimit;
+
+	for (size_t i = 0; i < threads; ++i)
+	{
+		instance._threads.emplace_back([&instance]{ instance.run(); });
+		pthread_setname_np(instance._threads.back().native_handle(), "handshake");
+	}
+
+	instance._log.debug("Start %zu thread(s)", threads);
+}
+
+bool HandshakePool::enabled()
+{
+	return !getInstance()._threads.empty();
+}
+
+bool HandshakePool::saturated()
+{
+	auto& instance = getInstance();
+
+	if (instance._queueLimit == 0 || instance._threads.empty())
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lockGuard(instance._mutex);
+
+	return instance._queue.size() >= instance._queueLimit;
+}
+
+void HandshakePool::reject()
+{
+	getInstance()._metricRejects->addValue();
+}
+
+void HandshakePool::enqueue(std::function<void()>&& step)
+{
+	auto& instance = getInstance();
+
+	size_t depth;
+	{
+		std::lock_guard<std::mutex> lockGuard(instance._mutex);
+
+		instance._queue.emplace_back(std::move(step));
+		depth = instance._queue.size();
+	}
+	instance._condition.notify_one();
+
+	instance._metricQueueDepth->setValue(depth);
+}
+
+void HandshakePool::run()
+{
+	for (;;)
+	{
+		std::function<void()> step;
+		size_t depth;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+
+			_condition.wait(lock, [this]{ return _stop || !_queue.empty(); });
+
+			if (_stop)
+			{
+				return;
+			}
+
+			step = std::move(_queue.front());
+			_queue.pop_front();
+			depth = _queue.size();
+		}
+
+		_metricQueueDepth->setValue(depth);
+
+		try
+		{
+			step();
+		}
+		catch (const std::exception& exception)
+		{
+			_log.warn("Uncatched exception at handshake: %s", exception.what());
+		}
+	}
+}
@@ -0,0 +1,83 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// HandshakePool.hpp
+
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "../log/Log.hpp"
+#include "../telemetry/Metric.hpp"
+
+/// Отдельный пул потоков для шагов TLS-рукопожатия: тяжелая асимметричная криптография
+/// не занимает рабочие потоки, обрабатывающие запросы
+class HandshakePool final
+{
+public:
+	HandshakePool(const HandshakePool&) = delete;
+	HandshakePool& operator=(const HandshakePool&) = delete;
+	HandshakePool(HandshakePool&&) noexcept = delete;
+	HandshakePool& operator=(HandshakePool&&) noexcept = delete;
+
+private:
+	HandshakePool();
+	~HandshakePool();
+
+	static HandshakePool& getInstance()
+	{
+		static HandshakePool instance;
+		return instance;
+	}
+
+	Log _log;
+
+	std::mutex _mutex;
+	std::condition_variable _condition;
+	std::deque<std::function<void()>> _queue;
+	std::vector<std::thread> _threads;
+	bool _stop;
+
+	/// Длина очереди, при которой новые подключения отклоняются
+	size_t _queueLimit;
+
+	std::shared_ptr<Metric> _metricQueueDepth;
+	std::shared_ptr<Metric> _metricRejects;
+
+	void run();
+
+public:
+	/// Запустить пул (0 потоков - рукопожатия выполняются рабочими потоками)
+	static void start(size_t threads, size_t queueLimit);
+
+	static bool enabled();
+
+	/// Очередь переполнена: новые TLS-подключения принимать не следует
+	static bool saturated();
+
+	/// Учесть отклоненное подключение
+	static void reject();
+
+	static void enqueue(std::function<void()>&& step);
+};
@@ -19,70 +19,488 @@
 // HostnameResolver.cpp
 
 
-#include <netdb.h>
+#include "HostnameResolver.hpp"
+
 #include <algorithm>
-#include <stdexcept>
-#include <tuple>
+#include <arpa/inet.h>
 #include <cstring>
-#include <mutex>
-#include "HostnameResolver.hpp"
+#include <fstream>
+#include <netdb.h>
+#include <sstream>
+#include "ConnectionManager.hpp"
+#include "DnsConnection.hpp"
 #include "../log/Log.hpp"
+#include "../utils/Random.hpp"
+#include "../utils/Timer.hpp"
+
+/// Ожидание ответа на одну попытку и число попыток (серверы перебираются по кругу)
+static const std::chrono::milliseconds attemptTimeout(1000);
+static const size_t attemptCount = 3;
+
+/// Период проверки просроченных запросов
+static const std::chrono::milliseconds tickPeriod(100);
+
+/// Границы TTL положительного ответа
+static const std::chrono::seconds minTtl(5);
+static const std::chrono::seconds maxTtl(3600);
+
+/// TTL отрицательного ответа (если сервер не указал свой) и его предел
+static const std::chrono::seconds negativeTtl(30);
+static const std::chrono::seconds maxNegativeTtl(300);
+
+/// TTL временной ошибки (сервер не ответил или отказал)
+static const std::chrono::seconds failureTtl(5);
+
+/// Размер кеша, после которого из него вычищаются истекшие записи
+static const size_t cacheCleanupSize = 10000;
+
+HostnameResolver::HostnameResolver()
+{
+	loadHosts();
+	loadServers();
+
+	_timer = std::make_shared<Timer>([]{ getInstance().tick(); }, "HostnameResolver::tick");
+}
+
+void HostnameResolver::loadHosts()
+{
+	std::ifstream file("/etc/hosts");
+	std::string line;
+	while (std::getline(file, line))
+	{
+		line = line.substr(0, line.find('#'));
+
+		std::istringstream iss(line);
+		std::string address;
+		if (!(iss >> address))
+		{
+			continue;
+		}
+
+		char raw[sizeof(in6_addr)];
+		size_t size;
+		if (inet_pton(AF_INET, address.c_str(), raw) == 1)
+		{
+			size = sizeof(in_addr);
+		}
+		else if (inet_pton(AF_INET6, address.c_str(), raw) == 1)
+		{
+			size = sizeof(in6_addr);
+		}
+		else
+		{
+			continue;
+		}
+
+		std::string name;
+		while (iss >> name)
+		{
+			std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+			_hosts.emplace(name, std::string(raw, size));
+		}
+	}
+}
+
+void HostnameResolver::loadServers()
+{
+	std::ifstream file("/etc/resolv.conf");
+	std::string line;
+	while (std::getline(file, line))
+	{
+		std::istringstream iss(line);
+		std::string keyword;
+		std::string address;
+		if (!(iss >> keyword >> address) || keyword != "nameserver")
+		{
+			continue;
+		}
+
+		sockaddr_in server{};
+		server.sin_family = AF_INET;
+		server.sin_port = htons(53);
+		if (inet_pton(AF_INET, address.c_str(), &server.sin_addr) == 1)
+		{
+			_servers.push_back(server);
+		}
+	}
 
-std::tuple<int, std::vector<in_addr>> HostnameResolver::resolve(std::string host)
+	// Как и libc: без указанных серверов обращаемся к локальному
+	if (_servers.empty())
+	{
+		sockaddr_in server{};
+		server.sin_family = AF_INET;
+		server.sin_port = htons(53);
+		server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		_servers.push_back(server);
+	}
+}
+
+bool HostnameResolver::find(std::string host, DnsMessage::Type type, int& herr, std::vector<std::string>& addresses, RawHandler* handler)
 {
 	std::transform(host.begin(), host.end(), host.begin(), ::tolower);
+	if (!host.empty() && host.back() == '.')
+	{
+		host.pop_back();
+	}
+
+	herr = 0;
+	addresses.clear();
+
+	// Числовой адрес
+	char raw[sizeof(in6_addr)];
+	if (type == DnsMessage::A && inet_pton(AF_INET, host.c_str(), raw) == 1)
+	{
+		addresses.emplace_back(raw, sizeof(in_addr));
+		return true;
+	}
+	if (type == DnsMessage::AAAA && inet_pton(AF_INET6, host.c_str(), raw) == 1)
+	{
+		addresses.emplace_back(raw, sizeof(in6_addr));
+		return true;
+	}
+
+	// Статические записи
+	auto size = type == DnsMessage::A ? sizeof(in_addr) : sizeof(in6_addr);
+	auto range = _hosts.equal_range(host);
+	for (auto i = range.first; i != range.second; ++i)
+	{
+		if (i->second.size() == size)
+		{
+			addresses.push_back(i->second);
+		}
+	}
+	if (!addresses.empty())
+	{
+		return true;
+	}
+
+	if (host.empty())
+	{
+		herr = HOST_NOT_FOUND;
+		return true;
+	}
+
+	auto key = (type == DnsMessage::A ? "A " : "AAAA ") + host;
+
+	std::lock_guard<std::mutex> lockGuard(_mutex);
+
+	auto now = std::chrono::steady_clock::now();
+
+	auto i = _cache.find(key);
+	if (i != _cache.end() && i->second.resolved && now < i->second.expires)
+	{
+		auto& entry = i->second;
+
+		herr = entry.herr;
+		addresses = entry.addresses;
+
+		// Запись скоро истечет - обновляем заранее, чтобы ее потребители не ждали сервер
+		if (now >= entry.refreshAt && !entry.pending)
+		{
+			startQuery(key, host, type);
+		}
+		return true;
+	}
 
+	// Только проверка кеша - пустую запись не заводим
+	if (handler == nullptr)
+	{
+		return false;
+	}
+
+	auto& entry = i != _cache.end() ? i->second : _cache[key];
+
+	entry.waiters.emplace_back(std::move(*handler));
+
+	if (!entry.pending)
+	{
+		startQuery(key, host, type);
+	}
+	return false;
+}
+
+void HostnameResolver::startQuery(const std::string& key, const std::string& name, DnsMessage::Type type)
+{
+	if (_cache.size() > cacheCleanupSize)
 	{
-		std::lock_guard<std::mutex> lockGuard(getInstance()._mutex);
-		auto i = getInstance()._cache.find(host);
-		if (i != getInstance()._cache.end() && std::get<2>(i->second) > time(nullptr))
+		auto now = std::chrono::steady_clock::now();
+		for (auto i = _cache.begin(); i != _cache.end(); )
 		{
-//			Log("HostnameResolver").info("Resolve for '%s' - get from cache", host.c_str());
-			return std::make_tuple(std::get<0>(i->second), std::get<1>(i->second));
+			if (!i->second.pending && i->second.waiters.empty() && i->second.expires < now && i->first != key)
+			{
+				i = _cache.erase(i);
+			}
+			else
+			{
+				++i;
+			}
 		}
 	}
 
-	std::vector<char> _buff(1024, 0);
+	uint16_t id;
+	do
+	{
+		id = Random::generate<uint16_t>(0, 0xFFFF);
+	}
+	while (_queries.find(id) != _queries.end());
+
+	auto& query = _queries[id];
+	query.key = key;
+	query.name = name;
+	query.type = type;
+	query.packet = DnsMessage::query(id, name, type);
+	query.attempt = 0;
+	query.deadline = std::chrono::steady_clock::now() + attemptTimeout;
+
+	_cache[key].pending = true;
+
+	sendQuery(query);
+
+	_timer->startOnce(tickPeriod);
+}
+
+void HostnameResolver::sendQuery(Query& query)
+{
+	// Каждая попытка - с нового сокета: без известного исходного порта ответ не подделать,
+	// угадав лишь идентификатор запроса
+	std::shared_ptr<DnsConnection> connection;
+	try
+	{
+		connection = std::make_shared<DnsConnection>(_servers[query.attempt % _servers.size()]);
+	}
+	catch (const std::exception& exception)
+	{
+		// Попытка пропадает - следующая будет по таймауту
+		Log("HostnameResolver").warn("Can't open connection to name server ← %s", exception.what());
+		return;
+	}
+
+	ConnectionManager::add(connection);
+	connection->send(query.packet);
+
+	query.connections.emplace_back(std::move(connection));
+}
+
+void HostnameResolver::closeQuery(Query& query)
+{
+	for (auto& connection : query.connections)
+	{
+		ConnectionManager::remove(connection);
+	}
+	query.connections.clear();
+}
 
-	int herr = 0;
-	hostent _hostbuf{};
-	hostent* _hostptr;
+std::vector<HostnameResolver::RawHandler> HostnameResolver::complete(const std::string& key, int herr, std::vector<std::string>&& addresses, std::chrono::seconds ttl)
+{
+	auto& entry = _cache[key];
+
+	entry.pending = false;
+
+	auto now = std::chrono::steady_clock::now();
+
+	// Сбой фонового обновления не портит еще действующий ответ
+	if (!(herr == TRY_AGAIN && entry.resolved && entry.herr == 0 && now < entry.expires))
+	{
+		entry.herr = herr;
+		entry.addresses = std::move(addresses);
+		entry.resolved = true;
+		entry.expires = now + ttl;
+
+		// Обновление заранее - за десятую часть срока до истечения
+		entry.refreshAt = ttl >= std::chrono::seconds(10) ? now + ttl - ttl / 10 : entry.expires;
+	}
+
+	return std::move(entry.waiters);
+}
+
+void HostnameResolver::onResponse(const DnsConnection* connection, const char* data, size_t length)
+{
+	auto& instance = getInstance();
 
-	// Список адресов по хосту
-	while (gethostbyname_r(host.c_str(), &_hostbuf, _buff.data(), _buff.size(), &_hostptr, &herr) == ERANGE)
+	DnsMessage::Answer answer;
+	if (!DnsMessage::parse(data, length, answer))
 	{
-		try
+		return;
+	}
+
+	std::vector<RawHandler> waiters;
+	int herr;
+	std::vector<std::string> addresses;
+	{
+		std::lock_guard<std::mutex> lockGuard(instance._mutex);
+
+		// Ответ должен относиться к запросу, который мы ждем, и прийти на сокет одной из его попыток
+		auto i = instance._queries.find(answer.id);
+		if (i == instance._queries.end() || i->second.name != answer.name || i->second.type != answer.type)
+		{
+			return;
+		}
+		auto& connections = i->second.connections;
+		if (std::none_of(connections.begin(), connections.end(),
+			[connection](const std::shared_ptr<DnsConnection>& item)
+			{
+				return item.get() == connection;
+			}
+		))
+		{
+			return;
+		}
+
+		auto key = std::move(i->second.key);
+		instance.closeQuery(i->second);
+		instance._queries.erase(i);
+
+		std::chrono::seconds ttl;
+
+		if (answer.rcode == DnsMessage::NOERROR && !answer.addresses.empty())
+		{
+			herr = 0;
+			ttl = std::min(std::max(std::chrono::seconds(answer.ttl), minTtl), maxTtl);
+		}
+		else if (answer.rcode == DnsMessage::NOERROR && answer.truncated)
 		{
-			_buff.resize(_buff.size() << 1);
+			// Адреса не поместились в датаграмму
+			herr = TRY_AGAIN;
+			ttl = failureTtl;
 		}
-		catch (const std::bad_alloc& )
+		else if (answer.rcode == DnsMessage::NOERROR || answer.rcode == DnsMessage::NXDOMAIN)
 		{
-			_buff.resize(_buff.size() + 64);
+			herr = answer.rcode == DnsMessage::NXDOMAIN ? HOST_NOT_FOUND : NO_ADDRESS;
+			ttl = answer.negativeTtl ? std::min(std::chrono::seconds(answer.negativeTtl), maxNegativeTtl) : negativeTtl;
 		}
+		else if (answer.rcode == DnsMessage::SERVFAIL)
+		{
+			herr = TRY_AGAIN;
+			ttl = failureTtl;
+		}
+		else
+		{
+			herr = NO_RECOVERY;
+			ttl = failureTtl;
+		}
+
+		waiters = instance.complete(key, herr, std::move(answer.addresses), ttl);
+
+		auto& entry = instance._cache[key];
+		herr = entry.herr;
+		addresses = entry.addresses;
 	}
 
-	std::vector<in_addr> addrs;
+	for (auto& waiter : waiters)
+	{
+		waiter(herr, addresses);
+	}
+}
 
-	if (_hostptr != nullptr)
+void HostnameResolver::tick()
+{
+	std::vector<std::pair<std::vector<RawHandler>, int>> failed;
+	std::vector<std::vector<std::string>> results;
 	{
-		for (auto i = _hostptr->h_addr_list; *i; ++i)
+		std::lock_guard<std::mutex> lockGuard(_mutex);
+
+		auto now = std::chrono::steady_clock::now();
+
+		for (auto i = _queries.begin(); i != _queries.end(); )
+		{
+			auto& query = i->second;
+			if (query.deadline > now)
+			{
+				++i;
+				continue;
+			}
+
+			// Повторяем, переходя к следующему серверу
+			if (++query.attempt < attemptCount * _servers.size())
+			{
+				query.deadline = now + attemptTimeout;
+				sendQuery(query);
+				++i;
+				continue;
+			}
+
+			auto key = std::move(query.key);
+			closeQuery(query);
+			i = _queries.erase(i);
+
+			auto waiters = complete(key, TRY_AGAIN, {}, failureTtl);
+			if (!waiters.empty())
+			{
+				auto& entry = _cache[key];
+				failed.emplace_back(std::move(waiters), entry.herr);
+				results.emplace_back(entry.addresses);
+			}
+		}
+
+		if (!_queries.empty())
 		{
-			in_addr addr;
-			memcpy(&addr, *i, sizeof(addr));
-			addrs.push_back(addr);
+			_timer->startOnce(tickPeriod);
 		}
 	}
 
+	for (size_t i = 0; i < failed.size(); ++i)
 	{
-		std::lock_guard<std::mutex> lockGuard(getInstance()._mutex);
-		auto i = getInstance()._cache.find(host);
-		if (i != getInstance()._cache.end())
+		for (auto& waiter : failed[i].first)
 		{
-			getInstance()._cache.erase(i);
+			waiter(failed[i].second, results[i]);
 		}
-		getInstance()._cache.emplace(host, std::make_tuple(herr, addrs, time(nullptr) + 3600));
 	}
+}
+
+void HostnameResolver::resolve(const std::string& host, Handler handler)
+{
+	RawHandler raw =
+		[handler](int herr, const std::vector<std::string>& addresses)
+		{
+			std::vector<in_addr> result(addresses.size());
+			for (size_t i = 0; i < addresses.size(); ++i)
+			{
+				memcpy(&result[i], addresses[i].data(), sizeof(in_addr));
+			}
+			handler(herr, result);
+		};
+
+	int herr;
+	std::vector<std::string> addresses;
+	if (getInstance().find(host, DnsMessage::A, herr, addresses, &raw))
+	{
+		raw(herr, addresses);
+	}
+}
+
+void HostnameResolver::resolve6(const std::string& host, Handler6 handler)
+{
+	RawHandler raw =
+		[handler](int herr, const std::vector<std::string>& addresses)
+		{
+			std::vector<in6_addr> result(addresses.size());
+			for (size_t i = 0; i < addresses.size(); ++i)
+			{
+				memcpy(&result[i], addresses[i].data(), sizeof(in6_addr));
+			}
+			handler(herr, result);
+		};
 
-//	Log("HostnameResolver").info("Resolve for '%s' - renew in cache", host.c_str());
-	return std::make_tuple(herr, std::move(addrs));
+	int herr;
+	std::vector<std::string> addresses;
+	if (getInstance().find(host, DnsMessage::AAAA, herr, addresses, &raw))
+	{
+		raw(herr, addresses);
+	}
+}
+
+bool HostnameResolver::cached(const std::string& host, int& herr, std::vector<in_addr>& addresses)
+{
+	std::vector<std::string> raw;
+	if (!getInstance().find(host, DnsMessage::A, herr, raw, nullptr))
+	{
+		return false;
+	}
+
+	addresses.resize(raw.size());
+	for (size_t i = 0; i < raw.size(); ++i)
+	{
+		memcpy(&addresses[i], raw[i].data(), sizeof(in_addr));
+	}
+	return true;
 }
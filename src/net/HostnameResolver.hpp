@@ -21,31 +21,115 @@
 
 #pragma once
 
-#include <string>
+#include <chrono>
+#include <functional>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <netinet/in.h>
+#include <string>
 #include <vector>
+#include "DnsMessage.hpp"
 
-class HostnameResolver
+class DnsConnection;
+class Timer;
+
+/// Асинхронное разрешение имен: числовые адреса, /etc/hosts, кеш с учетом TTL записей
+/// и запросы по UDP к серверам из /etc/resolv.conf через менеджер соединений.
+/// Обработчик вызывается сразу (ответ уже известен) или из потока, получившего ответ сервера
+class HostnameResolver final
 {
 public:
+	typedef std::function<void(int herr, const std::vector<in_addr>&)> Handler;
+	typedef std::function<void(int herr, const std::vector<in6_addr>&)> Handler6;
+
 	HostnameResolver(const HostnameResolver&) = delete;
 	HostnameResolver& operator=(const HostnameResolver&) = delete;
 	HostnameResolver(HostnameResolver&&) noexcept = delete;
 	HostnameResolver& operator=(HostnameResolver&&) noexcept = delete;
 
 private:
-	HostnameResolver() = default;
+	HostnameResolver();
 	~HostnameResolver() = default;
 
-	std::mutex _mutex;
-	std::map<std::string, std::tuple<int, std::vector<in_addr>, time_t>> _cache;
-
-public:
 	static HostnameResolver& getInstance()
 	{
 		static HostnameResolver instance;
 		return instance;
 	}
 
-	static std::tuple<int, std::vector<in_addr>> resolve(std::string host);
+	typedef std::chrono::steady_clock::time_point TimePoint;
+	typedef std::function<void(int, const std::vector<std::string>&)> RawHandler;
+
+	/// Ответ по имени и типу записи (адреса в сетевом порядке байт)
+	struct Entry final
+	{
+		int herr = 0;
+		std::vector<std::string> addresses;
+		bool resolved = false;
+		TimePoint expires;
+
+		/// С этого момента запись обновляется в фоне, продолжая отдаваться из кеша
+		TimePoint refreshAt;
+
+		/// Запрос к серверу в полете
+		bool pending = false;
+		std::vector<RawHandler> waiters;
+	};
+
+	/// Запрос, ожидающий ответа сервера
+	struct Query final
+	{
+		std::string key;
+		std::string name;
+		DnsMessage::Type type;
+		std::string packet;
+		size_t attempt;
+		TimePoint deadline;
+
+		/// Сокеты попыток: свой на каждую, со случайным портом ядра (ответ на прежнюю попытку тоже годится)
+		std::vector<std::shared_ptr<DnsConnection>> connections;
+	};
+
+	std::mutex _mutex;
+	std::map<std::string, Entry> _cache;
+	std::map<uint16_t, Query> _queries;
+
+	/// Статические записи /etc/hosts
+	std::multimap<std::string, std::string> _hosts;
+
+	std::vector<sockaddr_in> _servers;
+
+	std::shared_ptr<Timer> _timer;
+
+	/// Найти ответ без обращения к серверу. Если его нет и задан обработчик,
+	/// обработчик ставится в ожидание и запрос отправляется
+	bool find(std::string host, DnsMessage::Type type, int& herr, std::vector<std::string>& addresses, RawHandler* handler);
+
+	void startQuery(const std::string& key, const std::string& name, DnsMessage::Type type);
+	void sendQuery(Query& query);
+
+	/// Закрыть сокеты попыток
+	void closeQuery(Query& query);
+
+	/// Записать ответ в кеш и забрать ожидающих. Вызывается под блокировкой
+	std::vector<RawHandler> complete(const std::string& key, int herr, std::vector<std::string>&& addresses, std::chrono::seconds ttl);
+
+	void tick();
+
+	void loadHosts();
+	void loadServers();
+
+public:
+	/// Адреса IPv4
+	static void resolve(const std::string& host, Handler handler);
+
+	/// Адреса IPv6
+	static void resolve6(const std::string& host, Handler6 handler);
+
+	/// Адреса IPv4, известные без обращения к серверу (false - нужен запрос)
+	static bool cached(const std::string& host, int& herr, std::vector<in_addr>& addresses);
+
+	/// Датаграмма от сервера имен, полученная сокетом запроса
+	static void onResponse(const DnsConnection* connection, const char* data, size_t length);
 };
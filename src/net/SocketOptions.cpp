@@ -0,0 +1,155 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// SocketOptions.cpp
+
+
+#include "SocketOptions.hpp"
+
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+
+SocketOptions::SocketOptions()
+: noDelay(true)
+, autoCork(true)
+, deferAccept(0)
+, sendBuffer(0)
+, receiveBuffer(0)
+, keepAlive(false)
+, keepIdle(0)
+, keepInterval(0)
+, keepCount(0)
+, notSentLowat(0)
+{
+}
+
+SocketOptions::SocketOptions(const Setting& setting)
+: SocketOptions()
+{
+	if (setting.exists("tcpNoDelay"))
+	{
+		setting.lookupValue("tcpNoDelay", noDelay);
+	}
+	if (setting.exists("tcpCork"))
+	{
+		setting.lookupValue("tcpCork", autoCork);
+	}
+	if (setting.exists("deferAccept"))
+	{
+		setting.lookupValue("deferAccept", deferAccept);
+	}
+	if (setting.exists("sendBuffer"))
+	{
+		setting.lookupValue("sendBuffer", sendBuffer);
+	}
+	if (setting.exists("receiveBuffer"))
+	{
+		setting.lookupValue("receiveBuffer", receiveBuffer);
+	}
+	if (setting.exists("keepAlive"))
+	{
+		setting.lookupValue("keepAlive", keepAlive);
+	}
+	if (setting.exists("keepIdle"))
+	{
+		setting.lookupValue("keepIdle", keepIdle);
+	}
+	if (setting.exists("keepInterval"))
+	{
+		setting.lookupValue("keepInterval", keepInterval);
+	}
+	if (setting.exists("keepCount"))
+	{
+		setting.lookupValue("keepCount", keepCount);
+	}
+	if (setting.exists("notSentLowat"))
+	{
+		setting.lookupValue("notSentLowat", notSentLowat);
+	}
+
+	if (deferAccept < 0 || sendBuffer < 0 || receiveBuffer < 0 || keepIdle < 0 || keepInterval < 0 || keepCount < 0 || notSentLowat < 0)
+	{
+		throw std::runtime_error("Bad config: socket options must be non-negative");
+	}
+}
+
+void SocketOptions::applyListener(int sock) const
+{
+	if (deferAccept > 0)
+	{
+		if (setsockopt(sock, IPPROTO_TCP, TCP_DEFER_ACCEPT, &deferAccept, sizeof(deferAccept)) != 0)
+		{
+			throw std::runtime_error(std::string("Can't set TCP_DEFER_ACCEPT ← ") + strerror(errno));
+		}
+	}
+
+	// Размер приемного буфера влияет на окно, объявляемое при установлении соединения,
+	// поэтому задается еще слушающему сокету - принятые его наследуют
+	if (receiveBuffer > 0)
+	{
+		setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof(receiveBuffer));
+	}
+}
+
+void SocketOptions::apply(int sock, bool tcp) const
+{
+	// Ошибки не фатальны: соединение работоспособно и с параметрами по умолчанию
+
+	if (sendBuffer > 0)
+	{
+		setsockopt(sock, SOL_SOCKET, SO_SNDBUF, &sendBuffer, sizeof(sendBuffer));
+	}
+
+	if (!tcp)
+	{
+		return;
+	}
+
+	if (noDelay)
+	{
+		const int val = 1;
+		setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &val, sizeof(val));
+	}
+
+	if (keepAlive)
+	{
+		const int val = 1;
+		setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, &val, sizeof(val));
+		if (keepIdle > 0)
+		{
+			setsockopt(sock, IPPROTO_TCP, TCP_KEEPIDLE, &keepIdle, sizeof(keepIdle));
+		}
+		if (keepInterval > 0)
+		{
+			setsockopt(sock, IPPROTO_TCP, TCP_KEEPINTVL, &keepInterval, sizeof(keepInterval));
+		}
+		if (keepCount > 0)
+		{
+			setsockopt(sock, IPPROTO_TCP, TCP_KEEPCNT, &keepCount, sizeof(keepCount));
+		}
+	}
+
+	if (notSentLowat > 0)
+	{
+		setsockopt(sock, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &notSentLowat, sizeof(notSentLowat));
+	}
+}
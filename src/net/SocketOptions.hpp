@@ -0,0 +1,60 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// SocketOptions.hpp
+
+
+#pragma once
+
+#include "../configs/Setting.hpp"
+
+/// Параметры сокетов подключений транспорта (0 - значение системы по умолчанию)
+class SocketOptions final
+{
+public:
+	/// Отключить алгоритм Нейгла (TCP_NODELAY)
+	bool noDelay;
+
+	/// Придерживать неполные сегменты (TCP_CORK), пока ответ отправляется несколькими вызовами
+	bool autoCork;
+
+	/// Будить слушающий сокет только при появлении данных от клиента (секунд, TCP_DEFER_ACCEPT)
+	int deferAccept;
+
+	/// Размеры буферов сокета (SO_SNDBUF/SO_RCVBUF; явный размер отключает автоподстройку ядром)
+	int sendBuffer;
+	int receiveBuffer;
+
+	/// Проверка живости простаивающего соединения (SO_KEEPALIVE, TCP_KEEPIDLE/INTVL/CNT)
+	bool keepAlive;
+	int keepIdle;
+	int keepInterval;
+	int keepCount;
+
+	/// Порог неотправленных данных, ниже которого сокет считается готовым к записи (TCP_NOTSENT_LOWAT)
+	int notSentLowat;
+
+	SocketOptions();
+	explicit SocketOptions(const Setting& setting);
+
+	/// Настроить слушающий сокет
+	void applyListener(int sock) const;
+
+	/// Настроить принятый сокет (TCP-параметры только для TCP)
+	void apply(int sock, bool tcp) const;
+};
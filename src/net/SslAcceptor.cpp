@@ -22,9 +22,11 @@
 #include "SslAcceptor.hpp"
 #include "SslConnection.hpp"
 #include "ConnectionManager.hpp"
+#include "HandshakePool.hpp"
+#include "../utils/ObjectPool.hpp"
 
-SslAcceptor::SslAcceptor(const std::shared_ptr<ServerTransport>& transport, const std::string& host, std::uint16_t port, const std::shared_ptr<SSL_CTX>& context)
-: TcpAcceptor(transport, host, port)
+SslAcceptor::SslAcceptor(const std::shared_ptr<ServerTransport>& transport, const std::string& host, std::uint16_t port, int backlog, bool reusePort, const std::shared_ptr<SSL_CTX>& context)
+: TcpAcceptor(transport, host, port, backlog, reusePort)
 , _sslContext(context)
 {
 	_name = "SslAcceptor" + _name.substr(11);
@@ -38,7 +40,21 @@ void SslAcceptor::createConnection(int sock, const sockaddr_in &cliaddr)
 		return;
 	}
 
-	auto newConnection = std::make_shared<SslConnection>(transport, sock, cliaddr, _sslContext, false);
+	// Рукопожатия не успевают - подключение сразу сбрасываем, а не удлиняем очередь
+	if (HandshakePool::saturated())
+	{
+		const linger lg{1, 0};
+		setsockopt(sock, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+		::close(sock);
+
+		HandshakePool::reject();
+		if (transport->metricShedCount) transport->metricShedCount->addValue();
+
+		_log.info("%s shed [%u] (handshake queue is full)", name().c_str(), sock);
+		return;
+	}
+
+	auto newConnection = makePooled<SslConnection>(transport, sock, cliaddr, _sslContext, false);
 	if (!newConnection)
 	{
 		return;
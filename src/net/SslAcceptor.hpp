@@ -37,13 +37,13 @@ public:
 	SslAcceptor(SslAcceptor&& tmp) noexcept = delete;
 	SslAcceptor& operator=(SslAcceptor&& tmp) noexcept = delete;
 
-	SslAcceptor(const std::shared_ptr<ServerTransport>& transport, const std::string& host, std::uint16_t port, const std::shared_ptr<SSL_CTX>& sslContext);
+	SslAcceptor(const std::shared_ptr<ServerTransport>& transport, const std::string& host, std::uint16_t port, int backlog, bool reusePort, const std::shared_ptr<SSL_CTX>& sslContext);
 	~SslAcceptor() override = default;
 
 	void createConnection(int sock, const sockaddr_in& cliaddr) override;
 
-	static std::shared_ptr<Connection> create(const std::shared_ptr<ServerTransport>& transport, const std::string& host, std::uint16_t port, const std::shared_ptr<SSL_CTX>& sslContext)
+	static std::shared_ptr<Connection> create(const std::shared_ptr<ServerTransport>& transport, const std::string& host, std::uint16_t port, int backlog, bool reusePort, const std::shared_ptr<SSL_CTX>& sslContext)
 	{
-		return std::make_shared<SslAcceptor>(transport, host, port, sslContext);
+		return std::make_shared<SslAcceptor>(transport, host, port, backlog, reusePort, sslContext);
 	}
 };
@@ -20,11 +20,18 @@
 
 
 #include "SslConnection.hpp"
+#include <algorithm>
 #include <cstring>
 #include <openssl/ssl.h>
 #include <openssl/err.h>
+#include "../utils/SslHelper.hpp"
 #include "ConnectionManager.hpp"
+#include "HandshakePool.hpp"
 #include "../transport/ServerTransport.hpp"
+#include <unistd.h>
+
+/// Размер блока чтения участка файла (максимальный размер TLS-записи)
+static const size_t fileBlockSize = 1u << 14;
 
 SslConnection::SslConnection(const std::shared_ptr<Transport>& transport, int sock, const sockaddr_in& sockaddr, const std::shared_ptr<SSL_CTX>& sslContext, bool outgoing)
 : TcpConnection(transport, sock, sockaddr, outgoing)
@@ -32,11 +39,27 @@ SslConnection::SslConnection(const std::shared_ptr<Transport>& transport, int so
 , _sslEstablished(false)
 , _sslWantRead(!outgoing)
 , _sslWantWrite(outgoing)
+, _kernelSend(false)
+, _handshakeStepDone(false)
+, _fileBlockLen(0)
 {
-	_name = "SslConnection" + _name.substr(13);
-
 	_sslConnect = SSL_new(_sslContext.get());
 	SSL_set_fd(_sslConnect, _sock);
+
+	// Внутренние буферы OpenSSL освобождаются, пока соединение простаивает
+	SSL_set_mode(_sslConnect, SSL_MODE_RELEASE_BUFFERS);
+}
+
+void SslConnection::setPeer(const std::string& host, std::uint16_t port)
+{
+	_peer = host + ":" + std::to_string(port);
+
+	SslHelper::prepareClient(_sslConnect, host, &_peer);
+}
+
+std::string SslConnection::formatName() const
+{
+	return "SslConnection" + TcpConnection::formatName().substr(13);
 }
 
 SslConnection::~SslConnection()
@@ -73,7 +96,7 @@ void SslConnection::watch(epoll_event &ev)
 			_log.trace("WATCH: No established and no want read");
 		}
 	}
-	else if (!_noRead)
+	else if (!_noRead && !_throttled)
 	{
 		_log.trace("WATCH: Established and can read");
 		ev.events |= EPOLLIN | EPOLLRDNORM;
@@ -106,10 +129,48 @@ void SslConnection::watch(epoll_event &ev)
 
 bool SslConnection::processing()
 {
-	_log.debug("Begin processing on %s", name().c_str());
+	if (_log.enabled(Log::Detail::DEBUG)) _log.debug("Begin processing on %s", name().c_str());
+
+	bool handshakeStepDone = _handshakeStepDone;
+	_handshakeStepDone = false;
+
+	// Шаг рукопожатия выполняет пул рукопожатий; обработка продолжится по его завершении
+	if (!_sslEstablished && !handshakeStepDone && HandshakePool::enabled()
+		&& (isReadyForRead() || isReadyForWrite()) && !timeIsOut() && !wasFailure())
+	{
+		auto self = std::static_pointer_cast<SslConnection>(ptr());
+
+		// В пул шаг уйдет только после выхода отсюда: иначе пул мог бы возобновить обработку,
+		// пока этот поток еще внутри processing()
+		ConnectionManager::suspend(
+			self,
+			[self]
+			{
+				HandshakePool::enqueue(
+					[self]
+					{
+						self->sslHandshake();
+						self->_handshakeStepDone = true;
+
+						ConnectionManager::resume(self);
+					}
+				);
+			}
+		);
+
+		if (_log.enabled(Log::Detail::DEBUG)) _log.debug("End processing on %s: Handshake offloaded", name().c_str());
+		return true;
+	}
+
+	// Цикл вызван только сигналом простоя - без ввода-вывода
+	bool idle = false;
+	bool active = false;
 
 	do
 	{
+		idle = idle || isIdle();
+		active = active || isReadyForRead() || isReadyForWrite() || _readDeferred;
+
 		if (timeIsOut())
 		{
 			_timeout = true;
@@ -124,20 +185,26 @@ bool SslConnection::processing()
 
 		if (!_sslEstablished)
 		{
+			// Шаг только что сделан в пуле рукопожатий - ждем новых событий
+			if (handshakeStepDone)
+			{
+				break;
+			}
 			if (!sslHandshake())
 			{
 				break;
 			}
 		}
+		handshakeStepDone = false;
 
 		if (isReadyForWrite() && hasDataForSend())
 		{
 			writeToSocket();
 		}
 
-		if (isReadyForRead())
+		if (isReadyForRead() || _readDeferred)
 		{
-			readFromSocket();
+			readOrDefer();
 		}
 
 		if (hasDataForSend())
@@ -161,7 +228,9 @@ bool SslConnection::processing()
 
 		ConnectionManager::rotateEvents(this->ptr());
 	}
-	while (isReadyForRead() || (isReadyForWrite() && hasDataForSend()) || wasFailure() || timeIsOut());
+	while (isReadyForRead() || (isReadyForWrite() && hasDataForSend()) || (_readDeferred && !_throttled) || wasFailure() || timeIsOut());
+
+	reclaimMemory(idle && !active);
 
 	if (_timeout)
 	{
@@ -175,6 +244,8 @@ bool SslConnection::processing()
 		onError();
 	}
 
+	notifyReady();
+
 	if (_noRead)
 	{
 		if (!hasDataForSend())
@@ -190,7 +261,7 @@ bool SslConnection::processing()
 	{
 		ConnectionManager::remove(ptr());
 
-		_log.debug("End processing on %s: Close", name().c_str());
+		if (_log.enabled(Log::Detail::DEBUG)) _log.debug("End processing on %s: Close", name().c_str());
 		return true;
 	}
 
@@ -201,7 +272,7 @@ bool SslConnection::processing()
 		_closed = true;
 	}
 
-	_log.debug("End processing on %s: Ready", name().c_str());
+	if (_log.enabled(Log::Detail::DEBUG)) _log.debug("End processing on %s: Ready", name().c_str());
 	return true;
 }
 
@@ -218,7 +289,7 @@ bool SslConnection::sslHandshake()
 		{
 			if (isHup() || isHalfHup())
 			{
-				_log.trace("Can't complete SSH handshake: already closed %s", name().c_str());
+				if (_log.enabled(Log::Detail::TRACE)) _log.trace("Can't complete SSH handshake: already closed %s", name().c_str());
 				shutdown(_sock, SHUT_RD);
 				setTtl(std::chrono::milliseconds(50));
 				_noRead = true;
@@ -232,32 +303,32 @@ bool SslConnection::sslHandshake()
 			if (errno)
 			{
 				_error = true;
-				_log.debug("SSL_ERROR_SYSCALL while SSH handshake on %s: %s", name().c_str(), strerror(errno));
+				if (_log.enabled(Log::Detail::DEBUG)) _log.debug("SSL_ERROR_SYSCALL while SSH handshake on %s: %s", name().c_str(), strerror(errno));
 				return false;
 			}
 
-			_log.debug("SSL_ERROR_SYSCALL with errno=0 while SSH handshake on %s", name().c_str());
+			if (_log.enabled(Log::Detail::DEBUG)) _log.debug("SSL_ERROR_SYSCALL with errno=0 while SSH handshake on %s", name().c_str());
 			goto again;
 		}
 		if (e == SSL_ERROR_WANT_READ)
 		{
 			_sslWantRead = true;
 			_sslWantWrite = false;
-			_log.trace("SSH handshake incomplete yet on %s (want read)", name().c_str());
+			if (_log.enabled(Log::Detail::TRACE)) _log.trace("SSH handshake incomplete yet on %s (want read)", name().c_str());
 			return false;
 		}
 		if (e == SSL_ERROR_WANT_WRITE)
 		{
 			_sslWantRead = false;
 			_sslWantWrite = true;
-			_log.trace("SSH handshake incomplete yet on %s (want wtite)", name().c_str());
+			if (_log.enabled(Log::Detail::TRACE)) _log.trace("SSH handshake incomplete yet on %s (want wtite)", name().c_str());
 			return false;
 		}
 
 		char err[1ull<<7];
 		ERR_error_string_n(ERR_get_error(), err, sizeof(err));
 
-		_log.trace("Fail SSH handshake on %s: %s", name().c_str(), err);
+		if (_log.enabled(Log::Detail::TRACE)) _log.trace("Fail SSH handshake on %s: %s", name().c_str(), err);
 
 		char msg[] = "HTTP/1.1 525 SSL handshake failed\r\n\r\nSSL handshake failed\n";
 		::write(_sock, msg, sizeof(msg));
@@ -274,13 +345,33 @@ bool SslConnection::sslHandshake()
 
 	_sslEstablished = true;
 
-	_log.trace("Success SSH handshake on %s", name().c_str());
+#ifndef OPENSSL_NO_KTLS
+	// Ядро приняло ключи, если шифр ему известен; иначе остаемся на SSL_write
+	_kernelSend = BIO_get_ktls_send(SSL_get_wbio(_sslConnect));
+	if (_kernelSend && _log.enabled(Log::Detail::DEBUG)) _log.debug("Kernel TLS send enabled on %s", name().c_str());
+#endif
+
+	if (!_outgoing)
+	{
+		SslHelper::accountHandshake(_sslConnect);
+	}
+
+	if (_log.enabled(Log::Detail::TRACE)) _log.trace("Success SSH handshake on %s", name().c_str());
 	return true;
 }
 
 bool SslConnection::writeToSocket()
 {
-	_log.trace("Write into socket on %s", name().c_str());
+	// Записи формирует ядро: данные и участки файлов уходят через writev и sendfile без копирования
+	if (_kernelSend)
+	{
+		return TcpConnection::writeToSocket();
+	}
+
+	if (_log.enabled(Log::Detail::TRACE)) _log.trace("Write into socket on %s", name().c_str());
+
+	// Каждый фрагмент уходит отдельной TLS-записью - склеиваем их в полные сегменты
+	cork(_outBuff.multipart(1));
 
 	// Отправляем данные
 	for (;;)
@@ -293,11 +384,47 @@ bool SslConnection::writeToSocket()
 			break;
 		}
 
-		int n = SSL_write(_sslConnect, _outBuff.dataPtr(), (_outBuff.dataLen() > 1ull<<12u) ? (1ull<<12u) : static_cast<int>(_outBuff.dataLen()));
+		const char* data;
+		int len;
+
+		auto fd = _outBuff.frontFd();
+		if (fd >= 0)
+		{
+			// Участок файла читаем в промежуточный блок, если предыдущий уже отправлен
+			if (_fileBlockLen == 0)
+			{
+				if (!_fileBlock)
+				{
+					_fileBlock.reset(new char[fileBlockSize]);
+				}
+				auto r = ::pread(fd, _fileBlock.get(), std::min(_outBuff.frontLen(), fileBlockSize), _outBuff.frontOffset());
+				if (r == -1 && errno == EINTR)
+				{
+					continue;
+				}
+				if (r <= 0)
+				{
+					if (_log.enabled(Log::Detail::DEBUG)) _log.debug("Fail reading file for write on %s: %s", name().c_str(), r ? strerror(errno) : "file truncated");
+					_error = true;
+					return false;
+				}
+				_fileBlockLen = static_cast<size_t>(r);
+			}
+			data = _fileBlock.get();
+			len = static_cast<int>(_fileBlockLen);
+		}
+		else
+		{
+			data = _outBuff.frontPtr();
+			len = (_outBuff.frontLen() > 1ull<<12u) ? (1ull<<12u) : static_cast<int>(_outBuff.frontLen());
+		}
+
+		int n = SSL_write(_sslConnect, data, len);
 		if (n > 0)
 		{
+			_fileBlockLen = 0;
 			_outBuff.skip(static_cast<size_t>(n));
-			_log.debug("Write %d bytes on %s", n, name().c_str());
+			if (_log.enabled(Log::Detail::DEBUG)) _log.debug("Write %d bytes on %s", n, name().c_str());
 			continue;
 		}
 
@@ -311,12 +438,12 @@ bool SslConnection::writeToSocket()
 		}
 		else if (e == SSL_ERROR_WANT_WRITE)
 		{
-			_log.debug("No more write on %s", name().c_str());
+			if (_log.enabled(Log::Detail::DEBUG)) _log.debug("No more write on %s", name().c_str());
 			break;
 		}
 		else if (e == SSL_ERROR_WANT_READ)
 		{
-			_log.debug("No more write without read before on %s", name().c_str());
+			if (_log.enabled(Log::Detail::DEBUG)) _log.debug("No more write without read before on %s", name().c_str());
 			break;
 		}
 		// Повторяем вызов прерваный сигналом
@@ -324,40 +451,46 @@ bool SslConnection::writeToSocket()
 		{
 			if (isHup())
 			{
-				_log.debug("SSL_ERROR_SYSCALL Can't more write %s", name().c_str());
+				if (_log.enabled(Log::Detail::DEBUG)) _log.debug("SSL_ERROR_SYSCALL Can't more write %s", name().c_str());
 				_noWrite = true;
 				break;
 			}
 
 			if (errno)
 			{
-				_log.debug("SSL_ERROR_SYSCALL while SslHelper-write on %s: %s", name().c_str(), strerror(errno));
+				if (_log.enabled(Log::Detail::DEBUG)) _log.debug("SSL_ERROR_SYSCALL while SslHelper-write on %s: %s", name().c_str(), strerror(errno));
 				break;
 			}
 
-			_log.debug("SSL_ERROR_SYSCALL with errno=0 while SslHelper-write on %s", name().c_str());
+			if (_log.enabled(Log::Detail::DEBUG)) _log.debug("SSL_ERROR_SYSCALL with errno=0 while SslHelper-write on %s", name().c_str());
 			break;
 		}
 		else if (e == SSL_ERROR_SSL)
 		{
-			_log.trace("SSL_ERROR_SSL while SslHelper-write on %s", name().c_str());
+			if (_log.enabled(Log::Detail::TRACE)) _log.trace("SSL_ERROR_SSL while SslHelper-write on %s", name().c_str());
 			_error = true;
 			return false;
 		}
 		else
 		{
-			_log.trace("SSL_ERROR_? while SslHelper-write on %s", name().c_str());
+			if (_log.enabled(Log::Detail::TRACE)) _log.trace("SSL_ERROR_? while SslHelper-write on %s", name().c_str());
 			_error = true;
 			return false;
 		}
 	}
 
+	// Отпускаем придержанный хвост
+	cork(false);
+
+	// Вне блокировки буфера: обработчик снятия приостановки может сразу писать в соединение
+	checkBackpressure();
+
 	return true;
 }
 
 bool SslConnection::readFromSocket()
 {
-	_log.trace("Read from socket on %s", name().c_str());
+	if (_log.enabled(Log::Detail::TRACE)) _log.trace("Read from socket on %s", name().c_str());
 
 	// Пытаемся полностью заполнить буфер
 	for (;;)
@@ -370,7 +503,7 @@ bool SslConnection::readFromSocket()
 		if (n > 0)
 		{
 			_inBuff.forward(static_cast<size_t>(n));
-			_log.trace("Read %d bytes on %s", n, name().c_str());
+			if (_log.enabled(Log::Detail::TRACE)) _log.trace("Read %d bytes on %s", n, name().c_str());
 			continue;
 		}
 
@@ -384,49 +517,49 @@ bool SslConnection::readFromSocket()
 		}
 		else if (e == SSL_ERROR_WANT_READ)
 		{
-			_log.trace("No more read on %s", name().c_str());
+			if (_log.enabled(Log::Detail::TRACE)) _log.trace("No more read on %s", name().c_str());
 			break;
 		}
 		// Нет готовых данных - продолжаем ждать
 		else if (e == SSL_ERROR_ZERO_RETURN)
 		{
 			// Клиент отключился
-			_log.trace("Client disconnected on %s", name().c_str());
+			if (_log.enabled(Log::Detail::TRACE)) _log.trace("Client disconnected on %s", name().c_str());
 			_noRead = true;
 			break;
 		}
 		else if (e == SSL_ERROR_WANT_WRITE)
 		{
-			_log.trace("No more read without writing before on %s", name().c_str());
+			if (_log.enabled(Log::Detail::TRACE)) _log.trace("No more read without writing before on %s", name().c_str());
 			break;
 		}
 		else if (e == SSL_ERROR_SYSCALL)
 		{
 			if (isHalfHup() || isHup())
 			{
-				_log.trace("Connection already closed %s", name().c_str());
+				if (_log.enabled(Log::Detail::TRACE)) _log.trace("Connection already closed %s", name().c_str());
 				_noRead = true;
 				break;
 			}
 
 			if (errno)
 			{
-				_log.debug("SSL_ERROR_SYSCALL while SslHelper-read on %s: %s", name().c_str(), strerror(errno));
+				if (_log.enabled(Log::Detail::DEBUG)) _log.debug("SSL_ERROR_SYSCALL while SslHelper-read on %s: %s", name().c_str(), strerror(errno));
 				break;
 			}
 
-			_log.trace("SSL_ERROR_SYSCALL with errno=0 while SslHelper-read on %s", name().c_str());
+			if (_log.enabled(Log::Detail::TRACE)) _log.trace("SSL_ERROR_SYSCALL with errno=0 while SslHelper-read on %s", name().c_str());
 			break;
 		}
 		else if (e == SSL_ERROR_SSL)
 		{
-			_log.debug("SSL_ERROR_SSL while SslHelper-read on %s", name().c_str());
+			if (_log.enabled(Log::Detail::DEBUG)) _log.debug("SSL_ERROR_SSL while SslHelper-read on %s", name().c_str());
 			_error = true;
 			return false;
 		}
 		else
 		{
-			_log.debug("SSL_ERROR_? while SslHelper-read on %s", name().c_str());
+			if (_log.enabled(Log::Detail::DEBUG)) _log.debug("SSL_ERROR_? while SslHelper-read on %s", name().c_str());
 			_error = true;
 			return false;
 		}
@@ -41,8 +41,24 @@ private:
 	bool _sslWantRead;
 	bool _sslWantWrite;
 
+	/// Шифрование отправляемых данных передано ядру (kTLS) - пишем в сокет как в обычный
+	bool _kernelSend;
+
+	/// Шаг рукопожатия выполнен пулом рукопожатий, обработка возобновлена
+	bool _handshakeStepDone;
+
+	/// Промежуточный блок для отправки участков файла (sendfile через TLS невозможен).
+	/// Неудавшийся SSL_write повторяется с теми же данными, поэтому блок живет в соединении
+	std::unique_ptr<char[]> _fileBlock;
+	size_t _fileBlockLen;
+
+	/// Адрес узла исходящего соединения (ключ сохраненной TLS-сессии)
+	std::string _peer;
+
 	bool sslHandshake();
 
+	std::string formatName() const override;
+
 	bool readFromSocket() override;
 	bool writeToSocket() override;
 
@@ -65,4 +81,7 @@ public:
 	void watch(epoll_event& ev) override;
 
 	bool processing() override;
+
+	/// Указать узел исходящего соединения (до начала рукопожатия)
+	void setPeer(const std::string& host, std::uint16_t port);
 };
@@ -22,6 +22,7 @@
 #include <openssl/ossl_typ.h>
 #include "SslConnector.hpp"
 #include "SslConnection.hpp"
+#include "../utils/ObjectPool.hpp"
 
 SslConnector::SslConnector(
 	const std::shared_ptr<ClientTransport>& transport,
@@ -37,5 +38,10 @@ SslConnector::SslConnector(
 
 std::shared_ptr<TcpConnection> SslConnector::createConnection(const std::shared_ptr<Transport>& transport)
 {
-	return std::make_shared<SslConnection>(transport, _sock, _sockaddr, _sslContext, true);
+	auto connection = makePooled<SslConnection>(transport, _sock, _sockaddr, _sslContext, true);
+
+	// SNI и возобновление прошлой сессии с этим узлом
+	connection->setPeer(_host, _port);
+
+	return connection;
 }
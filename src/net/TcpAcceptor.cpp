@@ -24,18 +24,31 @@
 #include <netinet/in.h>
 #include <cstring>
 #include <arpa/inet.h>
-#include <fcntl.h>
 #include "ConnectionManager.hpp"
 #include "TcpConnection.hpp"
 #include "../utils/Daemon.hpp"
+#include "../utils/MemoryBudget.hpp"
+#include "../utils/ObjectPool.hpp"
 
-TcpAcceptor::TcpAcceptor(const std::shared_ptr<ServerTransport>& transport, const std::string& host, std::uint16_t port)
+constexpr std::chrono::milliseconds TcpAcceptor::retryDelay;
+
+/// Не хватает дескрипторов или памяти: очередь не разобрать, пока их не освободят
+static bool isShortage(int error)
+{
+	return error == EMFILE || error == ENFILE || error == ENOBUFS || error == ENOMEM;
+}
+
+TcpAcceptor::TcpAcceptor(const std::shared_ptr<ServerTransport>& transport, const std::string& host, std::uint16_t port, int backlog, bool reusePort)
 : Acceptor(transport)
 , _host(host)
 , _port(port)
+, _backlog(backlog)
+, _reusePort(reusePort)
+, _socketOptions(transport->socketOptions())
+, _paused(false)
 {
-	// Создаем сокет
-	_sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	// Создаем сокет (сразу неблокирующий)
+	_sock = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
 	if (_sock == -1)
 	{
 		throw std::runtime_error("Can't create socket");
@@ -47,6 +60,15 @@ TcpAcceptor::TcpAcceptor(const std::shared_ptr<ServerTransport>& transport, cons
 
 	setsockopt(_sock, SOL_SOCKET, SO_REUSEADDR, &val, sizeof(val));
 
+	// Несколько слушающих сокетов на одном порту - ядро само распределяет подключения между ними
+	if (_reusePort)
+	{
+		if (setsockopt(_sock, SOL_SOCKET, SO_REUSEPORT, &val, sizeof(val)) != 0)
+		{
+			throw std::runtime_error(std::string("Can't set SO_REUSEPORT ← ") + strerror(errno));
+		}
+	}
+
 	sockaddr_in servaddr{};
 	socklen_t addrlen = sizeof(sockaddr_in);
 
@@ -82,19 +104,27 @@ TcpAcceptor::TcpAcceptor(const std::shared_ptr<ServerTransport>& transport, cons
 		throw std::runtime_error(std::string("Can't bind socket ← ") + strerror(errno));
 	}
 
+	_socketOptions.applyListener(_sock);
+
 	// Преобразуем сокет в пассивный (слушающий) и устанавливаем длину очереди соединений
-	if (listen(_sock, 16) != 0)
+	if (listen(_sock, _backlog) != 0)
 	{
 		throw std::runtime_error(std::string("Can't listen port ← ") + strerror(errno));
 	}
 
-	// Включем неблокирующий режим
-	int rrc = fcntl(_sock, F_GETFL, 0);
-	fcntl(_sock, F_SETFL, rrc | O_NONBLOCK);
-
 	_log.debug("%s created", name().c_str());
 }
 
+TcpAcceptor::TcpAcceptor(const std::shared_ptr<ServerTransport>& transport, int backlog)
+: Acceptor(transport)
+, _port(0)
+, _backlog(backlog)
+, _reusePort(false)
+, _socketOptions(transport->socketOptions())
+, _paused(false)
+{
+}
+
 TcpAcceptor::~TcpAcceptor()
 {
 	_log.debug("%s destroyed", name().c_str());
@@ -108,7 +138,39 @@ void TcpAcceptor::watch(epoll_event &ev)
 	ev.events |= EPOLLET; // Ждем появления НОВЫХ событий
 
 	ev.events |= EPOLLERR;
+
+	// На паузе новых подключений не ждем - прием возобновит таймер
+	if (_paused)
+	{
+		return;
+	}
+
 	ev.events |= EPOLLIN;
+
+	// Принимать будет ядро (если умеет) - одной многократной операцией
+	ev.events |= EventEngine::KERNEL_ACCEPT;
+}
+
+void TcpAcceptor::pause(int error)
+{
+	_log.warn("%s pause accepting for %lld ms (accept error: %s)", name().c_str(), static_cast<long long>(retryDelay.count()), strerror(error));
+
+	_paused = true;
+
+	if (!_resumeTimer)
+	{
+		_resumeTimer = makePooled<Timer>(
+			[wp = std::weak_ptr<Connection>(ptr())](){
+				if (auto connection = wp.lock())
+				{
+					std::static_pointer_cast<TcpAcceptor>(connection)->_paused = false;
+					ConnectionManager::watch(connection);
+				}
+			},
+			"Resume accepting"
+		);
+	}
+	_resumeTimer->restart(retryDelay);
 }
 
 bool TcpAcceptor::processing()
@@ -134,11 +196,47 @@ bool TcpAcceptor::processing()
 			throw std::runtime_error("Error on TcpAcceptor");
 		}
 
+		// Подключения, уже принятые ядром, - свои вызовы не нужны
+		std::vector<int> socks;
+		int error = 0;
+		if (ConnectionManager::engineOf(ptr()).accepted(this, socks, error))
+		{
+			for (auto sock : socks)
+			{
+				sockaddr_in cliaddr{};
+				socklen_t clilen = sizeof(cliaddr);
+				getpeername(sock, (sockaddr *)&cliaddr, &clilen);
+
+				if (_log.enabled(Log::Detail::DEBUG)) _log.debug("%s accept [%u]", name().c_str(), sock);
+
+				admit(sock, cliaddr);
+			}
+
+			// Прием ядром остановлен ошибкой: при нехватке ресурсов перезапуск откладываем,
+			// иначе он произойдет при освобождении
+			if (error != 0)
+			{
+				if (isShortage(error))
+				{
+					pause(error);
+				}
+				else
+				{
+					_log.debug("End processing on %s (accept error: %s)", name().c_str(), strerror(error));
+				}
+				return false;
+			}
+
+			_log.debug("End processing on %s (accepted by kernel)", name().c_str());
+			return true;
+		}
+
 		sockaddr_in cliaddr{};
 		socklen_t clilen = sizeof(cliaddr);
 		memset(&cliaddr, 0, clilen);
 
-		int sock = ::accept(fd(), (sockaddr *)&cliaddr, &clilen);
+		// Принимаем подключение сразу в неблокирующем режиме
+		int sock = ::accept4(fd(), (sockaddr *)&cliaddr, &clilen, SOCK_NONBLOCK | SOCK_CLOEXEC);
 		if (sock == -1)
 		{
 			// Вызов прерван сигналом - повторяем
@@ -154,28 +252,58 @@ bool TcpAcceptor::processing()
 				return true;
 			}
 
+			if (isShortage(errno))
+			{
+				pause(errno);
+				return false;
+			}
+
 			// Ошибка установления соединения
 			_log.debug("End processing on %s (accept error: %s)", name().c_str(), strerror(errno));
 			return false;
 		}
 
-		_log.debug("%s accept [%u]", name().c_str(), sock);
+		if (_log.enabled(Log::Detail::DEBUG)) _log.debug("%s accept [%u]", name().c_str(), sock);
 
-		// Перевод сокета в неблокирующий режим
-		int val = fcntl(sock, F_GETFL, 0);
-		fcntl(sock, F_SETFL, val | O_NONBLOCK);
+		admit(sock, cliaddr);
+	}
+}
 
-		try
-		{
-			createConnection(sock, cliaddr);
-		}
-		catch (const std::exception& exception)
-		{
-			shutdown(sock, SHUT_RDWR);
-			_log.info("%s close [%u]", name().c_str(), sock);
-			::close(sock);
-		}
+void TcpAcceptor::admit(int sock, const sockaddr_in &cliaddr)
+{
+	// Бюджет памяти превышен - подключение сразу сбрасываем, не тратя на него буферы
+	if (MemoryBudget::exceeded())
+	{
+		const linger lg{1, 0};
+		setsockopt(sock, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+		::close(sock);
+
+		auto transport = std::dynamic_pointer_cast<ServerTransport>(_transport.lock());
+		if (transport && transport->metricShedCount) transport->metricShedCount->addValue();
+
+		_log.info("%s shed [%u] (memory budget exceeded)", name().c_str(), sock);
+		return;
 	}
+
+	try
+	{
+		tune(sock);
+
+		createConnection(sock, cliaddr);
+
+		if (metricAcceptRate) metricAcceptRate->addValue();
+	}
+	catch (const std::exception& exception)
+	{
+		shutdown(sock, SHUT_RDWR);
+		_log.info("%s close [%u]", name().c_str(), sock);
+		::close(sock);
+	}
+}
+
+void TcpAcceptor::tune(int sock)
+{
+	_socketOptions.apply(sock, true);
 }
 
 void TcpAcceptor::createConnection(int sock, const sockaddr_in &cliaddr)
@@ -186,7 +314,7 @@ void TcpAcceptor::createConnection(int sock, const sockaddr_in &cliaddr)
 		return;
 	}
 
-	auto newConnection = std::make_shared<TcpConnection>(transport, sock, cliaddr, false);
+	auto newConnection = makePooled<TcpConnection>(transport, sock, cliaddr, false);
 
 	newConnection->setTtl(std::chrono::seconds(5));
 
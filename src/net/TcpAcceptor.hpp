@@ -31,8 +31,32 @@ class TcpAcceptor : public Acceptor
 protected:
 	std::string _host;
 	std::uint16_t _port;
+	int _backlog;
+	bool _reusePort;
 	std::mutex _mutex;
 
+	/// Параметры принимаемых сокетов (копия настроек транспорта)
+	SocketOptions _socketOptions;
+
+	/// Прием приостановлен после нехватки ресурсов (EMFILE, ENFILE, ENOBUFS, ENOMEM)
+	std::atomic_bool _paused;
+	std::shared_ptr<Timer> _resumeTimer;
+
+	/// Пауза приема: без нее повторный прием сразу получит ту же ошибку
+	static constexpr std::chrono::milliseconds retryDelay{100};
+
+	/// Приостановить прием из-за ошибки (error - errno); через retryDelay он возобновится
+	void pause(int error);
+
+	/// Настроить принятый сокет
+	virtual void tune(int sock);
+
+	/// Принять в работу подключение (или сбросить его при нехватке памяти)
+	void admit(int sock, const sockaddr_in &cliaddr);
+
+	/// Для наследников, создающих слушающий сокет другого семейства
+	TcpAcceptor(const std::shared_ptr<ServerTransport>& transport, int backlog);
+
 public:
 	TcpAcceptor() = delete;
 	TcpAcceptor(const TcpAcceptor&) = delete;
@@ -40,7 +64,7 @@ public:
 	TcpAcceptor(TcpAcceptor&& tmp) noexcept = delete;
 	TcpAcceptor& operator=(TcpAcceptor&& tmp) noexcept = delete;
 
-	TcpAcceptor(const std::shared_ptr<ServerTransport>& transport, const std::string& host, std::uint16_t port);
+	TcpAcceptor(const std::shared_ptr<ServerTransport>& transport, const std::string& host, std::uint16_t port, int backlog, bool reusePort);
 	~TcpAcceptor() override;
 
 	void watch(epoll_event &ev) override;
@@ -49,8 +73,8 @@ public:
 
 	bool processing() override;
 
-	static std::shared_ptr<TcpAcceptor> create(const std::shared_ptr<ServerTransport>& transport, const std::string& host, std::uint16_t port)
+	static std::shared_ptr<TcpAcceptor> create(const std::shared_ptr<ServerTransport>& transport, const std::string& host, std::uint16_t port, int backlog, bool reusePort)
 	{
-		return std::make_shared<TcpAcceptor>(transport, host, port);
+		return std::make_shared<TcpAcceptor>(transport, host, port, backlog, reusePort);
 	}
 };
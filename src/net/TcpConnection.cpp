@@ -23,37 +23,104 @@
 #include "ConnectionManager.hpp"
 #include <arpa/inet.h>
 #include <cstring>
-#include <sys/ioctl.h>
+#include <netinet/tcp.h>
+#include <sys/sendfile.h>
+#include <sys/uio.h>
 #include "../transport/ServerTransport.hpp"
+#include "../utils/ObjectPool.hpp"
 
-TcpConnection::TcpConnection(const std::shared_ptr<Transport>& transport, int sock, const sockaddr_in &sockaddr, bool outgoing)
+/// Границы подстройки размера чтения
+static const size_t minReadSize = 1u << 10;
+static const size_t maxReadSize = 1u << 16;
+static const size_t initReadSize = 1u << 12;
+
+/// Фрагментов в одном вызове writev
+static const int iovMax = 64;
+
+/// Блок для данных, не поместившихся в свободное место буфера (свой у каждого потока)
+static thread_local char spillBlock[maxReadSize];
+
+TcpConnection::TcpConnection(const std::shared_ptr<Transport>& transport, int sock, bool outgoing)
 : Connection(transport)
 , _outgoing(outgoing)
 , _noRead(false)
 , _noWrite(false)
+, _readSize(initReadSize)
+, _syscalls(0)
+, _engineSyscalls(0)
+, _highWatermark(0)
+, _lowWatermark(0)
+, _throttled(false)
+, _readDeferred(false)
+, _idleTimeout(0)
+, _idleSocketBuffer(0)
+, _savedSocketBuffer(0)
+, _autoCork(false)
+, _corked(false)
 {
 	_sock = sock;
 
-	const int val = 1;
-	setsockopt(_sock, SOL_SOCKET, SO_REUSEADDR, &val, sizeof(val));
+	if (auto serverTransport = std::dynamic_pointer_cast<ServerTransport>(transport))
+	{
+		_highWatermark = serverTransport->highWatermark();
+		_lowWatermark = serverTransport->lowWatermark();
+
+		_inBuff.setAccount(serverTransport->memoryAccount());
+		_outBuff.setAccount(serverTransport->memoryAccount());
+
+		_idleTimeout = serverTransport->idleTimeout();
+		_idleSocketBuffer = serverTransport->idleSocketBuffer();
+
+		_autoCork = serverTransport->socketOptions().autoCork;
+	}
 
 	_closed = _sock < 0;
 
+	memset(&_sockaddr, 0, sizeof(_sockaddr));
+}
+
+TcpConnection::TcpConnection(const std::shared_ptr<Transport>& transport, int sock, const sockaddr_in &sockaddr, bool outgoing)
+: TcpConnection(transport, sock, outgoing)
+{
 	memcpy(&_sockaddr, &sockaddr, sizeof(_sockaddr));
 
+	// Имя еще не закреплено: наследник формирует его по-своему
+	if (_log.enabled(Log::Detail::DEBUG)) _log.debug("%s created", formatName().c_str());
+}
+
+TcpConnection::TcpConnection(const std::shared_ptr<Transport>& transport, int sock, const std::string& path, bool outgoing)
+: TcpConnection(transport, sock, outgoing)
+{
+	_sockaddr.sin_family = AF_UNIX;
+	_path = path;
+
+	// У UNIX-сокета нет сегментов, придерживать нечего
+	_autoCork = false;
+
+	if (_log.enabled(Log::Detail::DEBUG)) _log.debug("%s created", formatName().c_str());
+}
+
+std::string TcpConnection::formatName() const
+{
+	if (_sockaddr.sin_family == AF_UNIX)
+	{
+		return "TcpConnection[" + std::to_string(_sock) + "][unix:" + _path + "]";
+	}
+
 	char ip[64];
 	inet_ntop(AF_INET, &_sockaddr.sin_addr, ip, sizeof(ip));
 
-	_name = "TcpConnection[" + std::to_string(_sock) + "][" + ip + ":" + std::to_string(htons(_sockaddr.sin_port)) + "]";
-
-	_log.debug("%s created", name().c_str());
+	return "TcpConnection[" + std::to_string(_sock) + "][" + ip + ":" + std::to_string(htons(_sockaddr.sin_port)) + "]";
 }
 
 TcpConnection::~TcpConnection()
 {
+	// Дописываем остаток без контроля очереди: обработчик приостановки не должен получить разрушаемое соединение
+	_highWatermark = 0;
+
 	shutdown(_sock, SHUT_RD);
 	writeToSocket();
-	_log.debug("%s destroyed", name().c_str());
+	if (_log.enabled(Log::Detail::DEBUG)) _log.debug("%s destroyed", name().c_str());
 }
 
 void TcpConnection::watch(epoll_event &ev)
@@ -70,9 +137,10 @@ void TcpConnection::watch(epoll_event &ev)
 
 	ev.events |= EPOLLERR;
 
-	if (!_noRead)
+	if (!_noRead && !_throttled)
 	{
-		ev.events |= EPOLLIN | EPOLLRDNORM;
+		// Читать будет ядро (если умеет) - в общие буферы, сразу по приходу данных
+		ev.events |= EPOLLIN | EPOLLRDNORM | EventEngine::KERNEL_RECV;
 	}
 
 	ev.events |= EPOLLRDHUP;
@@ -89,10 +157,17 @@ void TcpConnection::watch(epoll_event &ev)
 
 bool TcpConnection::processing()
 {
-	_log.debug("Begin processing on %s", name().c_str());
+	if (_log.enabled(Log::Detail::DEBUG)) _log.debug("Begin processing on %s", name().c_str());
+
+	// Цикл вызван только сигналом простоя - без ввода-вывода
+	bool idle = false;
+	bool active = false;
 
 	do
 	{
+		idle = idle || isIdle();
+		active = active || isReadyForRead() || isReadyForWrite() || _readDeferred;
+
 		if (timeIsOut())
 		{
 			_timeout = true;
@@ -110,9 +185,9 @@ bool TcpConnection::processing()
 			writeToSocket();
 		}
 
-		if (isReadyForRead())
+		if (isReadyForRead() || _readDeferred)
 		{
-			readFromSocket();
+			readOrDefer();
 		}
 
 		if (hasDataForSend())
@@ -122,7 +197,11 @@ bool TcpConnection::processing()
 
 		ConnectionManager::rotateEvents(this->ptr());
 	}
-	while (isReadyForRead() || (isReadyForWrite() && hasDataForSend()) || wasFailure() || timeIsOut());
+	while (isReadyForRead() || (isReadyForWrite() && hasDataForSend()) || (_readDeferred && !_throttled) || wasFailure() || timeIsOut());
+
+	accountSyscalls();
+
+	reclaimMemory(idle && !active);
 
 	if (_timeout)
 	{
@@ -134,6 +213,8 @@ bool TcpConnection::processing()
 		_closed = true;
 	}
 
+	notifyReady();
+
 	if (_noRead)
 	{
 		if (!hasDataForSend())
@@ -149,7 +230,7 @@ bool TcpConnection::processing()
 	{
 		ConnectionManager::remove(ptr());
 
-		_log.debug("End processing on %s: Closed", name().c_str());
+		if (_log.enabled(Log::Detail::DEBUG)) _log.debug("End processing on %s: Closed", name().c_str());
 		return true;
 	}
 
@@ -160,18 +241,99 @@ bool TcpConnection::processing()
 		_closed = true;
 	}
 
-	_log.debug("End processing on %s: Ready", name().c_str());
+	if (_log.enabled(Log::Detail::DEBUG)) _log.debug("End processing on %s: Ready", name().c_str());
 	return true;
 }
 
 bool TcpConnection::write(const void* data, size_t length)
 {
-	return WriterConnection::write(data, length);
+	bool result = WriterConnection::write(data, length);
+	checkBackpressure();
+	return result;
+}
+
+bool TcpConnection::writeBorrowed(const void* data, size_t length)
+{
+	bool result = WriterConnection::writeBorrowed(data, length);
+	checkBackpressure();
+	return result;
+}
+
+bool TcpConnection::writeShared(const std::shared_ptr<const std::string>& payload)
+{
+	bool result = WriterConnection::writeShared(payload);
+	checkBackpressure();
+	return result;
+}
+
+bool TcpConnection::writeFile(const std::shared_ptr<const void>& holder, int fd, off_t offset, size_t length)
+{
+	bool result = WriterConnection::writeFile(holder, fd, offset, length);
+	checkBackpressure();
+	return result;
+}
+
+void TcpConnection::checkBackpressure()
+{
+	if (_highWatermark == 0)
+	{
+		return;
+	}
+
+	auto pending = _outBuff.dataLen();
+
+	bool throttle;
+	if (pending > _highWatermark)
+	{
+		throttle = true;
+	}
+	else if (pending <= _lowWatermark)
+	{
+		throttle = false;
+	}
+	else
+	{
+		return;
+	}
+
+	// Уведомляем только о пересечении порога
+	if (_throttled.exchange(throttle) == throttle)
+	{
+		return;
+	}
+
+	if (_log.enabled(Log::Detail::DEBUG)) _log.debug("%s reading on %s (%zu bytes waiting for send)", throttle ? "Suspend" : "Resume", name().c_str(), pending);
+
+	if (auto transport = std::dynamic_pointer_cast<ServerTransport>(_transport.lock()))
+	{
+		auto& metric = throttle ? transport->metricBackpressureOn : transport->metricBackpressureOff;
+		if (metric) metric->addValue();
+	}
+
+	if (_backpressureHandler)
+	{
+		_backpressureHandler(*this, throttle);
+	}
+}
+
+void TcpConnection::readOrDefer()
+{
+	if (_throttled)
+	{
+		_readDeferred = true;
+		return;
+	}
+
+	_readDeferred = false;
+	readFromSocket();
 }
 
 bool TcpConnection::writeToSocket()
 {
-	_log.trace("Write into socket on %s", name().c_str());
+	if (_log.enabled(Log::Detail::TRACE)) _log.trace("Write into socket on %s", name().c_str());
+
+	// Ответ уйдет несколькими вызовами (например, заголовок и файл) - склеиваем его в полные сегменты
+	cork(_outBuff.multipart(iovMax));
 
 	// Отправляем данные
 	for (;;)
@@ -184,7 +346,24 @@ bool TcpConnection::writeToSocket()
 			break;
 		}
 
-		ssize_t n = ::write(_sock, _outBuff.dataPtr(), _outBuff.dataLen());
+		ssize_t n;
+
+		auto fd = _outBuff.frontFd();
+		if (fd >= 0)
+		{
+			// Участок файла - напрямую из кеша страниц, минуя пространство пользователя
+			off_t offset = _outBuff.frontOffset();
+			n = ::sendfile(_sock, fd, &offset, _outBuff.frontLen());
+		}
+		else
+		{
+			// Все накопленные фрагменты (до участка файла) - одним вызовом
+			iovec iov[iovMax];
+			int count = _outBuff.fill(iov, iovMax);
+
+			n = ::writev(_sock, iov, count);
+		}
+		++_syscalls;
 		if (n == -1)
 		{
 			// Повторяем вызов прерваный сигналом
@@ -196,7 +375,7 @@ bool TcpConnection::writeToSocket()
 			// Нет возможности отправить сейчас
 			if (errno == EAGAIN)
 			{
-				return true;
+				break;
 			}
 
 			// Ошибка записи
@@ -206,71 +385,150 @@ bool TcpConnection::writeToSocket()
 			return false;
 		}
 
+		// Файл укоротился после постановки в очередь - отправить обещанное невозможно
+		if (n == 0 && fd >= 0)
+		{
+			_log.debug("Fail writing data (error: 'file truncated')");
+
+			_error = true;
+			return false;
+		}
+
 		_outBuff.skip(static_cast<size_t>(n));
 	}
 
+	// Отпускаем придержанный хвост
+	cork(false);
+
+	// Вне блокировки буфера: обработчик снятия приостановки может сразу писать в соединение
+	checkBackpressure();
+
 	return true;
 }
 
 bool TcpConnection::readFromSocket()
 {
-	_log.trace("Read from socket on %s", name().c_str());
+	if (_log.enabled(Log::Detail::TRACE)) _log.trace("Read from socket on %s", name().c_str());
 
-	// Пытаемся полностью заполнить буфер
-	for (;;)
+	size_t total = 0;
+
+	// Данные, уже полученные ядром в общие буферы, забираем без системных вызовов
+	bool kernel;
+	bool eof = false;
+	int error = 0;
+	{
+		std::lock_guard<std::recursive_mutex> guard(_inBuff.mutex());
+
+		auto before = _inBuff.dataLen();
+		kernel = ConnectionManager::engineOf(ptr()).received(this, _inBuff, eof, error);
+		total = _inBuff.dataLen() - before;
+	}
+
+	if (kernel)
 	{
-		size_t bytes_available = 0;
-		ioctl(_sock, FIONREAD, &bytes_available);
+		if (error != 0)
+		{
+			// Ошибка чтения
+			if (_log.enabled(Log::Detail::DEBUG)) _log.debug("Error '%s' while read on %s", strerror(error), name().c_str());
 
-		// Нет данных на сокете
-		if (bytes_available == 0)
+			_error = true;
+			return false;
+		}
+		if (eof)
 		{
-			// И больше не будет
-			if (isHalfHup() || isHup())
+			// Клиент отключился
+			if (_log.enabled(Log::Detail::DEBUG)) _log.debug("Client disconnected on %s", name().c_str());
+
+			_noRead = true;
+			if (total == 0)
 			{
-				_noRead = true;
+				return false;
 			}
-			break;
 		}
+		if (total > 0 && _log.enabled(Log::Detail::DEBUG)) _log.debug("Received %zu bytes (summary %zu) on %s", total, _inBuff.dataLen(), name().c_str());
+	}
+	else
+	{
+		// Читаем, пока сокет не опустеет: в свободное место буфера, а излишек - в дополнительный блок
+		for (;;)
+		{
+			std::lock_guard<std::recursive_mutex> guard(_inBuff.mutex());
 
-		std::lock_guard<std::recursive_mutex> guard(_inBuff.mutex());
+			_inBuff.prepare(_readSize);
 
-		_inBuff.prepare(bytes_available);
+			iovec iov[2];
+			iov[0].iov_base = _inBuff.spacePtr();
+			iov[0].iov_len = _inBuff.spaceLen();
+			iov[1].iov_base = spillBlock;
+			iov[1].iov_len = sizeof(spillBlock);
 
-		ssize_t n = ::read(_sock, _inBuff.spacePtr(), _inBuff.spaceLen());
-		if (n == -1)
-		{
-			// Повторяем вызов прерваный сигналом
-			if (errno == EINTR)
+			ssize_t n = ::readv(_sock, iov, 2);
+			++_syscalls;
+			if (n == -1)
 			{
-				continue;
+				// Повторяем вызов прерваный сигналом
+				if (errno == EINTR)
+				{
+					continue;
+				}
+
+				// Нет готовых данных - продолжаем ждать
+				if (errno == EAGAIN)
+				{
+					if (_log.enabled(Log::Detail::DEBUG)) _log.debug("No more read on %s", name().c_str());
+					break;
+				}
+
+				// Ошибка чтения
+				if (_log.enabled(Log::Detail::DEBUG)) _log.debug("Error '%s' while read on %s", strerror(errno), name().c_str());
+
+				_error = true;
+				return false;
 			}
-
-			// Нет готовых данных - продолжаем ждать
-			if (errno == EAGAIN)
+			if (n == 0)
 			{
-				_log.debug("No more read on %s", name().c_str());
+				// Клиент отключился
+				if (_log.enabled(Log::Detail::DEBUG)) _log.debug("Client disconnected on %s", name().c_str());
+
+				_noRead = true;
+				if (total == 0)
+				{
+					return false;
+				}
 				break;
 			}
 
-			// Ошибка чтения
-			_log.debug("Error '%s' while read on %s", strerror(errno), name().c_str());
+			auto length = static_cast<size_t>(n);
+			auto inSpace = std::min(length, iov[0].iov_len);
 
-			_error = true;
-			return false;
-		}
-		if (n == 0)
-		{
-			// Клиент отключился
-			_log.debug("Client disconnected on %s", name().c_str());
+			_inBuff.forward(inSpace);
+			if (length > inSpace)
+			{
+				_inBuff.write(spillBlock, length - inSpace);
+			}
 
-			_noRead = true;
-			return false;
+			total += length;
+
+			if (_log.enabled(Log::Detail::DEBUG)) _log.debug("Read %zd bytes (summary %zu) on %s", n, _inBuff.dataLen(), name().c_str());
+
+			// Прочитано меньше, чем было места, - сокет опустел, лишний вызов до EAGAIN не делаем
+			if (length < iov[0].iov_len + iov[1].iov_len)
+			{
+				// И больше данных не будет
+				if (isHalfHup() || isHup())
+				{
+					_noRead = true;
+				}
+				break;
+			}
 		}
 
-		_inBuff.forward(static_cast<size_t>(n));
+	}
 
-		_log.debug("Read %d bytes (summary %d) on %s", n, _inBuff.dataLen(), name().c_str());
+	// Размер следующих чтений - скользящее среднее объема за событие
+	if (total > 0)
+	{
+		_readSize = std::max(minReadSize, std::min(maxReadSize, (_readSize * 7 + total) / 8));
 	}
 
 	if (_inBuff.dataLen() > 0)
@@ -285,6 +543,108 @@ bool TcpConnection::readFromSocket()
 	return true;
 }
 
+void TcpConnection::addEngineSyscalls(size_t count)
+{
+	_engineSyscalls += count;
+}
+
+void TcpConnection::accountSyscalls()
+{
+	// Перевзвод прошлого цикла относим к этому
+	size_t syscalls = _syscalls + _engineSyscalls.exchange(0);
+	if (syscalls == 0)
+	{
+		return;
+	}
+
+	auto transport = std::dynamic_pointer_cast<ServerTransport>(_transport.lock());
+	if (transport)
+	{
+		if (transport->metricSyscallCount) transport->metricSyscallCount->addValue(syscalls);
+		if (transport->metricAvgSyscallPerSec) transport->metricAvgSyscallPerSec->addValue(syscalls);
+	}
+
+	_syscalls = 0;
+}
+
+void TcpConnection::reclaimMemory(bool idle)
+{
+	if (idle)
+	{
+		// Простаивающему соединению буферы ни к чему: хранилища - в общий пул до новых данных
+		_inBuff.release();
+		_outBuff.shrink();
+
+		trimSocketBuffer();
+	}
+	else
+	{
+		restoreSocketBuffer();
+
+		if (_idleTimeout.count() > 0 && !_closed)
+		{
+			if (!_idleTimer)
+			{
+				_idleTimer = makePooled<Timer>(
+					[wp = std::weak_ptr<Connection>(ptr())](){
+						if (auto connection = wp.lock())
+						{
+							ConnectionManager::idle(connection);
+						}
+					},
+					"Idle connection"
+				);
+			}
+			_idleTimer->restart(_idleTimeout);
+		}
+
+		// Соединение уходит в ожидание событий - излишки емкости ему сейчас не нужны
+		if (MemoryBudget::exceeded())
+		{
+			_inBuff.shrink();
+			_outBuff.shrink();
+		}
+	}
+
+	auto transport = std::dynamic_pointer_cast<ServerTransport>(_transport.lock());
+	if (transport && transport->metricMemoryUsage)
+	{
+		transport->metricMemoryUsage->setValue(transport->memoryAccount()->used());
+	}
+}
+
+void TcpConnection::trimSocketBuffer()
+{
+	if (_idleSocketBuffer == 0 || _savedSocketBuffer != 0 || _closed)
+	{
+		return;
+	}
+
+	int size = 0;
+	socklen_t length = sizeof(size);
+	if (getsockopt(_sock, SOL_SOCKET, SO_RCVBUF, &size, &length) != 0 || size / 2 <= _idleSocketBuffer)
+	{
+		return;
+	}
+
+	if (setsockopt(_sock, SOL_SOCKET, SO_RCVBUF, &_idleSocketBuffer, sizeof(_idleSocketBuffer)) == 0)
+	{
+		// Ядро сообщает удвоенный размер (с учетом служебных данных)
+		_savedSocketBuffer = size / 2;
+	}
+}
+
+void TcpConnection::restoreSocketBuffer()
+{
+	if (_savedSocketBuffer == 0)
+	{
+		return;
+	}
+
+	setsockopt(_sock, SOL_SOCKET, SO_RCVBUF, &_savedSocketBuffer, sizeof(_savedSocketBuffer));
+	_savedSocketBuffer = 0;
+}
+
 void TcpConnection::close()
 {
 	_noRead = true;
@@ -302,3 +662,44 @@ void TcpConnection::addErrorHandler(std::function<void(TcpConnection&)> handler)
 {
 	_errorHandler = std::move(handler);
 }
+
+void TcpConnection::notifyReady()
+{
+	if (_readyHandler && (_inBuff.dataLen() > 0 || _noRead || _closed))
+	{
+		auto handler = std::move(_readyHandler);
+		_readyHandler = nullptr;
+		handler(*this);
+	}
+}
+
+void TcpConnection::addReadyHandler(std::function<void(TcpConnection&)> handler)
+{
+	// Ждать нечего: данные уже прочитаны или их больше не будет
+	if (_inBuff.dataLen() > 0 || _noRead || _closed)
+	{
+		handler(*this);
+		return;
+	}
+	_readyHandler = std::move(handler);
+}
+
+void TcpConnection::addBackpressureHandler(std::function<void(TcpConnection&, bool)> handler)
+{
+	_backpressureHandler = std::move(handler);
+}
+
+void TcpConnection::cork(bool enable)
+{
+	if (!_autoCork || _corked == enable)
+	{
+		return;
+	}
+
+	const int val = enable ? 1 : 0;
+	if (setsockopt(_sock, IPPROTO_TCP, TCP_CORK, &val, sizeof(val)) == 0)
+	{
+		_corked = enable;
+	}
+	++_syscalls;
+}
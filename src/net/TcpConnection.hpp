@@ -35,12 +35,72 @@ protected:
 
 	sockaddr_in _sockaddr;
 
+	/// Путь UNIX-сокета (для соединений семейства AF_UNIX)
+	std::string _path;
+
 	/// Данных больше не будет
 	bool _noRead;
 
 	/// Писать больше не будем
 	bool _noWrite;
 
+	/// Размер чтения, подстраиваемый по среднему объему данных за событие
+	size_t _readSize;
+
+	/// Системные вызовы ввода-вывода за цикл обработки (для телеметрии)
+	size_t _syscalls;
+	/// Вызовы механизма событий при перевзводе (идет из release() - возможно, уже параллельно с обработкой)
+	std::atomic<size_t> _engineSyscalls;
+
+	/// Пороги исходящего буфера (0 - без ограничения)
+	size_t _highWatermark;
+	size_t _lowWatermark;
+
+	/// Чтение приостановлено: исходящий буфер выше верхнего порога
+	std::atomic_bool _throttled;
+
+	/// Чтение было отложено и его надо выполнить после снятия приостановки
+	bool _readDeferred;
+
+	std::function<void(TcpConnection&, bool)> _backpressureHandler;
+
+	/// Проверить пересечение порогов исходящего буфера
+	void checkBackpressure();
+
+	/// Прочитать из сокета или отложить чтение, если оно приостановлено
+	void readOrDefer();
+
+	std::string formatName() const override;
+
+	/// Учесть системные вызовы цикла обработки в телеметрии транспорта
+	void accountSyscalls();
+
+	/// Простой, после которого память соединения возвращается (0 - не отслеживать)
+	std::chrono::milliseconds _idleTimeout;
+	std::shared_ptr<Timer> _idleTimer;
+
+	/// Размер приемного буфера сокета при простое и сохраненный прежний (0 - не уменьшался)
+	int _idleSocketBuffer;
+	int _savedSocketBuffer;
+
+	/// Уменьшить приемный буфер сокета простаивающего соединения / вернуть прежний
+	void trimSocketBuffer();
+	void restoreSocketBuffer();
+
+	/// Вернуть неиспользуемую память буферов (простой или превышение бюджета),
+	/// перезапустить отслеживание простоя после активности и обновить телеметрию памяти
+	void reclaimMemory(bool idle);
+
+	/// Общая часть конструкторов: адрес задает вызывающий
+	TcpConnection(const std::shared_ptr<Transport>& transport, int fd, bool outgoing);
+
+	/// Придерживать неполные сегменты на время многочастной записи (TCP_CORK)
+	bool _autoCork;
+	bool _corked;
+
+	/// Включить/снять придерживание (если оно разрешено для соединения)
+	void cork(bool enable);
+
 	virtual bool readFromSocket();
 
 	virtual bool writeToSocket();
@@ -48,6 +108,12 @@ protected:
 	std::function<void(TcpConnection&, const std::shared_ptr<Context>&)> _completeHandler;
 	std::function<void(TcpConnection&)> _errorHandler;
 
+	/// Одноразовый обработчик готовности: во входном буфере есть данные или чтения больше не будет
+	std::function<void(TcpConnection&)> _readyHandler;
+
+	/// Вызвать обработчик готовности, если дождались (в конце цикла обработки)
+	void notifyReady();
+
 public:
 	TcpConnection() = delete;
 	TcpConnection(const TcpConnection&) = delete;
@@ -56,6 +122,7 @@ public:
 	TcpConnection& operator=(TcpConnection&& tmp) noexcept = delete;
 
 	TcpConnection(const std::shared_ptr<Transport>& transport, int fd, const sockaddr_in& cliaddr, bool outgoing);
+	TcpConnection(const std::shared_ptr<Transport>& transport, int fd, const std::string& path, bool outgoing);
 	~TcpConnection() override;
 
 	bool noRead() const
@@ -72,21 +139,39 @@ public:
 
 	bool processing() override;
 
+	void addEngineSyscalls(size_t count) override;
+
 	void addCompleteHandler(std::function<void(TcpConnection&, const std::shared_ptr<Context>&)>);
 	void addErrorHandler(std::function<void(TcpConnection&)>);
 
+	/// Дождаться данных во входном буфере или закрытия (ожидание сопрограммы co_await).
+	/// Вызывать из обработки этого соединения, когда оно захвачено, - иначе возможна гонка с processing()
+	void addReadyHandler(std::function<void(TcpConnection&)>);
+
+	/// Обработчик пересечения порогов исходящего буфера (true - выше верхнего, false - ниже нижнего)
+	void addBackpressureHandler(std::function<void(TcpConnection&, bool)>);
+
+	bool isThrottled() const
+	{
+		return _throttled;
+	}
+
+	// Обработчики вызываются через копию: соединение, возвращенное в пул из обработчика,
+	// может получить новые обработчики в другом потоке, пока текущий еще выполняется
 	void onComplete()
 	{
-		if (_completeHandler)
+		auto handler = _completeHandler;
+		if (handler)
 		{
-			_completeHandler(*this, _context);
+			handler(*this, _context);
 		}
 	}
 	void onError()
 	{
-		if (_errorHandler)
+		auto handler = _errorHandler;
+		if (handler)
 		{
-			_errorHandler(*this);
+			handler(*this);
 		}
 	}
 
@@ -98,4 +183,7 @@ public:
 	void close() override;
 
 	bool write(const void* data, size_t length) override;
+	bool writeBorrowed(const void* data, size_t length);
+	bool writeShared(const std::shared_ptr<const std::string>& payload);
+	bool writeFile(const std::shared_ptr<const void>& holder, int fd, off_t offset, size_t length);
 };
@@ -27,11 +27,32 @@
 #include "../utils/Daemon.hpp"
 #include "../thread/Thread.hpp"
 #include "HostnameResolver.hpp"
+#include "../utils/ObjectPool.hpp"
+
+static std::string resolvingError(int herr, const std::string& host)
+{
+	switch (herr)
+	{
+		case HOST_NOT_FOUND:
+			return "Host not found " + host;
+		case NO_ADDRESS:
+			return "The requested name ("  + host + ") does not have an IP address";
+		case NO_RECOVERY:
+			return "A non-recoverable name server error occurred while resolving '"  + host + "'";
+		case TRY_AGAIN:
+			return "A temporary error occurred on an authoritative name server while resolving '"  + host + "'";
+		default:
+			return "Unknown error code from resolver for '" + host + "'";
+	}
+}
 
 TcpConnector::TcpConnector(const std::shared_ptr<ClientTransport>& transport, const std::string& hostname, std::uint16_t port)
 : Connector(transport)
 , _host(hostname)
 , _port(port)
+, _sockaddr()
+, _resolving(false)
+, _resolveStarted(false)
 {
 	// Создаем сокет
 	_sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
@@ -50,25 +71,67 @@ TcpConnector::TcpConnector(const std::shared_ptr<ClientTransport>& transport, co
 	int rrc = fcntl(_sock, F_GETFL, 0);
 	fcntl(_sock, F_SETFL, rrc | O_NONBLOCK);
 
-	auto resolvingResult = HostnameResolver::resolve(_host);
-	switch (std::get<0>(resolvingResult))
+	int herr;
+	if (!HostnameResolver::cached(_host, herr, _addresses))
 	{
-		case 0: break;
-		case HOST_NOT_FOUND:
-			throw std::runtime_error("Host not found " + _host);
-		case NO_ADDRESS:
-			throw std::runtime_error("The requested name ("  + _host + ") does not have an IP address");
-		case NO_RECOVERY:
-			throw std::runtime_error("A non-recoverable name server error occurred while resolving '"  + _host + "'");
-		case TRY_AGAIN:
-			throw std::runtime_error("A temporary error occurred on an authoritative name server while resolving '"  + _host + "'");
+		// Адреса неизвестны - запрос к серверу имен отправим при первой обработке:
+		// еще не подключенный сокет сразу после регистрации сообщает о HUP и готовности к записи
+		_resolving = true;
+		_addressesIterator = _addresses.end();
+
+		_log.debug("%s created (resolving)", name().c_str());
+		return;
+	}
+
+	if (herr != 0)
+	{
+		throw std::runtime_error(resolvingError(herr, _host));
+	}
+
+	_addressesIterator = _addresses.begin();
+
+	switch (connectNext())
+	{
+		case 1:
+			throw std::runtime_error(std::string("Too fast connect to ") + _host);
+		case -1:
+			throw std::runtime_error("Can't connect to '" + _host + "' ← " + strerror(errno));
 		default:
-			throw std::runtime_error("Unknown error code from gethostbyname_r for '" + _host + "'");
+			break;
 	}
 
-	_addresses = std::move(std::get<1>(resolvingResult));
+	_log.debug("%s created", name().c_str());
+}
+
+TcpConnector::TcpConnector(const std::shared_ptr<ClientTransport>& transport)
+: Connector(transport)
+, _port(0)
+, _addressesIterator(_addresses.end())
+, _sockaddr()
+, _resolving(false)
+, _resolveStarted(false)
+{
+}
+
+TcpConnector::~TcpConnector()
+{
+	_log.debug("%s destroyed", name().c_str());
+}
+
+void TcpConnector::watch(epoll_event& ev)
+{
+	ev.data.ptr = this;
+	ev.events = 0;
+
+	ev.events |= EPOLLET; // Ждем появления НОВЫХ событий
+
+	ev.events |= EPOLLERR;
+	ev.events |= EPOLLOUT;
+}
 
-	for (_addressesIterator = _addresses.begin() ; _addressesIterator != _addresses.end(); ++_addressesIterator)
+int TcpConnector::connectNext()
+{
+	for ( ; _addressesIterator != _addresses.end(); ++_addressesIterator)
 	{
 		const auto& addr = *_addressesIterator;
 
@@ -84,11 +147,11 @@ TcpConnector::TcpConnector(const std::shared_ptr<ClientTransport>& transport, co
 		// Задаем порт
 		_sockaddr.sin_port = htons(_port);
 
-		// Подключаемся
 		again:
+		// Подключаемся
 		if (connect(_sock, reinterpret_cast<sockaddr*>(&_sockaddr), sizeof(_sockaddr)) == 0)
 		{
-			throw std::runtime_error(std::string("Too fast connect to ") + _host);
+			return 1;
 		}
 
 		// Вызов прерван сигналом - повторяем
@@ -100,7 +163,7 @@ TcpConnector::TcpConnector(const std::shared_ptr<ClientTransport>& transport, co
 		// Установление соединения в процессе
 		if (errno == EINPROGRESS)
 		{
-			goto end;
+			return 0;
 		}
 
 		// Нет доступных пар адрес-порт для исходящего соединения
@@ -111,34 +174,14 @@ TcpConnector::TcpConnector(const std::shared_ptr<ClientTransport>& transport, co
 		}
 	}
 
-	throw std::runtime_error("Can't connect to '" + _host + "' ← " + strerror(errno));
-
-	end:
-
-	_log.debug("%s created", name().c_str());
-}
-
-TcpConnector::~TcpConnector()
-{
-	_log.debug("%s destroyed", name().c_str());
-}
-
-void TcpConnector::watch(epoll_event& ev)
-{
-	ev.data.ptr = this;
-	ev.events = 0;
-
-	ev.events |= EPOLLET; // Ждем появления НОВЫХ событий
-
-	ev.events |= EPOLLERR;
-	ev.events |= EPOLLOUT;
+	return -1;
 }
 
 bool TcpConnector::processing()
 {
 	_log.debug("Begin processing on %s", name().c_str());
 
-	std::lock_guard<std::mutex> guard(_mutex);
+	std::lock_guard<std::recursive_mutex> guard(_mutex);
 
 	if (Daemon::shutingdown())
 	{
@@ -147,6 +190,30 @@ bool TcpConnector::processing()
 		return false;
 	}
 
+	if (_resolving)
+	{
+		if (!_resolveStarted)
+		{
+			_resolveStarted = true;
+
+			// Обработчик может быть вызван сразу (ответ уже в кеше) - мьютекс рекурсивный
+			HostnameResolver::resolve(
+				_host,
+				[wp = std::weak_ptr<Connection>(ptr())](int herr, const std::vector<in_addr>& addresses)
+				{
+					auto iam = std::dynamic_pointer_cast<TcpConnector>(wp.lock());
+					if (iam)
+					{
+						iam->onResolved(herr, addresses);
+					}
+				}
+			);
+		}
+
+		_log.debug("End processing on %s: Resolving", name().c_str());
+		return true;
+	}
+
 	int result;
 	socklen_t result_len = sizeof(result);
 
@@ -154,100 +221,131 @@ bool TcpConnector::processing()
 	{
 		if (result == 0)
 		{
-			connected:
-
-			_log.debug("End processing on %s: Success", name().c_str());
-
-			try
+			// Нет ошибки, но и соединение может быть еще не установлено
+			sockaddr_in peer{};
+			socklen_t peerLen = sizeof(peer);
+			if (getpeername(_sock, reinterpret_cast<sockaddr*>(&peer), &peerLen) == 0)
 			{
-				std::shared_ptr<Transport> transport = _transport.lock();
-				if (!transport)
-				{
-					throw std::runtime_error("Lost transport");
-				}
+				return established();
+			}
+			if (errno == ENOTCONN && _addressesIterator != _addresses.end())
+			{
+				_log.debug("End processing on %s: In progress", name().c_str());
+				return true;
+			}
+		}
+	}
 
-				auto newConnection = createConnection(transport);
+	if (_addressesIterator != _addresses.end())
+	{
+		++_addressesIterator;
+	}
 
-				ConnectionManager::remove(ptr());
+	switch (connectNext())
+	{
+		case 1:
+			// Подключились сразу?!
+			return established();
 
-				_sock = -1;
-				_closed = true;
+		case 0:
+			_log.debug("End processing on %s: In progress", name().c_str());
+			return true;
 
-				newConnection->setTtl(std::chrono::seconds(60));
+		default:
+			break;
+	}
 
-				ConnectionManager::add(newConnection);
+	_log.debug("End processing on %s: Fail '%s'", name().c_str(), strerror(result));
 
-				onConnect(newConnection);
+	fail();
+	return false;
+}
 
-				return true;
-			}
-			catch (const std::exception& exception)
-			{
-				onError();
-				shutdown(_sock, SHUT_RDWR);
-				::close(_sock);
-				return false;
-			}
-		}
+void TcpConnector::onResolved(int herr, const std::vector<in_addr>& addresses)
+{
+	std::lock_guard<std::recursive_mutex> guard(_mutex);
+
+	if (_closed || !_resolving)
+	{
+		return;
 	}
 
-	for ( ; _addressesIterator != _addresses.end(); ++_addressesIterator)
+	_resolving = false;
+
+	if (herr != 0)
 	{
-		const auto& addr = *_addressesIterator;
+		_log.debug("%s: %s", name().c_str(), resolvingError(herr, _host).c_str());
+		fail();
+		return;
+	}
 
-		// Инициализируем структуру нулями
-		memset(&_sockaddr, 0, sizeof(_sockaddr));
+	_addresses = addresses;
+	_addressesIterator = _addresses.begin();
 
-		// Задаем семейство сокетов (IPv4)
-		_sockaddr.sin_family = AF_INET;
+	switch (connectNext())
+	{
+		case 1:
+			established();
+			return;
 
-		// Задаем хост
-		memcpy(&_sockaddr.sin_addr.s_addr, &addr, sizeof(_sockaddr.sin_addr.s_addr));
+		case 0:
+			_log.debug("%s: Connecting", name().c_str());
+			return;
 
-		// Задаем порт
-		_sockaddr.sin_port = htons(_port);
+		default:
+			_log.debug("%s: Can't connect ← %s", name().c_str(), strerror(errno));
+			fail();
+			return;
+	}
+}
 
-		again:
-		// Подключаемся
-		if (connect(_sock, reinterpret_cast<sockaddr*>(&_sockaddr), sizeof(_sockaddr)) == 0)
-		{
-			// Подключились сразу?!
-			goto connected;
-		}
+bool TcpConnector::established()
+{
+	_log.debug("End processing on %s: Success", name().c_str());
 
-		// Вызов прерван сигналом - повторяем
-		if (errno == EINTR)
+	try
+	{
+		std::shared_ptr<Transport> transport = _transport.lock();
+		if (!transport)
 		{
-			goto again;
+			throw std::runtime_error("Lost transport");
 		}
 
-		// Установление соединения в процессе
-		if (errno == EINPROGRESS)
-		{
-			_log.debug("End processing on %s: In progress", name().c_str());
-			return true;
-		}
+		auto newConnection = createConnection(transport);
 
-		// Нет доступных пар адрес-порт для исходящего соединения
-		if (errno == EADDRNOTAVAIL)
-		{
-			Thread::self()->yield([]{});
-			goto again;
-		}
-	}
+		ConnectionManager::remove(ptr());
 
-	_log.debug("End processing on %s: Fail '%s'", name().c_str(), strerror(result));
+		_sock = -1;
+		_closed = true;
+
+		newConnection->setTtl(std::chrono::seconds(60));
+
+		ConnectionManager::add(newConnection);
 
+		onConnect(newConnection);
+
+		return true;
+	}
+	catch (const std::exception& exception)
+	{
+		onError();
+		shutdown(_sock, SHUT_RDWR);
+		::close(_sock);
+		return false;
+	}
+}
+
+void TcpConnector::fail()
+{
 	ConnectionManager::remove(ptr());
 
 	shutdown(_sock, SHUT_RDWR);
 	onError();
-	return false;
 }
 
 std::shared_ptr<TcpConnection> TcpConnector::createConnection(const std::shared_ptr<Transport>& transport)
 {
-	return std::make_shared<TcpConnection>(transport, _sock, _sockaddr, true);
+	return makePooled<TcpConnection>(transport, _sock, _sockaddr, true);
 }
 
 void TcpConnector::addConnectedHandler(std::function<void(const std::shared_ptr<TcpConnection>&)> handler)
@@ -35,18 +35,32 @@ class TcpConnector : public Connector
 protected:
 	std::string _host;
 	std::uint16_t _port;
-	std::mutex _mutex;
+	std::recursive_mutex _mutex;
 
 	std::vector<in_addr> _addresses;
 	std::vector<in_addr>::const_iterator _addressesIterator;
 
 	sockaddr_in _sockaddr;
 
+	/// Адреса еще не известны - ждем ответа сервера имен
+	bool _resolving;
+	bool _resolveStarted;
+
+	/// Подключиться к очередному адресу: 1 - сразу, 0 - в процессе, -1 - адреса исчерпаны
+	int connectNext();
+
+	void onResolved(int herr, const std::vector<in_addr>& addresses);
+	bool established();
+	void fail();
+
 	virtual std::shared_ptr<TcpConnection> createConnection(const std::shared_ptr<Transport>& transport);
 
 	std::function<void(const std::shared_ptr<TcpConnection>&)> _connectHandler;
 	std::function<void()> _errorHandler;
 
+	/// Для наследников, подключающих сокет другого семейства
+	explicit TcpConnector(const std::shared_ptr<ClientTransport>& transport);
+
 public:
 	TcpConnector() = delete;
 	TcpConnector(const TcpConnector&) = delete;
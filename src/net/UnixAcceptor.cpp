@@ -0,0 +1,140 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// UnixAcceptor.cpp
+
+
+#include "UnixAcceptor.hpp"
+
+#include <cstring>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "ConnectionManager.hpp"
+#include "TcpConnection.hpp"
+#include "UnixAddress.hpp"
+#include "../utils/ObjectPool.hpp"
+
+UnixAcceptor::UnixAcceptor(const std::shared_ptr<ServerTransport>& transport, const std::string& path, int backlog, mode_t mode)
+: TcpAcceptor(transport, backlog)
+, _path(path)
+, _inode(0)
+{
+	sockaddr_un servaddr{};
+	socklen_t addrlen = UnixAddress::fill(_path, servaddr);
+
+	// Создаем сокет (сразу неблокирующий)
+	_sock = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (_sock == -1)
+	{
+		throw std::runtime_error(std::string("Can't create socket ← ") + strerror(errno));
+	}
+
+	_name = "UnixAcceptor[" + std::to_string(_sock) + "][" + _path + "]";
+
+	if (!UnixAddress::abstract(_path))
+	{
+		// Файл сокета, оставшийся от прошлого запуска, мешает связыванию
+		struct stat st{};
+		if (lstat(_path.c_str(), &st) == 0)
+		{
+			if (!S_ISSOCK(st.st_mode))
+			{
+				throw std::runtime_error("Can't bind socket ← '" + _path + "' exists and isn't a socket");
+			}
+
+			// Удаляем, только если его никто не слушает: живой сокет другого процесса не отнимаем
+			int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+			if (probe == -1)
+			{
+				throw std::runtime_error(std::string("Can't create socket ← ") + strerror(errno));
+			}
+			int rc = connect(probe, reinterpret_cast<sockaddr*>(&servaddr), addrlen);
+			int error = errno;
+			::close(probe);
+
+			if (rc == 0 || error != ECONNREFUSED)
+			{
+				throw std::runtime_error("Can't bind socket ← '" + _path + "' is already in use" + (rc == 0 ? "" : std::string(" (") + strerror(error) + ")"));
+			}
+			unlink(_path.c_str());
+		}
+	}
+
+	// Связываем сокет с локальным адресом
+	if (bind(_sock, reinterpret_cast<sockaddr*>(&servaddr), addrlen) != 0)
+	{
+		throw std::runtime_error(std::string("Can't bind socket ← ") + strerror(errno));
+	}
+
+	if (!UnixAddress::abstract(_path))
+	{
+		if (mode != 0 && chmod(_path.c_str(), mode) != 0)
+		{
+			throw std::runtime_error(std::string("Can't change mode of socket ← ") + strerror(errno));
+		}
+
+		struct stat st{};
+		if (stat(_path.c_str(), &st) == 0)
+		{
+			_inode = st.st_ino;
+		}
+	}
+
+	// Преобразуем сокет в пассивный (слушающий) и устанавливаем длину очереди соединений
+	if (listen(_sock, _backlog) != 0)
+	{
+		throw std::runtime_error(std::string("Can't listen socket ← ") + strerror(errno));
+	}
+
+	_log.debug("%s created", name().c_str());
+}
+
+UnixAcceptor::~UnixAcceptor()
+{
+	if (_inode != 0)
+	{
+		struct stat st{};
+		if (stat(_path.c_str(), &st) == 0 && st.st_ino == _inode)
+		{
+			unlink(_path.c_str());
+		}
+	}
+}
+
+void UnixAcceptor::tune(int sock)
+{
+	_socketOptions.apply(sock, false);
+}
+
+void UnixAcceptor::createConnection(int sock, const sockaddr_in&)
+{
+	auto transport = std::dynamic_pointer_cast<ServerTransport>(_transport.lock());
+	if (!transport)
+	{
+		return;
+	}
+
+	// Клиентские UNIX-сокеты обычно безымянны - соединение называем по слушающему
+	auto newConnection = makePooled<TcpConnection>(transport, sock, _path, false);
+
+	newConnection->setTtl(std::chrono::seconds(5));
+
+	ConnectionManager::add(newConnection->ptr());
+
+	transport->metricConnectCount->addValue();
+}
@@ -0,0 +1,54 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// UnixAcceptor.hpp
+
+
+#pragma once
+
+#include "TcpAcceptor.hpp"
+
+#include <sys/types.h>
+
+class UnixAcceptor : public TcpAcceptor
+{
+private:
+	std::string _path;
+
+	/// Inode созданного файла сокета: чужой файл (например, нового процесса) не удаляем
+	ino_t _inode;
+
+	void tune(int sock) override;
+
+public:
+	UnixAcceptor() = delete;
+	UnixAcceptor(const UnixAcceptor&) = delete;
+	UnixAcceptor& operator=(const UnixAcceptor&) = delete;
+	UnixAcceptor(UnixAcceptor&& tmp) noexcept = delete;
+	UnixAcceptor& operator=(UnixAcceptor&& tmp) noexcept = delete;
+
+	UnixAcceptor(const std::shared_ptr<ServerTransport>& transport, const std::string& path, int backlog, mode_t mode);
+	~UnixAcceptor() override;
+
+	void createConnection(int sock, const sockaddr_in& cliaddr) override;
+
+	static std::shared_ptr<Connection> create(const std::shared_ptr<ServerTransport>& transport, const std::string& path, int backlog, mode_t mode)
+	{
+		return std::make_shared<UnixAcceptor>(transport, path, backlog, mode);
+	}
+};
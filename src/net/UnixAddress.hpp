@@ -0,0 +1,65 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// UnixAddress.hpp
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/// Адрес UNIX-сокета. Путь, начинающийся с '@', - имя в абстрактном пространстве (без файла)
+class UnixAddress final
+{
+public:
+	UnixAddress() = delete;
+
+	static bool abstract(const std::string& path)
+	{
+		return !path.empty() && path[0] == '@';
+	}
+
+	/// Заполнить структуру адреса и вернуть ее значимую длину
+	static socklen_t fill(const std::string& path, sockaddr_un& addr)
+	{
+		if (path.empty() || path.size() >= sizeof(addr.sun_path))
+		{
+			throw std::runtime_error("Bad unix socket path '" + path + "'");
+		}
+
+		memset(&addr, 0, sizeof(addr));
+
+		addr.sun_family = AF_UNIX;
+
+		memcpy(addr.sun_path, path.data(), path.size());
+
+		if (abstract(path))
+		{
+			// Абстрактное имя не завершается нулем: значима ровно указанная длина
+			addr.sun_path[0] = '\0';
+			return static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + path.size());
+		}
+
+		return static_cast<socklen_t>(sizeof(addr));
+	}
+};
@@ -0,0 +1,70 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// UnixConnector.cpp
+
+
+#include "UnixConnector.hpp"
+
+#include <cstring>
+#include "UnixAddress.hpp"
+#include "../utils/ObjectPool.hpp"
+
+UnixConnector::UnixConnector(const std::shared_ptr<ClientTransport>& transport, const std::string& path)
+: TcpConnector(transport)
+, _path(path)
+{
+	sockaddr_un addr{};
+	socklen_t addrlen = UnixAddress::fill(_path, addr);
+
+	// Создаем сокет (сразу неблокирующий)
+	_sock = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (_sock == -1)
+	{
+		throw std::runtime_error(std::string("Can't create socket ← ") + strerror(errno));
+	}
+	_closed = false;
+
+	_name = "UnixConnector[" + std::to_string(_sock) + "][" + _path + "]";
+
+	// Локальное подключение обычно устанавливается сразу;
+	// о готовности все равно узнаем по событию записи, как и для TCP
+	while (connect(_sock, reinterpret_cast<sockaddr*>(&addr), addrlen) != 0)
+	{
+		// Вызов прерван сигналом - повторяем
+		if (errno == EINTR)
+		{
+			continue;
+		}
+
+		if (errno == EINPROGRESS)
+		{
+			break;
+		}
+
+		// Переполненная очередь слушающего сокета возвращает EAGAIN - для вызывающего это отказ
+		throw std::runtime_error("Can't connect to '" + _path + "' ← " + strerror(errno));
+	}
+
+	_log.debug("%s created", name().c_str());
+}
+
+std::shared_ptr<TcpConnection> UnixConnector::createConnection(const std::shared_ptr<Transport>& transport)
+{
+	return makePooled<TcpConnection>(transport, _sock, _path, true);
+}
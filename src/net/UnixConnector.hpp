@@ -0,0 +1,47 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// UnixConnector.hpp
+
+
+#pragma once
+
+#include "TcpConnector.hpp"
+
+class UnixConnector : public TcpConnector
+{
+protected:
+	std::string _path;
+
+	std::shared_ptr<TcpConnection> createConnection(const std::shared_ptr<Transport>& transport) override;
+
+public:
+	UnixConnector() = delete;
+	UnixConnector(const UnixConnector&) = delete;
+	UnixConnector& operator=(const UnixConnector&) = delete;
+	UnixConnector(UnixConnector&& tmp) noexcept = delete;
+	UnixConnector& operator=(UnixConnector&& tmp) noexcept = delete;
+
+	UnixConnector(const std::shared_ptr<ClientTransport>& transport, const std::string& path);
+	~UnixConnector() override = default;
+
+	static std::shared_ptr<UnixConnector> create(const std::shared_ptr<ClientTransport>& transport, const std::string& path)
+	{
+		return std::make_shared<UnixConnector>(transport, path);
+	}
+};
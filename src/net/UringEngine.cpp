@@ -0,0 +1,873 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// UringEngine.cpp
+
+
+#include "UringEngine.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include "../utils/Buffer.hpp"
+
+static int io_uring_setup(unsigned entries, io_uring_params* params)
+{
+	return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int io_uring_enter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+	return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+static int io_uring_register(int fd, unsigned opcode, void* arg, unsigned nrArgs)
+{
+	return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nrArgs));
+}
+
+UringEngine::UringEngine(int poolSize)
+: _sqRing(MAP_FAILED)
+, _sqRingSize(0)
+, _cqRing(MAP_FAILED)
+, _cqRingSize(0)
+, _sqes(static_cast<io_uring_sqe*>(MAP_FAILED))
+, _sqesSize(0)
+, _sleeping(false)
+, _longSleep(false)
+, _queued(0)
+, _activeUntil()
+, _wakeFd(-1)
+, _wakeValue(0)
+, _wakeArmed(false)
+, _woken(false)
+, _timeout()
+, _lastStreamId(0)
+, _acceptSupported(false)
+, _recvSupported(false)
+, _bufRing(MAP_FAILED)
+, _bufRingSize(0)
+, _buffers(static_cast<char*>(MAP_FAILED))
+, _buffersSize(0)
+, _bufTail(0)
+, _freeBuffers(0)
+{
+	io_uring_params params{};
+
+	_ringFd = io_uring_setup(static_cast<unsigned>(poolSize), &params);
+	if (_ringFd < 0)
+	{
+		throw std::runtime_error(std::string("Can't setup io_uring ← ") + strerror(errno));
+	}
+
+	// Нужны однократный poll, его отмена и таймаут ожидания
+	{
+		const size_t probeSize = sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op);
+		std::unique_ptr<char[]> buffer(new char[probeSize]());
+		auto probe = reinterpret_cast<io_uring_probe*>(buffer.get());
+		if (io_uring_register(_ringFd, IORING_REGISTER_PROBE, probe, 256) < 0)
+		{
+			close(_ringFd);
+			throw std::runtime_error(std::string("Can't probe io_uring ← ") + strerror(errno));
+		}
+		for (auto op : {IORING_OP_POLL_ADD, IORING_OP_POLL_REMOVE, IORING_OP_TIMEOUT})
+		{
+			if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED))
+			{
+				close(_ringFd);
+				throw std::runtime_error("Kernel's io_uring does not support needed operations");
+			}
+		}
+
+		// Прием и чтение силами ядра - если есть нужные операции, иначе только наблюдение
+		auto supported = [probe](unsigned op)
+		{
+			return op <= probe->last_op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED) != 0;
+		};
+		_acceptSupported = supported(IORING_OP_ACCEPT) && supported(IORING_OP_ASYNC_CANCEL);
+		_recvSupported = supported(IORING_OP_RECV) && supported(IORING_OP_ASYNC_CANCEL);
+
+		// Будить реактор через eventfd, который читает само ядро. Без этого операции отправляются сразу.
+		// Блокирующий: неблокирующий ядро не ждет, а сразу завершает чтение с EAGAIN
+		if (supported(IORING_OP_READ))
+		{
+			_wakeFd = eventfd(0, EFD_CLOEXEC);
+		}
+	}
+
+	_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+	if (params.features & IORING_FEAT_SINGLE_MMAP)
+	{
+		_sqRingSize = _cqRingSize = std::max(_sqRingSize, _cqRingSize);
+	}
+
+	_sqRing = mmap(nullptr, _sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_SQ_RING);
+	if (_sqRing == MAP_FAILED)
+	{
+		unmap();
+		throw std::runtime_error(std::string("Can't map io_uring submission ring ← ") + strerror(errno));
+	}
+
+	if (params.features & IORING_FEAT_SINGLE_MMAP)
+	{
+		_cqRing = _sqRing;
+	}
+	else
+	{
+		_cqRing = mmap(nullptr, _cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_CQ_RING);
+		if (_cqRing == MAP_FAILED)
+		{
+			unmap();
+			throw std::runtime_error(std::string("Can't map io_uring completion ring ← ") + strerror(errno));
+		}
+	}
+
+	_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+	_sqes = static_cast<io_uring_sqe*>(mmap(nullptr, _sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_SQES));
+	if (_sqes == MAP_FAILED)
+	{
+		unmap();
+		throw std::runtime_error(std::string("Can't map io_uring submission entries ← ") + strerror(errno));
+	}
+
+	auto sq = static_cast<char*>(_sqRing);
+	_sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+	_sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+	_sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+	_sqEntries = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_entries);
+	_sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+	auto cq = static_cast<char*>(_cqRing);
+	_cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+	_cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+	_cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+	_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+	// Кольцо предоставленных буферов появилось в ядре вместе с многократным accept:
+	// без него не принимаем и не читаем силами ядра (многократный recv проверяется при первом запуске)
+	if ((_acceptSupported || _recvSupported) && !setupBuffers())
+	{
+		_acceptSupported = false;
+		_recvSupported = false;
+	}
+}
+
+UringEngine::~UringEngine()
+{
+	// Принятые, но не разобранные подключения закрываем
+	for (auto& i : _streams)
+	{
+		for (auto sock : i.second.socks)
+		{
+			close(sock);
+		}
+	}
+
+	unmap();
+}
+
+void UringEngine::unmap()
+{
+	// Закрытие кольца снимает и регистрацию буферов
+	if (_ringFd >= 0)
+	{
+		close(_ringFd);
+		_ringFd = -1;
+	}
+	if (_wakeFd >= 0)
+	{
+		close(_wakeFd);
+		_wakeFd = -1;
+	}
+	if (_buffers != MAP_FAILED)
+	{
+		munmap(_buffers, _buffersSize);
+		_buffers = static_cast<char*>(MAP_FAILED);
+	}
+	if (_bufRing != MAP_FAILED)
+	{
+		munmap(_bufRing, _bufRingSize);
+		_bufRing = MAP_FAILED;
+	}
+	if (_sqes != MAP_FAILED)
+	{
+		munmap(_sqes, _sqesSize);
+		_sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+	}
+	if (_cqRing != MAP_FAILED && _cqRing != _sqRing)
+	{
+		munmap(_cqRing, _cqRingSize);
+	}
+	_cqRing = MAP_FAILED;
+	if (_sqRing != MAP_FAILED)
+	{
+		munmap(_sqRing, _sqRingSize);
+		_sqRing = MAP_FAILED;
+	}
+}
+
+bool UringEngine::setupBuffers()
+{
+#ifdef IORING_RECV_MULTISHOT
+	_bufRingSize = bufferCount * sizeof(io_uring_buf);
+	_bufRing = mmap(nullptr, _bufRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (_bufRing == MAP_FAILED)
+	{
+		return false;
+	}
+
+	_buffersSize = static_cast<size_t>(bufferCount) * bufferSize;
+	_buffers = static_cast<char*>(mmap(nullptr, _buffersSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0));
+	if (_buffers == MAP_FAILED)
+	{
+		return false;
+	}
+
+	io_uring_buf_reg reg{};
+	reg.ring_addr = reinterpret_cast<uint64_t>(_bufRing);
+	reg.ring_entries = bufferCount;
+	reg.bgid = bufferGroup;
+	if (io_uring_register(_ringFd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+	{
+		return false;
+	}
+
+	for (unsigned i = 0; i < bufferCount; ++i)
+	{
+		recycle(static_cast<uint16_t>(i));
+	}
+	return true;
+#else
+	return false;
+#endif
+}
+
+void UringEngine::recycle(uint16_t bufferId)
+{
+#ifdef IORING_RECV_MULTISHOT
+	// Кольцо - массив io_uring_buf, хвост наложен на поле resv первого элемента.
+	// Структуру io_uring_buf_ring не используем: в C++ ее гибкий массив смещен пустой структурой
+	auto bufs = static_cast<io_uring_buf*>(_bufRing);
+	auto& buf = bufs[_bufTail & (bufferCount - 1)];
+	buf.addr = reinterpret_cast<uint64_t>(_buffers + static_cast<size_t>(bufferId) * bufferSize);
+	buf.len = bufferSize;
+	buf.bid = bufferId;
+	++_bufTail;
+	__atomic_store_n(&bufs[0].resv, _bufTail, __ATOMIC_RELEASE);
+	++_freeBuffers;
+#endif
+}
+
+void UringEngine::feedStarved()
+{
+	// Перезапущенный сразу опять получил бы ENOBUFS - ждем, пока владельцы заберут данные
+	while (!_starved.empty() && _freeBuffers >= starvedReserve)
+	{
+		auto id = _starved.front();
+		_starved.pop_front();
+
+		auto i = _streams.find(id);
+		if (i == _streams.end())
+		{
+			continue;
+		}
+		auto& stream = i->second;
+		stream.starved = false;
+		if (stream.wanted && !stream.armed && !stream.eof && stream.error == 0)
+		{
+			arm(id, stream);
+		}
+	}
+}
+
+io_uring_sqe* UringEngine::sqe()
+{
+	unsigned tail = *_sqTail;
+
+	// Очередь заполнена - отдаем ядру накопленное. Слот выдаем, только когда ядро его действительно забрало:
+	// иначе новая операция затрет еще не отправленную
+	while (tail - __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE) >= _sqEntries)
+	{
+		int n = submit();
+		if (n <= 0)
+		{
+			// EBUSY/EAGAIN - ядру некуда класть завершения, пока реактор их не заберет
+			if (n == 0)
+			{
+				errno = EBUSY;
+			}
+			return nullptr;
+		}
+	}
+
+	unsigned index = tail & _sqMask;
+	auto entry = &_sqes[index];
+	memset(entry, 0, sizeof(*entry));
+
+	_sqArray[index] = index;
+	__atomic_store_n(_sqTail, tail + 1, __ATOMIC_RELEASE);
+
+	return entry;
+}
+
+bool UringEngine::pushPoll(int fd, const epoll_event& ev)
+{
+	auto entry = sqe();
+	if (entry == nullptr)
+	{
+		return false;
+	}
+	entry->opcode = IORING_OP_POLL_ADD;
+	entry->fd = fd;
+	// Флаги режима epoll для poll смысла не имеют: он однократный и перевзводится явно
+	entry->poll32_events = ev.events & ~static_cast<uint32_t>(EPOLLET | EPOLLONESHOT | EPOLLEXCLUSIVE | EPOLLWAKEUP);
+	entry->user_data = reinterpret_cast<uint64_t>(ev.data.ptr);
+	return true;
+}
+
+bool UringEngine::pushRemove(void* ptr)
+{
+	auto entry = sqe();
+	if (entry == nullptr)
+	{
+		return false;
+	}
+	entry->opcode = IORING_OP_POLL_REMOVE;
+	entry->fd = -1;
+	entry->addr = reinterpret_cast<uint64_t>(ptr);
+	entry->user_data = SERVICE_TAG;
+	return true;
+}
+
+unsigned UringEngine::unsubmitted() const
+{
+	// Без SQPOLL ядро продвигает голову синхронно внутри io_uring_enter
+	return *_sqTail - __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE);
+}
+
+int UringEngine::submit()
+{
+	unsigned toSubmit = unsubmitted();
+	if (toSubmit == 0)
+	{
+		return 0;
+	}
+
+	int n;
+	do
+	{
+		++_syscalls;
+		n = io_uring_enter(_ringFd, toSubmit, 0, 0);
+	}
+	while (n < 0 && errno == EINTR);
+
+	return n;
+}
+
+constexpr std::chrono::milliseconds UringEngine::activityWindow;
+
+void UringEngine::queued()
+{
+	++_queued;
+	_activeUntil = std::chrono::steady_clock::now() + activityWindow;
+
+	// Бодрствующий реактор отправит операцию при следующем ожидании, короткий сон - по его окончании
+	if (!_sleeping || _woken)
+	{
+		return;
+	}
+	if (_wakeFd < 0)
+	{
+		submit();
+		return;
+	}
+	if (_longSleep || _queued >= wakeBatch)
+	{
+		++_syscalls;
+		eventfd_write(_wakeFd, 1);
+		_woken = true;
+	}
+}
+
+void UringEngine::armWake()
+{
+	auto entry = sqe();
+	if (entry == nullptr)
+	{
+		return;
+	}
+	entry->opcode = IORING_OP_READ;
+	entry->fd = _wakeFd;
+	entry->addr = reinterpret_cast<uint64_t>(&_wakeValue);
+	entry->len = sizeof(_wakeValue);
+	entry->user_data = TAG_WAKE;
+	_wakeArmed = true;
+}
+
+uint32_t UringEngine::prepare(int fd, const epoll_event& ev)
+{
+	uint32_t events = ev.events & ~KERNEL_MASK;
+
+	auto i = _streamIds.find(ev.data.ptr);
+	if (i == _streamIds.end())
+	{
+		uint64_t tag = 0;
+		if ((ev.events & KERNEL_ACCEPT) != 0 && _acceptSupported)
+		{
+			tag = TAG_ACCEPT;
+		}
+		else if ((ev.events & KERNEL_RECV) != 0 && _recvSupported)
+		{
+			tag = TAG_RECV;
+		}
+		if (tag == 0)
+		{
+			return events;
+		}
+
+		auto id = ++_lastStreamId;
+		i = _streamIds.emplace(ev.data.ptr, id).first;
+		auto& stream = _streams[id];
+		stream.ptr = ev.data.ptr;
+		stream.fd = fd;
+		stream.tag = tag;
+		stream.armed = false;
+		stream.wanted = false;
+		stream.eof = false;
+		stream.error = 0;
+		stream.starved = false;
+	}
+
+	auto id = i->second;
+	auto& stream = _streams[id];
+
+	// Готовность к чтению сообщит сама операция. Без запроса (чтение приостановлено) ее останавливаем,
+	// но уже полученное остается у потока
+	stream.wanted = (ev.events & KERNEL_MASK) != 0;
+	if (stream.wanted && !stream.armed && !stream.eof && stream.error == 0 && !stream.starved)
+	{
+		arm(id, stream);
+	}
+	else if (!stream.wanted && stream.armed)
+	{
+		cancel(id, stream);
+	}
+
+	return events & ~static_cast<uint32_t>(EPOLLIN | EPOLLRDNORM);
+}
+
+bool UringEngine::arm(uint64_t id, Stream& stream)
+{
+#ifdef IORING_RECV_MULTISHOT
+	auto entry = sqe();
+	if (entry == nullptr)
+	{
+		return false;
+	}
+	entry->fd = stream.fd;
+	entry->user_data = (id << TAG_BITS) | stream.tag;
+	if (stream.tag == TAG_ACCEPT)
+	{
+		entry->opcode = IORING_OP_ACCEPT;
+		entry->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+		entry->ioprio = IORING_ACCEPT_MULTISHOT;
+	}
+	else
+	{
+		entry->opcode = IORING_OP_RECV;
+		entry->flags = IOSQE_BUFFER_SELECT;
+		entry->buf_group = bufferGroup;
+		entry->ioprio = IORING_RECV_MULTISHOT;
+	}
+	stream.armed = true;
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool UringEngine::cancel(uint64_t id, Stream& stream)
+{
+	auto entry = sqe();
+	if (entry == nullptr)
+	{
+		return false;
+	}
+	entry->opcode = IORING_OP_ASYNC_CANCEL;
+	entry->fd = -1;
+	entry->addr = (id << TAG_BITS) | stream.tag;
+	entry->user_data = SERVICE_TAG;
+	// Поток считается запущенным, пока не придет завершающее (отмененное) завершение
+	return true;
+}
+
+void UringEngine::drop(void* ptr)
+{
+	auto i = _streamIds.find(ptr);
+	if (i == _streamIds.end())
+	{
+		return;
+	}
+	auto id = i->second;
+	_streamIds.erase(i);
+
+	auto& stream = _streams[id];
+	if (stream.armed)
+	{
+		cancel(id, stream);
+	}
+	for (auto& chunk : stream.chunks)
+	{
+		recycle(chunk.first);
+	}
+	for (auto sock : stream.socks)
+	{
+		close(sock);
+	}
+	// Завершения отмененной операции придут уже без потока - их буферы и подключения освободит complete()
+	_streams.erase(id);
+
+	feedStarved();
+}
+
+bool UringEngine::add(int fd, const epoll_event& ev)
+{
+	std::lock_guard<std::mutex> guard(_mutex);
+	epoll_event tmp = ev;
+	tmp.events = prepare(fd, ev);
+	if (!pushPoll(fd, tmp))
+	{
+		return false;
+	}
+	queued();
+	return true;
+}
+
+bool UringEngine::modify(int fd, const epoll_event& ev)
+{
+	std::lock_guard<std::mutex> guard(_mutex);
+	epoll_event tmp = ev;
+	tmp.events = prepare(fd, ev);
+	// Прежний poll мог еще не сработать - снимаем (если его уже нет, ядро вернет ENOENT)
+	if (!pushRemove(ev.data.ptr) || !pushPoll(fd, tmp))
+	{
+		return false;
+	}
+	queued();
+	return true;
+}
+
+bool UringEngine::remove(int, void* ptr)
+{
+	std::lock_guard<std::mutex> guard(_mutex);
+	drop(ptr);
+	if (!pushRemove(ptr))
+	{
+		return false;
+	}
+	queued();
+	return true;
+}
+
+bool UringEngine::complete(const io_uring_cqe& cqe, epoll_event& ev)
+{
+#ifdef IORING_RECV_MULTISHOT
+	auto id = cqe.user_data >> TAG_BITS;
+	bool more = (cqe.flags & IORING_CQE_F_MORE) != 0;
+	bool buffer = (cqe.flags & IORING_CQE_F_BUFFER) != 0;
+	auto bufferId = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+
+	if (buffer)
+	{
+		--_freeBuffers;
+	}
+
+	auto i = _streams.find(id);
+	if (i == _streams.end())
+	{
+		// Поток уже снят - освобождаем то, что ядро успело получить
+		if (buffer)
+		{
+			recycle(bufferId);
+		}
+		else if ((cqe.user_data & TAG_MASK) == TAG_ACCEPT && cqe.res >= 0)
+		{
+			close(cqe.res);
+		}
+		return false;
+	}
+	auto& stream = i->second;
+
+	if (!more)
+	{
+		stream.armed = false;
+	}
+
+	ev.data.ptr = stream.ptr;
+	ev.events = EPOLLIN;
+
+	if (cqe.res == -EINVAL && stream.socks.empty() && stream.chunks.empty())
+	{
+		// Ядро не умеет многократную операцию - дальше владелец принимает и читает сам
+		(stream.tag == TAG_ACCEPT ? _acceptSupported : _recvSupported) = false;
+		_streamIds.erase(stream.ptr);
+		_streams.erase(i);
+		return true;
+	}
+
+	if (cqe.res == -ECANCELED)
+	{
+		// Отменена приостановкой чтения, а запрос уже вернулся
+		if (stream.wanted && !stream.armed && !stream.starved)
+		{
+			arm(id, stream);
+		}
+		return false;
+	}
+
+	if (stream.tag == TAG_ACCEPT)
+	{
+		if (cqe.res >= 0)
+		{
+			stream.socks.push_back(cqe.res);
+		}
+		else
+		{
+			// Ошибка приема (например, EMFILE) операцию останавливает: ее заберет владелец и перезапустит
+			// прием сам (modify() с KERNEL_ACCEPT), выждав паузу
+			stream.error = -cqe.res;
+		}
+		return true;
+	}
+
+	if (buffer)
+	{
+		stream.chunks.emplace_back(bufferId, static_cast<uint32_t>(cqe.res));
+	}
+	if (cqe.res == 0)
+	{
+		stream.eof = true;
+		ev.events |= EPOLLRDHUP;
+	}
+	else if (cqe.res == -ENOBUFS)
+	{
+		// Буферы кончились: владелец забирает свое, а перезапуск - когда буферов вернут достаточно
+		if (!more && !stream.starved)
+		{
+			stream.starved = true;
+			_starved.push_back(id);
+			feedStarved();
+		}
+	}
+	else if (cqe.res < 0)
+	{
+		stream.error = -cqe.res;
+		ev.events |= EPOLLERR;
+	}
+	else if (!more && stream.wanted && cqe.res > 0)
+	{
+		arm(id, stream);
+	}
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool UringEngine::accepted(void* ptr, std::vector<int>& socks, int& error)
+{
+	std::lock_guard<std::mutex> guard(_mutex);
+
+	auto i = _streamIds.find(ptr);
+	if (i == _streamIds.end())
+	{
+		return false;
+	}
+	auto& stream = _streams[i->second];
+	if (stream.tag != TAG_ACCEPT)
+	{
+		return false;
+	}
+
+	socks.insert(socks.end(), stream.socks.begin(), stream.socks.end());
+	stream.socks.clear();
+
+	// Ошибка отдается один раз: следующий modify() с KERNEL_ACCEPT прием перезапустит
+	error = stream.error;
+	stream.error = 0;
+	return true;
+}
+
+bool UringEngine::received(void* ptr, Buffer& buffer, bool& eof, int& error)
+{
+	std::lock_guard<std::mutex> guard(_mutex);
+
+	auto i = _streamIds.find(ptr);
+	if (i == _streamIds.end())
+	{
+		return false;
+	}
+	auto& stream = _streams[i->second];
+	if (stream.tag != TAG_RECV)
+	{
+		return false;
+	}
+
+	for (auto& chunk : stream.chunks)
+	{
+		buffer.write(_buffers + static_cast<size_t>(chunk.first) * bufferSize, chunk.second);
+		recycle(chunk.first);
+	}
+	stream.chunks.clear();
+
+	feedStarved();
+
+	eof = stream.eof;
+	error = stream.error;
+	return true;
+}
+
+int UringEngine::wait(epoll_event* events, int maxEvents, int timeoutMs)
+{
+	unsigned toSubmit;
+	unsigned minComplete = 0;
+	unsigned flags = 0;
+	{
+		std::lock_guard<std::mutex> guard(_mutex);
+
+		// Рабочие потоки недавно ставили операции - скорее всего, поставят еще: спим коротко и заберем их сами
+		long timeoutUs = timeoutMs * 1000L;
+		if (_wakeFd >= 0 && timeoutUs > flushDelayUs && std::chrono::steady_clock::now() < _activeUntil)
+		{
+			timeoutUs = flushDelayUs;
+		}
+		_queued = 0;
+		_woken = false;
+
+		if (_wakeFd >= 0 && !_wakeArmed)
+		{
+			armWake();
+		}
+
+		// Нечего забрать - ждем первого завершения, но не дольше таймаута.
+		// Если таймаут поставить некуда (очередь полна), забираем завершения без сна
+		io_uring_sqe* entry = nullptr;
+		if (__atomic_load_n(_cqTail, __ATOMIC_ACQUIRE) == *_cqHead && timeoutUs != 0)
+		{
+			entry = sqe();
+		}
+		if (entry != nullptr)
+		{
+			_timeout.tv_sec = timeoutUs / 1000000;
+			_timeout.tv_nsec = (timeoutUs % 1000000) * 1000;
+			entry->opcode = IORING_OP_TIMEOUT;
+			entry->fd = -1;
+			entry->addr = reinterpret_cast<uint64_t>(&_timeout);
+			entry->len = 1;
+			entry->off = 1; // Завершится и по первому же событию
+			entry->user_data = SERVICE_TAG;
+
+			minComplete = 1;
+			flags = IORING_ENTER_GETEVENTS;
+		}
+
+		toSubmit = unsubmitted();
+		_sleeping = minComplete != 0;
+		_longSleep = timeoutUs > flushDelayUs;
+	}
+
+	int rc = io_uring_enter(_ringFd, toSubmit, minComplete, flags);
+	int error = errno;
+
+	// Не принятое ядром (например, по EINTR) отправится со следующей пачкой
+	std::lock_guard<std::mutex> guard(_mutex);
+	_sleeping = false;
+
+	if (rc < 0 && error != EINTR && error != ETIME && error != EBUSY)
+	{
+		errno = error;
+		return -1;
+	}
+
+	// Состояние потоков меняют и рабочие потоки (modify/remove/received) - разбираем под той же блокировкой
+	int n = 0;
+	{
+
+		unsigned head = *_cqHead;
+		unsigned tail = __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+		while (head != tail && n < maxEvents)
+		{
+			auto& cqe = _cqes[head & _cqMask];
+			++head;
+
+			if (cqe.user_data == SERVICE_TAG)
+			{
+				continue;
+			}
+
+			// Разбудили - чтение eventfd перевзведется при следующем ожидании
+			if (cqe.user_data == TAG_WAKE)
+			{
+				_wakeArmed = false;
+				if (cqe.res < 0 && cqe.res != -EINTR)
+				{
+					// Ядро не читает eventfd само - дальше операции отправляются сразу
+					close(_wakeFd);
+					_wakeFd = -1;
+				}
+				continue;
+			}
+
+			// Прием и чтение силами ядра
+			if ((cqe.user_data & TAG_MASK) != 0)
+			{
+				if (complete(cqe, events[n]))
+				{
+					++n;
+				}
+				continue;
+			}
+
+			// Отмененные наблюдения пропускаем
+			if (cqe.res < 0)
+			{
+				continue;
+			}
+
+			events[n].data.ptr = reinterpret_cast<void*>(cqe.user_data);
+			events[n].events = static_cast<uint32_t>(cqe.res);
+			++n;
+		}
+		__atomic_store_n(_cqHead, head, __ATOMIC_RELEASE);
+	}
+
+	if (n == 0 && rc < 0 && error == EINTR)
+	{
+		errno = EINTR;
+		return -1;
+	}
+
+	return n;
+}
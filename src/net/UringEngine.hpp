@@ -0,0 +1,222 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// UringEngine.hpp
+
+
+#pragma once
+
+#include "EventEngine.hpp"
+
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <linux/io_uring.h>
+#include <linux/time_types.h>
+
+/// Механизм на io_uring (без liburing, через системные вызовы).
+/// Наблюдение - однократный IORING_OP_POLL_ADD, перевзводимый при каждом modify().
+/// Слушающие сокеты (KERNEL_ACCEPT) принимаются многократным IORING_OP_ACCEPT, а данные сокетов
+/// (KERNEL_RECV) читаются многократным IORING_OP_RECV в буферы, предоставленные ядру: цикл обработки
+/// забирает готовое без accept4/readv и без завершающего вызова до EAGAIN.
+/// Операции копятся в очереди отправки и уходят в ядро пачкой при ожидании событий
+/// (спящий реактор будят через eventfd, только если он спит долго или операций накопилось много),
+/// так что под нагрузкой цикл обработки соединения не платит отдельный системный вызов за epoll_ctl
+class UringEngine final: public EventEngine
+{
+private:
+	/// Метка служебных операций, чьи завершения пропускаются
+	static const uint64_t SERVICE_TAG = 0;
+
+	/// Вид операции в младших битах user_data (data.ptr наблюдения выровнен - его биты нулевые)
+	static const uint64_t TAG_ACCEPT = 1;
+	static const uint64_t TAG_RECV = 2;
+	/// Чтение eventfd пробуждения (идентификатор 0)
+	static const uint64_t TAG_WAKE = 3;
+	static const uint64_t TAG_MASK = 7;
+	static const unsigned TAG_BITS = 3;
+
+	/// Буферы приема, предоставленные ядру (степень двойки)
+	static const unsigned bufferCount = 256;
+	static const unsigned bufferSize = 8192;
+	static const uint16_t bufferGroup = 0;
+	/// Сколько буферов должно освободиться, прежде чем перезапускать чтение, упершееся в ENOBUFS
+	static const unsigned starvedReserve = bufferCount / 8;
+
+	/// Операции рабочих потоков копятся, пока реактор спит: в течение activityWindow после последней из них
+	/// он спит не дольше flushDelayUs и заберет их сам, а будят его, только если сон долгий
+	/// или накопилось wakeBatch операций
+	static const unsigned wakeBatch = 32;
+	static const long flushDelayUs = 500;
+	static constexpr std::chrono::milliseconds activityWindow{10};
+
+	/// Сокет, который принимает или читает механизм
+	struct Stream final
+	{
+		void* ptr;
+		int fd;
+		uint64_t tag;
+
+		/// Многократная операция в ядре (снимается завершением без IORING_CQE_F_MORE)
+		bool armed;
+		/// Владелец хочет, чтобы операция шла (при приостановке чтения - нет)
+		bool wanted;
+
+		/// Принятые подключения
+		std::deque<int> socks;
+		/// Полученные данные: номер буфера и длина
+		std::deque<std::pair<uint16_t, uint32_t>> chunks;
+
+		bool eof;
+		int error;
+
+		/// Чтение остановлено нехваткой буферов (ENOBUFS) - перезапустится, когда их вернут
+		bool starved;
+	};
+
+	int _ringFd;
+
+	void* _sqRing;
+	size_t _sqRingSize;
+	void* _cqRing;
+	size_t _cqRingSize;
+	io_uring_sqe* _sqes;
+	size_t _sqesSize;
+
+	unsigned* _sqHead;
+	unsigned* _sqTail;
+	unsigned _sqMask;
+	unsigned _sqEntries;
+	unsigned* _sqArray;
+
+	unsigned* _cqHead;
+	unsigned* _cqTail;
+	unsigned _cqMask;
+	io_uring_cqe* _cqes;
+
+	/// Блокировка очереди отправки (наполняют рабочие потоки, ждет реактор)
+	std::mutex _mutex;
+
+	/// Реактор спит в ядре
+	bool _sleeping;
+	/// Сон реактора длиннее flushDelayUs - новую операцию надо отправить сразу
+	bool _longSleep;
+	/// Операции add/modify/remove с прошлого входа реактора в ядро
+	unsigned _queued;
+	/// До какого момента реактор спит коротко
+	std::chrono::steady_clock::time_point _activeUntil;
+
+	/// eventfd пробуждения реактора (-1 - ядро не читает его само, операции отправляются сразу)
+	int _wakeFd;
+	uint64_t _wakeValue;
+	/// Чтение eventfd стоит в ядре
+	bool _wakeArmed;
+	/// В этот сон реактора уже будили
+	bool _woken;
+
+	__kernel_timespec _timeout;
+
+	/// Потоки по идентификатору (он в user_data: адрес соединения может быть переиспользован,
+	/// пока ядро еще досылает завершения отмененной операции) и по адресу соединения
+	std::unordered_map<uint64_t, Stream> _streams;
+	std::unordered_map<void*, uint64_t> _streamIds;
+	uint64_t _lastStreamId;
+
+	bool _acceptSupported;
+	bool _recvSupported;
+
+	void* _bufRing;
+	size_t _bufRingSize;
+	char* _buffers;
+	size_t _buffersSize;
+	uint16_t _bufTail;
+	/// Буферы, которые сейчас у ядра
+	unsigned _freeBuffers;
+	/// Потоки, ждущие буферов, в порядке остановки
+	std::deque<uint64_t> _starved;
+
+	/// Получить свободный элемент очереди отправки (под _mutex).
+	/// nullptr - очередь полна и ядро не принимает операции (см. errno)
+	io_uring_sqe* sqe();
+
+	/// Поставить в очередь наблюдение (под _mutex)
+	bool pushPoll(int fd, const epoll_event& ev);
+
+	/// Поставить в очередь снятие наблюдения (под _mutex)
+	bool pushRemove(void* ptr);
+
+	/// Добавлено, но еще не принято ядром (под _mutex)
+	unsigned unsubmitted() const;
+
+	/// Отправить накопленное в ядро (под _mutex)
+	int submit();
+
+	/// Учесть поставленную в очередь операцию и при необходимости разбудить реактор (под _mutex)
+	void queued();
+
+	/// Поставить в очередь чтение eventfd пробуждения (под _mutex)
+	void armWake();
+
+	void unmap();
+
+	/// Зарегистрировать буферы приема (false - ядро не умеет)
+	bool setupBuffers();
+
+	/// Вернуть буфер ядру (под _mutex)
+	void recycle(uint16_t bufferId);
+
+	/// Перезапустить ждущие буферов потоки, если их освободилось достаточно (под _mutex)
+	void feedStarved();
+
+	/// Учесть запросы KERNEL_* и вернуть маску для poll (под _mutex)
+	uint32_t prepare(int fd, const epoll_event& ev);
+
+	/// Запустить / отменить многократную операцию потока (под _mutex)
+	bool arm(uint64_t id, Stream& stream);
+	bool cancel(uint64_t id, Stream& stream);
+
+	/// Забыть поток, освободив его буферы и непринятые подключения (под _mutex)
+	void drop(void* ptr);
+
+	/// Обработать завершение операции потока. true - о нем надо сообщить событием ev (под _mutex)
+	bool complete(const io_uring_cqe& cqe, epoll_event& ev);
+
+public:
+	UringEngine() = delete;
+	UringEngine(const UringEngine&) = delete;
+	UringEngine& operator=(const UringEngine&) = delete;
+	UringEngine(UringEngine&&) noexcept = delete;
+	UringEngine& operator=(UringEngine&&) noexcept = delete;
+
+	explicit UringEngine(int poolSize);
+	~UringEngine() override;
+
+	const char* name() const override
+	{
+		return "io_uring";
+	}
+
+	bool add(int fd, const epoll_event& ev) override;
+	bool modify(int fd, const epoll_event& ev) override;
+	bool remove(int fd, void* ptr) override;
+	int wait(epoll_event* events, int maxEvents, int timeoutMs) override;
+
+	bool accepted(void* ptr, std::vector<int>& socks, int& error) override;
+	bool received(void* ptr, Buffer& buffer, bool& eof, int& error) override;
+};
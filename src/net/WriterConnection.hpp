@@ -21,13 +21,13 @@
 
 #pragma once
 
-#include "../utils/Buffer.hpp"
+#include "../utils/OutputChain.hpp"
 #include "../utils/Writer.hpp"
 
 class WriterConnection : public Writer
 {
 protected:
-	Buffer _outBuff;
+	OutputChain _outBuff;
 
 public:
 	inline char* spacePtr() const override
@@ -51,4 +51,20 @@ public:
 	{
 		return _outBuff.write(data, length);
 	}
+
+	/// Отправить данные без копирования (должны жить до отправки)
+	inline bool writeBorrowed(const void* data, size_t length)
+	{
+		return _outBuff.writeBorrowed(data, length);
+	}
+	/// Отправить разделяемые данные без копирования (можно одни и те же на многие соединения)
+	inline bool writeShared(const std::shared_ptr<const std::string>& payload)
+	{
+		return _outBuff.writeShared(payload);
+	}
+	/// Отправить участок файла (владелец держит дескриптор открытым до отправки)
+	inline bool writeFile(const std::shared_ptr<const void>& holder, int fd, off_t offset, size_t length)
+	{
+		return _outBuff.writeFile(holder, fd, offset, length);
+	}
 };
@@ -29,6 +29,12 @@
 #include "../telemetry/SysInfo.hpp"
 #include "../services/Services.hpp"
 #include "../utils/Daemon.hpp"
+#include "../utils/MemoryBudget.hpp"
+#include "../transport/http/HttpClientPool.hpp"
+#include "../transport/http/HttpUri.hpp"
+#include "../utils/SslHelper.hpp"
+#include "../net/HandshakePool.hpp"
+#include "../thread/StackPool.hpp"
 #include "../thread/TaskManager.hpp"
 #include "../log/LoggerManager.hpp"
 
@@ -37,6 +43,7 @@ Server* Server::_instance = nullptr;
 Server::Server(const std::shared_ptr<Config>& configs)
 : _log("Server")
 , _workerCount(std::thread::hardware_concurrency())
+, _reactorCount(0)
 , _configs(configs)
 {
 	if (_instance != nullptr)
@@ -70,6 +77,65 @@ Server::Server(const std::shared_ptr<Config>& configs)
 		{
 			throw std::runtime_error("Count of workers too few. Programm won't be work correctly");
 		}
+
+		settings.lookupValue("reactors", _reactorCount);
+
+		std::string engine;
+		if (settings.lookupValue("engine", engine) && !engine.empty())
+		{
+			ConnectionManager::setEngine(engine);
+		}
+
+		unsigned int memoryLimit = 0;
+		if (settings.lookupValue("memoryLimit", memoryLimit))
+		{
+			MemoryBudget::setLimit(static_cast<size_t>(memoryLimit) << 20);
+		}
+
+		unsigned int httpClientMaxIdle = 256;
+		unsigned int httpClientMaxIdlePerHost = 16;
+		unsigned int httpClientIdleTimeout = 60;
+		settings.lookupValue("httpClientMaxIdle", httpClientMaxIdle);
+		settings.lookupValue("httpClientMaxIdlePerHost", httpClientMaxIdlePerHost);
+		settings.lookupValue("httpClientIdleTimeout", httpClientIdleTimeout);
+		HttpClientPool::setLimits(httpClientMaxIdle, httpClientMaxIdlePerHost, std::chrono::seconds(httpClientIdleTimeout));
+
+		if (settings.exists("httpClientUpstreams"))
+		{
+			for (const auto& setting : settings["httpClientUpstreams"])
+			{
+				std::string uri;
+				if (!setting.lookupValue("uri", uri) || uri.empty())
+				{
+					throw std::runtime_error("Bad config: uri of http client upstream undefined");
+				}
+				HttpClientPool::setUpstream(HttpClientPool::peer(HttpUri(uri)), ConnectorFactory::creator(setting));
+			}
+		}
+
+		unsigned int tlsSessionCacheSize = 20480;
+		unsigned int tlsSessionTimeout = 300;
+		unsigned int tlsTicketKeyLifetime = 3600;
+		settings.lookupValue("tlsSessionCacheSize", tlsSessionCacheSize);
+		settings.lookupValue("tlsSessionTimeout", tlsSessionTimeout);
+		settings.lookupValue("tlsTicketKeyLifetime", tlsTicketKeyLifetime);
+		SslHelper::setSessionCache(tlsSessionCacheSize, std::chrono::seconds(tlsSessionTimeout), std::chrono::seconds(tlsTicketKeyLifetime));
+
+		bool tlsKernelOffload = false;
+		settings.lookupValue("tlsKernelOffload", tlsKernelOffload);
+		SslHelper::setKernelOffload(tlsKernelOffload);
+
+		unsigned int handshakeThreads = 0;
+		unsigned int handshakeQueueLimit = 1024;
+		settings.lookupValue("handshakeThreads", handshakeThreads);
+		settings.lookupValue("handshakeQueueLimit", handshakeQueueLimit);
+		HandshakePool::start(handshakeThreads, handshakeQueueLimit);
+
+		unsigned int coroutineStackSize = 1024;
+		bool coroutineStackTrim = false;
+		settings.lookupValue("coroutineStackSize", coroutineStackSize);
+		settings.lookupValue("coroutineStackTrim", coroutineStackTrim);
+		StackPool::configure(static_cast<size_t>(coroutineStackSize) << 10, coroutineStackTrim);
 	}
 	catch (const libconfig::SettingNotFoundException& exception)
 	{
@@ -82,6 +148,13 @@ Server::Server(const std::shared_ptr<Config>& configs)
 		exit(EXIT_FAILURE);
 	}
 
+	// По умолчанию - по реактору на каждый рабочий поток
+	if (_reactorCount == 0)
+	{
+		_reactorCount = _workerCount;
+	}
+	ConnectionManager::setReactorCount(_reactorCount);
+
 	try
 	{
 		const auto& settings = _configs->getRoot()["applications"];
@@ -190,7 +263,8 @@ bool Server::start()
 		return false;
 	}
 
-	ThreadPool::setThreadNum(_workerCount);
+	// Каждый реактор постоянно занимает поток, один из них учтен в количестве рабочих
+	ThreadPool::setThreadNum(_workerCount + _reactorCount - 1);
 
 	_log.info("Server start (pid=%u)", getpid());
 	return true;
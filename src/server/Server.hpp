@@ -41,6 +41,8 @@ private:
 
 	uint32_t _workerCount;
 
+	uint32_t _reactorCount;
+
 	std::shared_ptr<Config> _configs;
 
 public:
@@ -154,6 +154,9 @@ MysqlAsyncConnection::MysqlAsyncConnection(const std::shared_ptr<DbConnectionPoo
 , _transaction(0)
 , _status(0)
 , _ctx(nullptr)
+, _asyncRet(0)
+, _asyncStored(nullptr)
+, _asyncResult(nullptr)
 {
 	_mysql = mysql_init(_mysql);
 	if (_mysql == nullptr)
@@ -452,6 +455,115 @@ bool MysqlAsyncConnection::multiQuery(const std::string& sql)
 	return true;
 }
 
+void MysqlAsyncConnection::implAwait(std::function<void()>&& continuation)
+{
+	_continuation = std::move(continuation);
+	ConnectionManager::watch(_helper);
+}
+
+void MysqlAsyncConnection::asyncQuery(const std::string& sql, DbResult* res, std::function<void(bool)>&& handler)
+{
+	auto pool = _pool.lock();
+
+	if (pool) pool->metricAvgQueryPerSec->addValue();
+	if (pool) pool->log().debug("MySQL query: %s", sql.c_str());
+
+	// Строка запроса должна жить, пока библиотека ее отправляет
+	_asyncSql = sql;
+	_asyncResult = dynamic_cast<MysqlResult *>(res);
+	_asyncHandler = std::move(handler);
+
+	_status = mysql_real_query_start(&_asyncRet, _mysql, _asyncSql.c_str(), _asyncSql.length());
+	asyncQueryStep();
+}
+
+void MysqlAsyncConnection::asyncQueryStep()
+{
+	if (_status != 0)
+	{
+		// Держим соединение, пока ждем сокет
+		implAwait(
+			[iam = std::dynamic_pointer_cast<MysqlAsyncConnection>(ptr())]
+			{
+				iam->_status = mysql_real_query_cont(&iam->_asyncRet, iam->_mysql, iam->_status);
+				iam->asyncQueryStep();
+			}
+		);
+		return;
+	}
+
+	if (_asyncRet != 0)
+	{
+		auto pool = _pool.lock();
+		if (!deadlockDetected())
+		{
+			if (pool) pool->log().warn("MySQL query error: [%u] %s\n\t\tFor query:\n\t\t%s", mysql_errno(_mysql), mysql_error(_mysql), _asyncSql.c_str());
+		}
+		asyncDone(false);
+		return;
+	}
+
+	if (_asyncResult == nullptr)
+	{
+		asyncDone(true);
+		return;
+	}
+
+	_status = mysql_store_result_start(&_asyncStored, _mysql);
+	asyncStoreStep();
+}
+
+void MysqlAsyncConnection::asyncStoreStep()
+{
+	if (_status != 0)
+	{
+		implAwait(
+			[iam = std::dynamic_pointer_cast<MysqlAsyncConnection>(ptr())]
+			{
+				iam->_status = mysql_store_result_cont(&iam->_asyncStored, iam->_mysql, iam->_status);
+				iam->asyncStoreStep();
+			}
+		);
+		return;
+	}
+
+	_asyncResult->set(_asyncStored);
+	_asyncStored = nullptr;
+
+	if (_asyncResult->get() == nullptr && mysql_errno(_mysql) != 0)
+	{
+		auto pool = _pool.lock();
+		if (pool) pool->log().error("MySQL store result error: [%u] %s\n\t\tFor query:\n\t\t%s", mysql_errno(_mysql), mysql_error(_mysql), _asyncSql.c_str());
+		asyncDone(false);
+		return;
+	}
+
+	asyncDone(true);
+}
+
+void MysqlAsyncConnection::asyncDone(bool success)
+{
+	auto pool = _pool.lock();
+	if (success)
+	{
+		if (pool) pool->metricSuccessQueryCount->addValue();
+	}
+	else
+	{
+		if (pool) pool->metricFailQueryCount->addValue();
+	}
+
+	_asyncResult = nullptr;
+	_asyncSql.clear();
+
+	auto handler = std::move(_asyncHandler);
+	_asyncHandler = nullptr;
+	if (handler)
+	{
+		handler(success);
+	}
+}
+
 void MysqlAsyncConnection::MysqlAsyncConnectionHelper::watch(epoll_event& ev)
 {
 	auto parent = _parent.lock();
@@ -520,6 +632,14 @@ bool MysqlAsyncConnection::MysqlAsyncConnectionHelper::processing()
 	if (wasFailure()) parent->_status |= MYSQL_WAIT_EXCEPT;
 	if (timeIsOut()) parent->_status |= MYSQL_WAIT_TIMEOUT;
 
+	if (parent->_continuation)
+	{
+		auto continuation = std::move(parent->_continuation);
+		parent->_continuation = nullptr;
+		continuation();
+		return true;
+	}
+
 	throw RollbackStackAndRestoreContext(parent->_ctx);
 }
 
@@ -34,8 +34,10 @@ using MysqlAsyncConnection = MysqlConnection;
 #include "../../utils/Shareable.hpp"
 #include "../../net/TcpConnection.hpp"
 #include <memory>
+#include <functional>
 
 class MysqlConnectionPool;
+class MysqlResult;
 
 class MysqlAsyncConnection final : public DbConnection
 {
@@ -65,7 +67,17 @@ private:
 	std::shared_ptr<MysqlAsyncConnectionHelper> _helper;
 	size_t _transaction;
 	int _status;
-	ucontext_t* _ctx;
+	CoroContext* _ctx;
+
+	/// Продолжение неблокирующего запроса: вызывается из обработки соединения при готовности сокета
+	std::function<void()> _continuation;
+
+	/// Состояние неблокирующего запроса
+	std::string _asyncSql;
+	int _asyncRet;
+	MYSQL_RES* _asyncStored;
+	MysqlResult* _asyncResult;
+	std::function<void(bool)> _asyncHandler;
 
 public:
 	MysqlAsyncConnection() = delete;
@@ -112,6 +124,10 @@ public:
 	bool query(const std::string& query, DbResult* res, size_t* affected, size_t* insertId) override;
 	bool multiQuery(const std::string& sql) override;
 
+	/// Запрос без сопрограммы ucontext: поток не блокируется и не подменяет стек,
+	/// handler вызывается из обработки соединения по завершении запроса (и чтения результата в res)
+	void asyncQuery(const std::string& sql, DbResult* res, std::function<void(bool)>&& handler);
+
 private:
 
 	bool implQuery(const std::string& sql);
@@ -123,6 +139,12 @@ private:
 	void implFreeResult(MYSQL_RES* result);
 
 	void implWait(bool isNew = false);
+
+	void implAwait(std::function<void()>&& continuation);
+
+	void asyncQueryStep();
+	void asyncStoreStep();
+	void asyncDone(bool success);
 };
 
 #endif // MARIADB_BASE_VERSION
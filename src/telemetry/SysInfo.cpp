@@ -23,6 +23,9 @@
 #include "TelemetryManager.hpp"
 #include "../utils/Daemon.hpp"
 #include "../thread/TaskManager.hpp"
+#include "../net/ConnectionManager.hpp"
+#include "../utils/BufferPool.hpp"
+#include "../thread/StackPool.hpp"
 
 #include <sys/resource.h>
 #include <sys/time.h>
@@ -49,6 +52,10 @@ void SysInfo::start()
 	instance._cpuUsageBySystemOnTime		= TelemetryManager::metric("core/cpu/system", std::chrono::seconds(300));
 	instance._memoryUsage					= TelemetryManager::metric("core/mem/phys_usage", std::chrono::seconds(300));
 	instance._memoryMaxUsage				= TelemetryManager::metric("core/mem/max_usage", 1);
+	instance._memoryPerConnection			= TelemetryManager::metric("core/mem/per_connection", std::chrono::seconds(300));
+	instance._memoryBufferPool				= TelemetryManager::metric("core/mem/buffer_pool", 1);
+	instance._coroutineStacksInUse			= TelemetryManager::metric("core/coro/stacks_in_use", 1);
+	instance._coroutineStacksMax			= TelemetryManager::metric("core/coro/stacks_max", 1);
 	instance._pageSoftFaults				= TelemetryManager::metric("core/mem/soft_faults", 1);
 	instance._pageHardFaults				= TelemetryManager::metric("core/mem/hard_faults", 1);
 	instance._blockInputOperations			= TelemetryManager::metric("core/io/block_input", std::chrono::seconds(300));
@@ -140,8 +147,19 @@ void SysInfo::collect()
 		fclose(file);
 
 		instance._memoryUsage->setValue(rss, now);
+
+		auto connections = ConnectionManager::connectionCount();
+		if (rss > 0 && connections > 0)
+		{
+			instance._memoryPerConnection->addValue(static_cast<double>(rss) / connections, now);
+		}
 	}
 
+	instance._memoryBufferPool->setValue(BufferPool::pooled(), now);
+
+	instance._coroutineStacksInUse->setValue(StackPool::inUse(), now);
+	instance._coroutineStacksMax->setValue(StackPool::highWater(), now);
+
 	gettimeofday(&instance._prevTime, nullptr);
 	instance._prevUTime = ru.ru_utime;
 	instance._prevSTime = ru.ru_stime;
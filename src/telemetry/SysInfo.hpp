@@ -58,6 +58,10 @@ public: // temporary public
 	std::shared_ptr<Metric> _cpuUsageBySystemOnTime;
 	std::shared_ptr<Metric> _memoryUsage;
 	std::shared_ptr<Metric> _memoryMaxUsage;
+	std::shared_ptr<Metric> _memoryPerConnection;
+	std::shared_ptr<Metric> _memoryBufferPool;
+	std::shared_ptr<Metric> _coroutineStacksInUse;
+	std::shared_ptr<Metric> _coroutineStacksMax;
 	std::shared_ptr<Metric> _pageSoftFaults;
 	std::shared_ptr<Metric> _pageHardFaults;
 	std::shared_ptr<Metric> _blockInputOperations;
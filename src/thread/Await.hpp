@@ -0,0 +1,152 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// Await.hpp
+
+
+#pragma once
+
+#include "Coroutine.hpp"
+#include "../net/TcpConnection.hpp"
+#include "../transport/http/HttpRequestExecutor.hpp"
+#include "../storage/DbConnection.hpp"
+#include "../storage/mysql/MysqlAsyncConnection.hpp"
+
+/// Ожидания для сопрограмм C++20 (co_await) поверх существующих механизмов сервера.
+/// Поток пула на время ожидания не занимается и стек не подменяется
+class Await final
+{
+public:
+	/// Продолжение в задаче пула потоков в заданное время
+	class Delay final
+	{
+	private:
+		Task::Time _time;
+
+	public:
+		explicit Delay(Task::Time time) noexcept
+		: _time(time)
+		{
+		}
+
+		bool await_ready() const noexcept
+		{
+			return false;
+		}
+
+		void await_suspend(std::coroutine_handle<> handle) const
+		{
+			TaskManager::enqueue([handle]{ handle.resume(); }, _time, "resume coroutine");
+		}
+
+		void await_resume() const noexcept
+		{
+		}
+	};
+
+	/// Готовность соединения к чтению. Результат: true - во входном буфере есть данные,
+	/// false - данных больше не будет. Сопрограмма продолжается в обработке соединения,
+	/// поэтому ждать можно, только пока соединение захвачено (см. TcpConnection::addReadyHandler)
+	class Readable final
+	{
+	private:
+		std::shared_ptr<TcpConnection> _connection;
+
+	public:
+		explicit Readable(const std::shared_ptr<TcpConnection>& connection) noexcept
+		: _connection(connection)
+		{
+		}
+
+		bool await_ready() const
+		{
+			return _connection->dataLen() > 0 || _connection->noRead() || _connection->isClosed();
+		}
+
+		void await_suspend(std::coroutine_handle<> handle) const
+		{
+			_connection->addReadyHandler([handle](TcpConnection&){ handle.resume(); });
+		}
+
+		bool await_resume() const
+		{
+			return _connection->dataLen() > 0;
+		}
+	};
+
+	Await() = delete;
+
+	/// Уступить поток: продолжить сопрограмму отдельной задачей
+	static Delay reschedule()
+	{
+		return Delay(Task::Clock::now());
+	}
+
+	static Delay sleepFor(Task::Duration duration)
+	{
+		return Delay(Task::Clock::now() + duration);
+	}
+
+	static Delay sleepUntil(Task::Time time)
+	{
+		return Delay(time);
+	}
+
+	static Readable readable(const std::shared_ptr<TcpConnection>& connection)
+	{
+		return Readable(connection);
+	}
+
+	/// Выполнить HTTP-запрос. Результат: true - ответ получен (executor->answer()),
+	/// false - ошибка (executor->error())
+	static auto request(const std::shared_ptr<HttpRequestExecutor>& executor)
+	{
+		return suspend<bool>(
+			[executor](auto resume)
+			{
+				(*executor)([resume](HttpRequestExecutor& executor){ resume(!executor.hasFailed()); });
+			}
+		);
+	}
+
+	/// Выполнить запрос к БД. Асинхронное соединение MariaDB не блокирует поток;
+	/// прочие соединения выполняют запрос в отдельной задаче пула потоков
+	static auto query(const std::shared_ptr<DbConnection>& connection, const std::string& sql, DbResult* res = nullptr)
+	{
+		return suspend<bool>(
+			[connection, sql, res](auto resume)
+			{
+#ifdef MARIADB_BASE_VERSION
+				auto asyncConnection = std::dynamic_pointer_cast<MysqlAsyncConnection>(connection);
+				if (asyncConnection)
+				{
+					asyncConnection->asyncQuery(sql, res, [resume](bool success){ resume(success); });
+					return;
+				}
+#endif
+				TaskManager::enqueue(
+					[connection, sql, res, resume]
+					{
+						resume(connection->query(sql, res));
+					},
+					"coroutine db query"
+				);
+			}
+		);
+	}
+};
@@ -0,0 +1,227 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// Callable.hpp
+
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "../utils/ObjectPool.hpp"
+
+/// Перемещаемая обертка вызываемого объекта без аргументов (замена std::function<void()> для задач).
+/// Захват до inlineSize байт хранится в самом объекте; больший размещается в пуле блоков,
+/// так что постановка задачи обычно обходится без обращения к аллокатору общего назначения
+class Callable final
+{
+public:
+	static const size_t inlineSize = 48;
+
+private:
+	/// Больших объектов в пуле не держим - их мало, а слэбы под них дороги
+	static const size_t pooledSize = 512;
+
+	struct Ops final
+	{
+		void (*invoke)(void* storage);
+		void (*relocate)(void* from, void* to) noexcept;
+		void (*destroy)(void* storage) noexcept;
+	};
+
+	template<class F>
+	struct Inline final
+	{
+		static void invoke(void* storage)
+		{
+			(*static_cast<F*>(storage))();
+		}
+		static void relocate(void* from, void* to) noexcept
+		{
+			new (to) F(std::move(*static_cast<F*>(from)));
+			static_cast<F*>(from)->~F();
+		}
+		static void destroy(void* storage) noexcept
+		{
+			static_cast<F*>(storage)->~F();
+		}
+		static constexpr Ops ops{invoke, relocate, destroy};
+	};
+
+	template<class F>
+	struct Boxed final
+	{
+		static F*& box(void* storage)
+		{
+			return *static_cast<F**>(storage);
+		}
+		static void invoke(void* storage)
+		{
+			(*box(storage))();
+		}
+		static void relocate(void* from, void* to) noexcept
+		{
+			new (to) F*(box(from));
+		}
+		static void destroy(void* storage) noexcept
+		{
+			auto ptr = box(storage);
+			ptr->~F();
+			if (sizeof(F) <= pooledSize && alignof(F) <= alignof(std::max_align_t))
+			{
+				PoolAllocator<F>().deallocate(ptr, 1);
+			}
+			else
+			{
+				::operator delete(ptr);
+			}
+		}
+		static F* create(F&& function)
+		{
+			void* ptr = (sizeof(F) <= pooledSize && alignof(F) <= alignof(std::max_align_t))
+				? static_cast<void*>(PoolAllocator<F>().allocate(1))
+				: ::operator new(sizeof(F));
+			return new (ptr) F(std::move(function));
+		}
+		static constexpr Ops ops{invoke, relocate, destroy};
+	};
+
+	template<class F>
+	using fitsInline = std::integral_constant<bool,
+		sizeof(F) <= inlineSize
+		&& alignof(F) <= alignof(std::max_align_t)
+		&& std::is_nothrow_move_constructible<F>::value
+	>;
+
+	alignas(std::max_align_t) char _storage[inlineSize];
+	const Ops* _ops;
+
+	template<class F>
+	void init(F&& function, std::true_type)
+	{
+		new (_storage) F(std::move(function));
+		_ops = &Inline<F>::ops;
+	}
+
+	template<class F>
+	void init(F&& function, std::false_type)
+	{
+		new (_storage) F*(Boxed<F>::create(std::move(function)));
+		_ops = &Boxed<F>::ops;
+	}
+
+	template<class F>
+	static bool isNull(const F&)
+	{
+		return false;
+	}
+	template<class R>
+	static bool isNull(R (*function)())
+	{
+		return function == nullptr;
+	}
+
+	void reset() noexcept
+	{
+		if (_ops != nullptr)
+		{
+			_ops->destroy(_storage);
+			_ops = nullptr;
+		}
+	}
+
+public:
+	Callable() noexcept
+	: _ops(nullptr)
+	{
+	}
+
+	Callable(std::nullptr_t) noexcept
+	: _ops(nullptr)
+	{
+	}
+
+	template<class F, class D = typename std::decay<F>::type, class = typename std::enable_if<!std::is_same<D, Callable>::value>::type>
+	Callable(F&& function)
+	: _ops(nullptr)
+	{
+		if (isNull(function))
+		{
+			return;
+		}
+		D copy(std::forward<F>(function));
+		init(std::move(copy), fitsInline<D>());
+	}
+
+	Callable(Callable&& that) noexcept
+	: _ops(that._ops)
+	{
+		if (_ops != nullptr)
+		{
+			_ops->relocate(that._storage, _storage);
+			that._ops = nullptr;
+		}
+	}
+
+	Callable& operator=(Callable&& that) noexcept
+	{
+		if (this != &that)
+		{
+			reset();
+			if (that._ops != nullptr)
+			{
+				that._ops->relocate(that._storage, _storage);
+				_ops = that._ops;
+				that._ops = nullptr;
+			}
+		}
+		return *this;
+	}
+
+	Callable& operator=(std::nullptr_t) noexcept
+	{
+		reset();
+		return *this;
+	}
+
+	Callable(const Callable&) = delete;
+	Callable& operator=(const Callable&) = delete;
+
+	~Callable()
+	{
+		reset();
+	}
+
+	explicit operator bool() const noexcept
+	{
+		return _ops != nullptr;
+	}
+
+	void operator()() const
+	{
+		_ops->invoke(const_cast<char*>(_storage));
+	}
+};
+
+template<class F>
+constexpr Callable::Ops Callable::Inline<F>::ops;
+
+template<class F>
+constexpr Callable::Ops Callable::Boxed<F>::ops;
@@ -0,0 +1,203 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// CoroContext.cpp
+
+
+#include "CoroContext.hpp"
+
+#if defined(__x86_64__)
+
+// rdi - контекст
+asm(R"(
+	.pushsection .text
+	.globl coroSaveContext
+	.type coroSaveContext, @function
+	.p2align 4
+coroSaveContext:
+	movq (%rsp), %rax
+	movq %rax, 8(%rdi)
+	leaq 8(%rsp), %rax
+	movq %rax, 0(%rdi)
+	movq %rbx, 16(%rdi)
+	movq %rbp, 24(%rdi)
+	movq %r12, 32(%rdi)
+	movq %r13, 40(%rdi)
+	movq %r14, 48(%rdi)
+	movq %r15, 56(%rdi)
+	stmxcsr 64(%rdi)
+	fnstcw 68(%rdi)
+	xorl %eax, %eax
+	ret
+	.size coroSaveContext, .-coroSaveContext
+
+	.globl coroRestoreContext
+	.type coroRestoreContext, @function
+	.p2align 4
+coroRestoreContext:
+	movq 16(%rdi), %rbx
+	movq 24(%rdi), %rbp
+	movq 32(%rdi), %r12
+	movq 40(%rdi), %r13
+	movq 48(%rdi), %r14
+	movq 56(%rdi), %r15
+	ldmxcsr 64(%rdi)
+	fldcw 68(%rdi)
+	movq 0(%rdi), %rsp
+	xorl %eax, %eax
+	jmpq *8(%rdi)
+	.size coroRestoreContext, .-coroRestoreContext
+
+	.type coroEntryTrampoline, @function
+	.p2align 4
+coroEntryTrampoline:
+	movq %r13, %rdi
+	movq %r14, %rsi
+	movq %r15, %rdx
+	callq *%r12
+	ud2
+	.size coroEntryTrampoline, .-coroEntryTrampoline
+
+	.globl coroEntryTrampolineAddress
+	.type coroEntryTrampolineAddress, @function
+	.p2align 4
+coroEntryTrampolineAddress:
+	leaq coroEntryTrampoline(%rip), %rax
+	ret
+	.size coroEntryTrampolineAddress, .-coroEntryTrampolineAddress
+	.popsection
+)");
+
+extern "C" void* coroEntryTrampolineAddress();
+
+void coroMakeContext(CoroContext* context, void (*entry)(void*, void*, void*), void* a, void* b, void* c)
+{
+	// Состояние FPU/SSE наследуем от создающего
+	coroSaveContext(context);
+
+	auto top = reinterpret_cast<uintptr_t>(context->stack) + context->stackSize;
+
+	// На входе в трамплин стек выровнен на 16: его call даст entry привычное выравнивание
+	context->registers[0] = top & ~uintptr_t(15);
+	context->registers[1] = reinterpret_cast<uintptr_t>(coroEntryTrampolineAddress());
+	context->registers[3] = 0;
+	context->registers[4] = reinterpret_cast<uintptr_t>(entry);
+	context->registers[5] = reinterpret_cast<uintptr_t>(a);
+	context->registers[6] = reinterpret_cast<uintptr_t>(b);
+	context->registers[7] = reinterpret_cast<uintptr_t>(c);
+}
+
+#elif defined(__aarch64__)
+
+// x0 - контекст
+asm(R"(
+	.pushsection .text
+	.globl coroSaveContext
+	.type coroSaveContext, %function
+	.p2align 4
+coroSaveContext:
+	mov x9, sp
+	stp x9, x30, [x0, #0]
+	stp x19, x20, [x0, #16]
+	stp x21, x22, [x0, #32]
+	stp x23, x24, [x0, #48]
+	stp x25, x26, [x0, #64]
+	stp x27, x28, [x0, #80]
+	str x29, [x0, #96]
+	stp d8, d9, [x0, #104]
+	stp d10, d11, [x0, #120]
+	stp d12, d13, [x0, #136]
+	stp d14, d15, [x0, #152]
+	mrs x9, fpcr
+	str x9, [x0, #168]
+	mov x0, #0
+	ret
+	.size coroSaveContext, .-coroSaveContext
+
+	.globl coroRestoreContext
+	.type coroRestoreContext, %function
+	.p2align 4
+coroRestoreContext:
+	ldp x19, x20, [x0, #16]
+	ldp x21, x22, [x0, #32]
+	ldp x23, x24, [x0, #48]
+	ldp x25, x26, [x0, #64]
+	ldp x27, x28, [x0, #80]
+	ldr x29, [x0, #96]
+	ldp d8, d9, [x0, #104]
+	ldp d10, d11, [x0, #120]
+	ldp d12, d13, [x0, #136]
+	ldp d14, d15, [x0, #152]
+	ldr x9, [x0, #168]
+	msr fpcr, x9
+	ldp x9, x30, [x0, #0]
+	mov sp, x9
+	mov x0, #0
+	br x30
+	.size coroRestoreContext, .-coroRestoreContext
+
+	.type coroEntryTrampoline, %function
+	.p2align 4
+coroEntryTrampoline:
+	mov x0, x20
+	mov x1, x21
+	mov x2, x22
+	blr x19
+	brk #0
+	.size coroEntryTrampoline, .-coroEntryTrampoline
+
+	.globl coroEntryTrampolineAddress
+	.type coroEntryTrampolineAddress, %function
+	.p2align 4
+coroEntryTrampolineAddress:
+	adr x0, coroEntryTrampoline
+	ret
+	.size coroEntryTrampolineAddress, .-coroEntryTrampolineAddress
+	.popsection
+)");
+
+extern "C" void* coroEntryTrampolineAddress();
+
+void coroMakeContext(CoroContext* context, void (*entry)(void*, void*, void*), void* a, void* b, void* c)
+{
+	coroSaveContext(context);
+
+	auto top = reinterpret_cast<uintptr_t>(context->stack) + context->stackSize;
+
+	context->registers[0] = top & ~uintptr_t(15);
+	context->registers[1] = reinterpret_cast<uintptr_t>(coroEntryTrampolineAddress());
+	context->registers[2] = reinterpret_cast<uintptr_t>(entry);
+	context->registers[3] = reinterpret_cast<uintptr_t>(a);
+	context->registers[4] = reinterpret_cast<uintptr_t>(b);
+	context->registers[5] = reinterpret_cast<uintptr_t>(c);
+	context->registers[12] = 0;
+}
+
+#else
+
+void coroMakeContext(CoroContext* context, void (*entry)(void*, void*, void*), void* a, void* b, void* c)
+{
+	getcontext(&context->ucontext);
+	context->ucontext.uc_link = nullptr;
+	context->ucontext.uc_stack.ss_sp = context->stack;
+	context->ucontext.uc_stack.ss_size = context->stackSize;
+	context->ucontext.uc_stack.ss_flags = 0;
+	makecontext(&context->ucontext, reinterpret_cast<void (*)()>(entry), sizeof(void*) * 3 / sizeof(int), a, b, c);
+}
+
+#endif
@@ -0,0 +1,70 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// CoroContext.hpp
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if !defined(__x86_64__) && !defined(__aarch64__)
+#include <ucontext.h>
+#endif
+
+/// Контекст исполнения сопрограммы и его стек.
+/// На x86-64 и aarch64 переключение сохраняет только регистры, которые вызываемая функция
+/// обязана сохранить по ABI, и не трогает маску сигналов (потоки пула блокируют все сигналы),
+/// поэтому обходится без системных вызовов. На прочих архитектурах - ucontext
+struct CoroContext final
+{
+#if defined(__x86_64__)
+	/// rsp, rip, rbx, rbp, r12-r15, mxcsr и управляющее слово x87
+	uint64_t registers[9];
+#elif defined(__aarch64__)
+	/// sp, pc (lr), x19-x29, d8-d15 и fpcr
+	uint64_t registers[22];
+#else
+	ucontext_t ucontext;
+#endif
+
+	/// Стек сопрограммы
+	void* stack;
+	size_t stackSize;
+};
+
+#if defined(__x86_64__) || defined(__aarch64__)
+extern "C"
+{
+	/// Сохранить точку исполнения (аналог getcontext): управление вернется сюда еще раз,
+	/// когда контекст будет восстановлен
+	void coroSaveContext(CoroContext* context) __attribute__((returns_twice));
+
+	/// Восстановить сохраненный контекст (аналог setcontext)
+	void coroRestoreContext(const CoroContext* context) __attribute__((noreturn));
+}
+#else
+// getcontext нельзя обернуть функцией: ее кадр не переживет возврата
+#define coroSaveContext(context) ((void)getcontext(&(context)->ucontext))
+#define coroRestoreContext(context) ((void)setcontext(&(context)->ucontext))
+#endif
+
+/// Подготовить контекст, чтобы его восстановление запустило entry(a, b, c) на стеке контекста
+/// (аналог makecontext). Возврат из entry недопустим
+void coroMakeContext(CoroContext* context, void (*entry)(void*, void*, void*), void* a, void* b, void* c);
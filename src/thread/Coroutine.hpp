@@ -0,0 +1,326 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// Coroutine.hpp
+
+
+#pragma once
+
+#if !defined(__cpp_impl_coroutine)
+#error "Coroutine.hpp requires C++20 coroutines: configure with -DWITH_COROUTINES=ON"
+#endif
+
+#include <coroutine>
+#include <exception>
+#include <type_traits>
+#include <utility>
+#include "TaskManager.hpp"
+#include "../log/Log.hpp"
+
+/// Бесстековая сопрограмма C++20, возвращающая T.
+/// Запускается лениво: тело начинает выполняться при co_await из другой сопрограммы
+/// или при Coroutine<>::spawn(). Существует параллельно с сопрограммами на ucontext
+/// (Thread::yield): обработчики можно переводить на co_await по одному
+template<typename T = void>
+class Coroutine;
+
+namespace coroutine_detail
+{
+	struct PromiseBase
+	{
+		/// Сопрограмма, ожидающая результата (продолжается по завершении)
+		std::coroutine_handle<> continuation;
+		std::exception_ptr exception;
+
+		std::suspend_always initial_suspend() noexcept
+		{
+			return {};
+		}
+
+		struct FinalAwaiter final
+		{
+			bool await_ready() noexcept
+			{
+				return false;
+			}
+			template<typename Promise>
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+			{
+				// Симметричная передача управления: ожидающий продолжается без роста стека
+				auto continuation = handle.promise().continuation;
+				return continuation ? continuation : std::noop_coroutine();
+			}
+			void await_resume() noexcept
+			{
+			}
+		};
+
+		FinalAwaiter final_suspend() noexcept
+		{
+			return {};
+		}
+
+		void unhandled_exception() noexcept
+		{
+			exception = std::current_exception();
+		}
+	};
+
+	template<typename T>
+	struct Promise final : PromiseBase
+	{
+		T value{};
+
+		Coroutine<T> get_return_object() noexcept;
+
+		template<typename V>
+		void return_value(V&& result)
+		{
+			value = std::forward<V>(result);
+		}
+
+		T take()
+		{
+			if (exception)
+			{
+				std::rethrow_exception(exception);
+			}
+			return std::move(value);
+		}
+	};
+
+	template<>
+	struct Promise<void> final : PromiseBase
+	{
+		Coroutine<void> get_return_object() noexcept;
+
+		void return_void() noexcept
+		{
+		}
+
+		void take()
+		{
+			if (exception)
+			{
+				std::rethrow_exception(exception);
+			}
+		}
+	};
+
+	/// Сопрограмма-владелец запущенной через spawn(): кадр уничтожается по завершении
+	struct Detached final
+	{
+		struct promise_type final
+		{
+			Detached get_return_object() noexcept
+			{
+				return {};
+			}
+			std::suspend_never initial_suspend() noexcept
+			{
+				return {};
+			}
+			std::suspend_never final_suspend() noexcept
+			{
+				return {};
+			}
+			void return_void() noexcept
+			{
+			}
+			void unhandled_exception() noexcept
+			{
+			}
+		};
+	};
+}
+
+template<typename T>
+class Coroutine final
+{
+public:
+	using promise_type = coroutine_detail::Promise<T>;
+	using Handle = std::coroutine_handle<promise_type>;
+
+private:
+	Handle _handle;
+
+	static coroutine_detail::Detached detach(Coroutine coroutine, const char* label)
+	{
+		try
+		{
+			co_await std::move(coroutine);
+		}
+		catch (const std::exception& exception)
+		{
+			Log("Coroutine").error("Uncatched exception in coroutine '%s': %s", label, exception.what());
+		}
+		catch (...)
+		{
+			Log("Coroutine").error("Uncatched exception in coroutine '%s'", label);
+		}
+	}
+
+public:
+	explicit Coroutine(Handle handle) noexcept
+	: _handle(handle)
+	{
+	}
+
+	Coroutine(Coroutine&& that) noexcept
+	: _handle(std::exchange(that._handle, nullptr))
+	{
+	}
+	Coroutine& operator=(Coroutine&& that) noexcept
+	{
+		if (this != &that)
+		{
+			if (_handle)
+			{
+				_handle.destroy();
+			}
+			_handle = std::exchange(that._handle, nullptr);
+		}
+		return *this;
+	}
+
+	// Запрещаем любое копирование
+	Coroutine(const Coroutine&) = delete;
+	Coroutine& operator=(const Coroutine&) = delete;
+
+	~Coroutine()
+	{
+		if (_handle)
+		{
+			_handle.destroy();
+		}
+	}
+
+	bool await_ready() const noexcept
+	{
+		return !_handle || _handle.done();
+	}
+
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+	{
+		_handle.promise().continuation = awaiting;
+		return _handle;
+	}
+
+	T await_resume()
+	{
+		return _handle.promise().take();
+	}
+
+	/// Запустить сопрограмму в пуле потоков, не дожидаясь результата.
+	/// Исключение, вылетевшее из сопрограммы, пишется в лог
+	static void spawn(Coroutine&& coroutine, const char* label = "coroutine")
+	{
+		TaskManager::enqueue(
+			[coroutine = std::move(coroutine), label]() mutable
+			{
+				detach(std::move(coroutine), label);
+			},
+			label
+		);
+	}
+};
+
+namespace coroutine_detail
+{
+	template<typename T>
+	Coroutine<T> Promise<T>::get_return_object() noexcept
+	{
+		return Coroutine<T>(Coroutine<T>::Handle::from_promise(*this));
+	}
+
+	inline Coroutine<void> Promise<void>::get_return_object() noexcept
+	{
+		return Coroutine<void>(Coroutine<void>::Handle::from_promise(*this));
+	}
+}
+
+/// Ожидание события, о котором сообщает обработчик (мост от API с обработчиками к co_await).
+/// Start получает Resume<T> и запускает операцию; операция вызывает Resume<T> ровно один раз,
+/// передавая результат. Сопрограмма продолжается отдельной задачей пула потоков или,
+/// если inlineResume, прямо в потоке, вызвавшем Resume (например, в обработке соединения)
+template<typename T, typename Start>
+class Suspend final
+{
+public:
+	class Resume final
+	{
+	private:
+		std::coroutine_handle<> _handle;
+		T* _result;
+		bool _inline;
+
+	public:
+		Resume(std::coroutine_handle<> handle, T* result, bool inlineResume) noexcept
+		: _handle(handle)
+		, _result(result)
+		, _inline(inlineResume)
+		{
+		}
+
+		void operator()(T result) const
+		{
+			*_result = std::move(result);
+			if (_inline)
+			{
+				_handle.resume();
+				return;
+			}
+			TaskManager::enqueue([handle = _handle]{ handle.resume(); }, "resume coroutine");
+		}
+	};
+
+private:
+	Start _start;
+	T _result;
+	bool _inline;
+
+public:
+	Suspend(Start start, bool inlineResume)
+	: _start(std::move(start))
+	, _result()
+	, _inline(inlineResume)
+	{
+	}
+
+	bool await_ready() const noexcept
+	{
+		return false;
+	}
+
+	void await_suspend(std::coroutine_handle<> handle)
+	{
+		// После запуска операции объект не трогаем: сопрограмма может быть уже продолжена другим потоком
+		_start(Resume(handle, &_result, _inline));
+	}
+
+	T await_resume()
+	{
+		return std::move(_result);
+	}
+};
+
+template<typename T, typename Start>
+Suspend<T, typename std::decay<Start>::type> suspend(Start&& start, bool inlineResume = false)
+{
+	return Suspend<T, typename std::decay<Start>::type>(std::forward<Start>(start), inlineResume);
+}
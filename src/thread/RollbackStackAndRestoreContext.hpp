@@ -27,11 +27,11 @@
 class RollbackStackAndRestoreContext final: public std::exception
 {
 private:
-	ucontext_t* _context;
+	CoroContext* _context;
 
 public:
 	RollbackStackAndRestoreContext() = delete;
-	RollbackStackAndRestoreContext(ucontext_t* context) noexcept
+	RollbackStackAndRestoreContext(CoroContext* context) noexcept
 	: _context(context)
 	{
 	};
@@ -0,0 +1,174 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// StackPool.cpp
+
+
+#include "StackPool.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+
+StackPool::StackPool()
+: _pageSize(static_cast<size_t>(sysconf(_SC_PAGESIZE)))
+, _stackSize(1ull<<20)
+, _trim(false)
+, _inUse(0)
+, _highWater(0)
+{
+}
+
+StackPool::Cache::~Cache()
+{
+	// Поток завершается - его запас переходит в общий список
+	for (auto context : contexts)
+	{
+		StackPool::getInstance().unmap(context);
+	}
+	contexts.clear();
+}
+
+StackPool::Cache& StackPool::cache()
+{
+	static thread_local Cache instance;
+	return instance;
+}
+
+void StackPool::configure(size_t stackSize, bool trim)
+{
+	auto& instance = getInstance();
+
+	std::lock_guard<std::mutex> lockGuard(instance._mutex);
+
+	instance._stackSize = (std::max(stackSize, 4 * instance._pageSize) + instance._pageSize - 1) & ~(instance._pageSize - 1);
+	instance._trim = trim;
+
+	// Стеки прежнего размера больше не раздаем
+	for (auto context : instance._shared)
+	{
+		::munmap(static_cast<char*>(context->stack) - instance._pageSize, instance.mappingSize(context->stackSize));
+	}
+	instance._shared.clear();
+}
+
+size_t StackPool::mappingSize(size_t stackSize) const
+{
+	// [охранная страница][стек][контекст]
+	return _pageSize + stackSize + ((sizeof(CoroContext) + _pageSize - 1) & ~(_pageSize - 1));
+}
+
+CoroContext* StackPool::map()
+{
+	auto total = mappingSize(_stackSize);
+
+	auto base = static_cast<char*>(::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0));
+	if (base == MAP_FAILED)
+	{
+		throw std::runtime_error(std::string("Can't to map memory for stack of context ← ") + strerror(errno));
+	}
+
+	if (::mprotect(base, _pageSize, PROT_NONE) != 0)
+	{
+		::munmap(base, total);
+		throw std::runtime_error(std::string("Can't protect guard page of stack ← ") + strerror(errno));
+	}
+
+	auto context = new (base + _pageSize + _stackSize) CoroContext{};
+	context->stack = base + _pageSize;
+	context->stackSize = _stackSize;
+	return context;
+}
+
+void StackPool::unmap(CoroContext* context)
+{
+	std::lock_guard<std::mutex> lockGuard(_mutex);
+
+	// Стек устаревшего размера или общий список полон - освобождаем
+	if (_shared.size() >= sharedLimit || context->stackSize != _stackSize)
+	{
+		::munmap(static_cast<char*>(context->stack) - _pageSize, mappingSize(context->stackSize));
+		return;
+	}
+
+	_shared.push_back(context);
+}
+
+CoroContext* StackPool::acquire()
+{
+	auto& instance = getInstance();
+	auto& local = cache();
+
+	CoroContext* context = nullptr;
+
+	if (!local.contexts.empty())
+	{
+		context = local.contexts.back();
+		local.contexts.pop_back();
+	}
+	else
+	{
+		{
+			std::lock_guard<std::mutex> lockGuard(instance._mutex);
+
+			if (!instance._shared.empty())
+			{
+				context = instance._shared.back();
+				instance._shared.pop_back();
+			}
+		}
+		if (context == nullptr)
+		{
+			context = instance.map();
+		}
+	}
+
+	auto inUse = ++instance._inUse;
+	auto highWater = instance._highWater.load();
+	while (inUse > highWater && !instance._highWater.compare_exchange_weak(highWater, inUse))
+	{
+	}
+
+	return context;
+}
+
+void StackPool::release(CoroContext* context)
+{
+	auto& instance = getInstance();
+	auto& local = cache();
+
+	--instance._inUse;
+
+	// Страницы стека отдаем ядру; отображение и охранная страница сохраняются
+	if (instance._trim)
+	{
+		::madvise(context->stack, context->stackSize, MADV_DONTNEED);
+	}
+
+	if (local.contexts.size() < cacheLimit)
+	{
+		local.contexts.push_back(context);
+		return;
+	}
+
+	instance.unmap(context);
+}
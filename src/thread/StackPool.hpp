@@ -0,0 +1,100 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// StackPool.hpp
+
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+#include "CoroContext.hpp"
+
+/// Пул стеков сопрограмм (Thread::yield). Стек отображается один раз, с охранной страницей
+/// под нижней границей, и после завершения сопрограммы возвращается в пул, а не освобождается.
+/// Контекст сопрограммы размещается в верхней части того же отображения.
+/// У каждого потока свой небольшой запас без блокировок, излишки уходят в общий список
+class StackPool final
+{
+public:
+	StackPool(const StackPool&) = delete;
+	StackPool& operator=(const StackPool&) = delete;
+	StackPool(StackPool&&) noexcept = delete;
+	StackPool& operator=(StackPool&&) noexcept = delete;
+
+private:
+	StackPool();
+	~StackPool() = default;
+
+	static StackPool& getInstance()
+	{
+		static StackPool instance;
+		return instance;
+	}
+
+	/// Запас потока
+	struct Cache final
+	{
+		std::vector<CoroContext*> contexts;
+		~Cache();
+	};
+
+	static Cache& cache();
+
+	static const size_t cacheLimit = 16;
+	static const size_t sharedLimit = 256;
+
+	std::mutex _mutex;
+	std::vector<CoroContext*> _shared;
+
+	size_t _pageSize;
+	size_t _stackSize;
+	bool _trim;
+
+	std::atomic_size_t _inUse;
+	std::atomic_size_t _highWater;
+
+	size_t mappingSize(size_t stackSize) const;
+
+	CoroContext* map();
+	void unmap(CoroContext* context);
+
+public:
+	/// Размер стека (округляется до страницы) и возврат памяти простаивающих стеков ядру
+	static void configure(size_t stackSize, bool trim);
+
+	/// Контекст с подготовленным стеком (поля стека заполнены)
+	static CoroContext* acquire();
+
+	/// Вернуть контекст и его стек в пул
+	static void release(CoroContext* context);
+
+	/// Стеки, занятые сопрограммами
+	static size_t inUse()
+	{
+		return getInstance()._inUse.load();
+	}
+
+	/// Наибольшее число одновременно занятых стеков
+	static size_t highWater()
+	{
+		return getInstance()._highWater.load();
+	}
+};
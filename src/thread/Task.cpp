@@ -38,7 +38,6 @@ Task::Task(Task&& that) noexcept
 , _label(that._label)
 , _parentTaskContext(that._parentTaskContext)
 {
-	that._function = static_cast<void(*)()>(nullptr);
 	that._parentTaskContext = nullptr;
 }
 
@@ -53,7 +52,6 @@ Task& Task::operator=(Task&& that) noexcept
 	_until = that._until;
 	_label = that._label;
 	_parentTaskContext = that._parentTaskContext;
-	that._function = static_cast<void(*)()>(nullptr);
 	that._parentTaskContext = nullptr;
 
 	return *this;
@@ -22,15 +22,15 @@
 #pragma once
 
 
-#include <functional>
 #include <chrono>
-#include <ucontext.h>
+#include "CoroContext.hpp"
+#include "Callable.hpp"
 #include "../utils/Shareable.hpp"
 
 class Task final
 {
 public:
-	using Func = std::function<void()>;
+	using Func = Callable;
 	using Clock = std::chrono::steady_clock;
 	using Duration = Clock::duration;
 	using Time = Clock::time_point;
@@ -39,7 +39,7 @@ private:
 	Func _function;
 	Time _until;
 	const char* _label;
-	mutable ucontext_t* _parentTaskContext;
+	mutable CoroContext* _parentTaskContext;
 
 public:
 	explicit Task(Func&& function, Time until, const char* label = "-");
@@ -21,133 +21,339 @@
 
 #include "TaskManager.hpp"
 #include "../utils/Daemon.hpp"
+#include "Thread.hpp"
 #include "ThreadPool.hpp"
 #include "RollbackStackAndRestoreContext.hpp"
+#include "../utils/TimerWheel.hpp"
+#include <algorithm>
 
-#if __cplusplus < 201703L
-#define constexpr
-#endif
+thread_local TaskManager::Local* TaskManager::_local = nullptr;
+thread_local bool TaskManager::_longRunning = false;
 
 TaskManager::TaskManager()
 : _log("TaskManager")//, Log::Detail::TRACE)
+, _nextDue(Task::Time::max().time_since_epoch().count())
+, _localCount(0)
+, _ready(0)
 {
+	for (auto& local : _locals)
+	{
+		local.store(nullptr);
+	}
+}
+
+TaskManager::Local* TaskManager::local()
+{
+	if (_local != nullptr || Thread::self() == nullptr)
+	{
+		return _local;
+	}
+
+	// Поток пула обращается впервые - заводим ему очередь
+	auto& instance = getInstance();
+
+	auto index = instance._localCount.fetch_add(1);
+	if (index >= maxWorkers)
+	{
+		instance._localCount.fetch_sub(1);
+		return nullptr;
+	}
+
+	_local = new Local;
+	instance._locals[index].store(_local);
+
+	return _local;
 }
 
 void TaskManager::enqueue(Task::Func&& func, Task::Time time, const char* label)
 {
 	auto& instance = getInstance();
 
+	if (time > Task::Clock::now())
 	{
 		std::lock_guard<mutex_t> lockGuard(instance._mutex);
 
-		instance._queue.emplace(std::forward<Task::Func>(func), time, label);
+		instance._delayed.emplace_back(std::forward<Task::Func>(func), time, label);
+		std::push_heap(instance._delayed.begin(), instance._delayed.end());
+
+		instance._nextDue.store(instance._delayed.front().until().time_since_epoch().count());
 
-		if constexpr (std::is_same<mutex_t, std::recursive_mutex>::value)
+		// Спящие проснутся к сроку ближайшей задачи сами; будим, только если она сменилась
+		if (instance._delayed.front().until() != time)
 		{
-			auto n = std::chrono::duration_cast<std::chrono::microseconds>(Task::Clock::now().time_since_epoch()).count();
-			auto u = std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count();
+			return;
+		}
+	}
+	else if (auto local = _longRunning ? nullptr : TaskManager::local())
+	{
+		std::lock_guard<std::mutex> lockGuard(local->mutex);
 
-			instance._log.trace("Task queue length increase to %zu: %s (after %lld)", instance._queue.size(), label, u - n);
+		// Новая задача занимает слот LIFO, вытесняя прежнюю в конец очереди
+		if (!local->lifo.empty())
+		{
+			local->tasks.emplace_back(std::move(local->lifo.front()));
+			local->lifo.pop_front();
+		}
+		local->lifo.emplace_back(std::forward<Task::Func>(func), time, label);
 
-			u = std::chrono::duration_cast<std::chrono::microseconds>(instance._queue.top().until().time_since_epoch()).count();
+		++instance._ready;
+	}
+	else
+	{
+		std::lock_guard<std::mutex> lockGuard(instance._injectMutex);
 
-			instance._log.trace(" Next task after %lld µs: %s", u - n, instance._queue.top().label());
-		}
+		instance._inject.emplace_back(std::forward<Task::Func>(func), time, label);
+
+		++instance._ready;
 	}
 
 	ThreadPool::wakeup();
 }
 
+void TaskManager::setLongRunning(bool longRunning)
+{
+	_longRunning = longRunning;
+
+	// Придержанное в слоте LIFO выполнит уже не этот поток - переносим в очередь, открытую для кражи
+	auto local = longRunning ? TaskManager::local() : nullptr;
+	if (local != nullptr)
+	{
+		std::lock_guard<std::mutex> lockGuard(local->mutex);
+
+		while (!local->lifo.empty())
+		{
+			local->tasks.emplace_back(std::move(local->lifo.front()));
+			local->lifo.pop_front();
+		}
+	}
+}
+
 Task::Time TaskManager::waitUntil()
 {
 	auto& instance = getInstance();
 
-	std::lock_guard<mutex_t> lockGuard(instance._mutex);
+	if (instance._ready.load() > 0)
+	{
+		return Task::Clock::now();
+	}
 
-	return
-		instance._queue.empty()
-		? Task::Clock::now() + std::chrono::seconds(1)
-		: instance._queue.top().until();
+	// Колесо таймеров тоже надо вовремя проворачивать
+	auto timerTime = TimerWheel::nextExpiry();
+
+	auto nextDue = Task::Time(Task::Duration(instance._nextDue.load()));
+
+	return std::min(
+		std::min(nextDue, Task::Clock::now() + std::chrono::seconds(1)),
+		timerTime
+	);
 }
 
 void TaskManager::executeOne()
 {
 	auto& instance = getInstance();
 
-	instance._mutex.lock();
+	// Сработавшие таймеры встают в очередь немедленными задачами
+	TimerWheel::advance();
 
-	if (instance._queue.empty())
-	{
-		if constexpr (std::is_same<mutex_t, std::recursive_mutex>::value)
-		{
-			instance._log.trace("Empty task queue");
-		}
+	// Наступившие отложенные задачи становятся обычными готовыми
+	instance.promoteDue();
 
-		instance._mutex.unlock();
+	auto local = TaskManager::local();
+	if (local == nullptr)
+	{
+		instance.runInject();
 		return;
 	}
 
-	if constexpr (std::is_same<mutex_t, std::recursive_mutex>::value)
+	// Время от времени сначала смотрим общую очередь, чтобы ее задачи не голодали
+	if (++local->ticks % globalCheckInterval == 0)
 	{
-		auto u = std::chrono::duration_cast<std::chrono::microseconds>(instance._queue.top().until().time_since_epoch()).count();
-		auto n = std::chrono::duration_cast<std::chrono::microseconds>(Task::Clock::now().time_since_epoch()).count();
-
-		if (u > n && !Daemon::shutingdown())
+		if (instance.runInject())
 		{
-			instance._log.trace("Reenqueue task (wait for %lld µs): %s", u - n, instance._queue.top().label());
-			instance._mutex.unlock();
 			return;
 		}
 	}
+
+	instance.runLocal(*local)
+	|| instance.runInject()
+	|| instance.runStolen(*local);
+}
+
+bool TaskManager::runLocal(Local& local)
+{
+	std::unique_lock<std::mutex> lock(local.mutex);
+
+	std::deque<Task>* source;
+	if (!local.lifo.empty() && (local.lifoRuns < lifoLimit || local.tasks.empty()))
+	{
+		++local.lifoRuns;
+		source = &local.lifo;
+	}
+	else if (!local.tasks.empty())
+	{
+		local.lifoRuns = 0;
+		source = &local.tasks;
+	}
 	else
 	{
-		if (instance._queue.top().until() > Task::Clock::now() && !Daemon::shutingdown())
-		{
-			instance._mutex.unlock();
-			return;
-		}
+		return false;
 	}
 
-	Task task{const_cast<Task&&>(instance._queue.top())};
+	Task task(std::move(source->front()));
+	source->pop_front();
+
+	lock.unlock();
 
-	while (!instance._queue.empty() && instance._queue.top().isDummy())
+	execute(task);
+	return true;
+}
+
+bool TaskManager::runInject()
+{
+	std::unique_lock<std::mutex> lock(_injectMutex);
+
+	if (_inject.empty())
 	{
-		if constexpr (std::is_same<mutex_t, std::recursive_mutex>::value)
-		{
-			auto label = instance._queue.top().label();
-			instance._queue.pop();
+		return false;
+	}
 
-			instance._log.trace("Task queue length decrease to %zu: %s", instance._queue.size(), label);
-		}
-		else
+	Task task(std::move(_inject.front()));
+	_inject.pop_front();
+
+	lock.unlock();
+
+	execute(task);
+	return true;
+}
+
+void TaskManager::promoteDue()
+{
+	auto now = Task::Clock::now();
+
+	if (now.time_since_epoch().count() < _nextDue.load() && !Daemon::shutingdown())
+	{
+		return;
+	}
+
+	size_t count = 0;
+	{
+		std::lock_guard<mutex_t> lockGuard(_mutex);
+
+		// При остановке отложенные задачи выполняются немедленно
+		auto all = Daemon::shutingdown();
+
+		std::lock_guard<std::mutex> injectGuard(_injectMutex);
+
+		while (!_delayed.empty() && (all || _delayed.front().until() <= now))
 		{
-			instance._queue.pop();
+			std::pop_heap(_delayed.begin(), _delayed.end());
+			_inject.emplace_back(std::move(_delayed.back()));
+			_delayed.pop_back();
+			++count;
 		}
+
+		_ready += count;
+
+		_nextDue.store(
+			_delayed.empty()
+			? Task::Time::max().time_since_epoch().count()
+			: _delayed.front().until().time_since_epoch().count()
+		);
+	}
+
+	if (count > 1)
+	{
+		ThreadPool::wakeup();
+	}
+}
+
+bool TaskManager::runStolen(Local& thief)
+{
+	auto count = _localCount.load();
+	if (count < 2 || _ready.load() == 0)
+	{
+		return false;
+	}
+
+	// Начинаем с соседа после себя, чтобы воры не толпились у одной очереди
+	size_t self = 0;
+	while (self < count && _locals[self].load() != &thief)
+	{
+		++self;
 	}
 
-	if constexpr (std::is_same<mutex_t, std::recursive_mutex>::value)
+	for (size_t i = 1; i < count; ++i)
 	{
-		auto n = std::chrono::duration_cast<std::chrono::microseconds>(Task::Clock::now().time_since_epoch()).count();
-		auto u = std::chrono::duration_cast<std::chrono::microseconds>(task.until().time_since_epoch()).count();
+		auto victim = _locals[(self + i) % count].load();
+		if (victim == nullptr || victim == &thief)
+		{
+			continue;
+		}
 
-		if (!instance._queue.empty())
+		std::unique_lock<std::mutex> victimLock(victim->mutex);
+
+		auto n = (victim->tasks.size() + 1) / 2;
+		if (n == 0)
 		{
-			auto u = std::chrono::duration_cast<std::chrono::microseconds>(instance._queue.top().until().time_since_epoch()).count();
+			// Очередь пуста, но задача в слоте LIFO может ждать долго: владелец занят текущей
+			if (victim->lifo.empty())
+			{
+				continue;
+			}
+
+			Task task(std::move(victim->lifo.front()));
+			victim->lifo.pop_front();
 
-			instance._log.trace(" Next task after %lld µs: %s", u - n, instance._queue.top().label());
+			victimLock.unlock();
+
+			execute(task);
+			return true;
 		}
-		else
+
+		// Забираем половину с конца: первая украденная выполняется сразу, остальные - к себе
+		Task task(std::move(victim->tasks.back()));
+		victim->tasks.pop_back();
+
+		std::deque<Task> stolen;
+		while (--n > 0)
 		{
-			instance._log.trace(" No next task");
+			stolen.emplace_front(std::move(victim->tasks.back()));
+			victim->tasks.pop_back();
 		}
 
-		auto w = instance._queue.size();
-		instance._log.trace("Execute task (%zu waits) (late %lld µs)", w, n - u);
+		victimLock.unlock();
+
+		if (!stolen.empty())
+		{
+			{
+				std::lock_guard<std::mutex> lockGuard(thief.mutex);
+
+				for (auto& item : stolen)
+				{
+					thief.tasks.emplace_back(std::move(item));
+				}
+			}
+
+			// Для украденных остальных есть работа и у других простаивающих
+			ThreadPool::wakeup();
+		}
+
+		execute(task);
+		return true;
 	}
 
-	instance._mutex.unlock();
+	return false;
+}
 
-	ThreadPool::wakeup();
+void TaskManager::execute(Task& task)
+{
+	--_ready;
+
+	// Остались задачи - будим следующего исполнителя
+	if (_ready.load() > 0)
+	{
+		ThreadPool::wakeup();
+	}
 
 	try
 	{
@@ -159,7 +365,7 @@ void TaskManager::executeOne()
 	}
 	catch (const std::exception& exception)
 	{
-		instance._log.warn("Uncatched exception at execute task of pool: %s", exception.what());
+		_log.warn("Uncatched exception at execute task of pool: %s", exception.what());
 	}
 }
 
@@ -167,9 +373,18 @@ bool TaskManager::empty()
 {
 	auto& instance = getInstance();
 
-	std::lock_guard<mutex_t> lockGuard(instance._mutex);
+	if (instance._ready.load() > 0)
+	{
+		return false;
+	}
+
+	if (instance._nextDue.load() != Task::Time::max().time_since_epoch().count())
+	{
+		return false;
+	}
 
-	return instance._queue.empty();
+	// Взведенные таймеры - тоже будущие задачи
+	return TimerWheel::empty();
 }
 
 size_t TaskManager::queueSize()
@@ -178,5 +393,5 @@ size_t TaskManager::queueSize()
 
 	std::lock_guard<mutex_t> lockGuard(instance._mutex);
 
-	return instance._queue.size();
+	return instance._ready.load() + instance._delayed.size();
 }
@@ -22,14 +22,20 @@
 #pragma once
 
 
+#include <atomic>
 #include <memory>
 #include <deque>
-#include <queue>
 #include <mutex>
 #include <set>
+#include <vector>
 #include "Task.hpp"
 #include "../log/Log.hpp"
 
+/// Планировщик задач. Готовые задачи рабочего потока попадают в его собственную очередь
+/// (последняя порожденная - в слот LIFO, чтобы выполниться следующей, пока ее данные в кеше);
+/// простаивающий поток забирает половину чужой очереди, а при пустой очереди - и слот LIFO.
+/// Задачи из сторонних потоков (и из потоков, занятых бесконечной задачей) идут в общую очередь
+/// внедрения, отложенные - в общую кучу по времени, откуда наступившие переносятся пачкой в очередь внедрения
 class TaskManager final
 {
 public:
@@ -52,9 +58,64 @@ public:
 private:
 	using mutex_t =	std::mutex;
 
+	/// Очередь рабочего потока
+	struct Local final
+	{
+		std::mutex mutex;
+
+		/// Владелец берет с начала, вор - с конца
+		std::deque<Task> tasks;
+
+		/// Только что порожденная задача (не более одной, крадется последней - при пустой очереди)
+		std::deque<Task> lifo;
+
+		/// Подряд выполненные из слота LIFO (ограничение, чтобы не голодала очередь)
+		size_t lifoRuns = 0;
+
+		/// Счетчик выполненных задач (для периодической проверки общих очередей)
+		size_t ticks = 0;
+	};
+
+	static const size_t maxWorkers = 1u<<8;
+	static const size_t lifoLimit = 3;
+	static const size_t globalCheckInterval = 61;
+
+	static thread_local Local* _local;
+
+	/// Поток занят задачей, которая не вернется: порожденное им идет в очередь внедрения
+	static thread_local bool _longRunning;
+
 	Log _log;
+
+	/// Отложенные задачи (куча по времени: в начале - ближайшая)
 	mutex_t _mutex;
-	std::priority_queue<Task, std::deque<Task>> _queue;
+	std::vector<Task> _delayed;
+
+	/// Время ближайшей отложенной задачи (Time::max() - их нет); проверяется без блокировки
+	std::atomic<Task::Clock::rep> _nextDue;
+
+	/// Готовые задачи сторонних потоков
+	std::mutex _injectMutex;
+	std::deque<Task> _inject;
+
+	/// Очереди рабочих потоков (регистрируются при первом обращении потока)
+	std::atomic<Local*> _locals[maxWorkers];
+	std::atomic_size_t _localCount;
+
+	/// Готовые задачи во всех очередях
+	std::atomic_size_t _ready;
+
+	static Local* local();
+
+	/// Извлечь задачу из соответствующей очереди и выполнить ее (false - задачи нет)
+	bool runLocal(Local& local);
+	bool runInject();
+
+	/// Перенести наступившие отложенные задачи в очередь внедрения
+	void promoteDue();
+	bool runStolen(Local& thief);
+
+	void execute(Task& task);
 
 public:
 	static void enqueue(Task::Func&& func, Task::Time time, const char* label = "-");
@@ -69,6 +130,10 @@ public:
 		enqueue(std::forward<Task::Func>(func), Task::Clock::now(), label);
 	}
 
+	/// Текущий поток входит в бесконечную задачу (например, цикл реактора) или выходит из нее:
+	/// выполнить задачи своего слота LIFO он не сможет, поэтому новые отдает другим потокам
+	static void setLongRunning(bool longRunning);
+
 	static size_t queueSize();
 
 	static Task::Time waitUntil();
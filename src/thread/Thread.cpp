@@ -24,21 +24,21 @@
 #include "../log/LoggerManager.hpp"
 #include "RollbackStackAndRestoreContext.hpp"
 #include "TaskManager.hpp"
+#include "StackPool.hpp"
 
 #include <csignal>
-#include <sys/mman.h>
 thread_local Log Thread::_log("Thread");
 thread_local std::function<void()> Thread::_function;
 
 thread_local Thread* Thread::_self = nullptr;
-thread_local ucontext_t* Thread::_currentContext = nullptr;
+thread_local CoroContext* Thread::_currentContext = nullptr;
 thread_local size_t Thread::_currentContextCount = 0;
-thread_local ucontext_t* Thread::_obsoletedContext = nullptr;
-thread_local ucontext_t* Thread::_replacedContext = nullptr;
-thread_local std::queue<ucontext_t*> Thread::_replacedContexts;
+thread_local CoroContext* Thread::_obsoletedContext = nullptr;
+thread_local CoroContext* Thread::_replacedContext = nullptr;
+thread_local std::queue<CoroContext*> Thread::_replacedContexts;
 
-thread_local ucontext_t* Thread::_contextPtrBuffer = nullptr;
-thread_local ucontext_t* Thread::_currentTaskContextPtrBuffer = nullptr;
+thread_local CoroContext* Thread::_contextPtrBuffer = nullptr;
+thread_local CoroContext* Thread::_currentTaskContextPtrBuffer = nullptr;
 
 std::mutex Thread::_atCloseMutex;
 std::deque<std::function<void ()>> Thread::_atCloseHandlers;
@@ -123,7 +123,7 @@ void Thread::execute(Thread* thread)
 	}
 }
 
-void Thread::coroWrapper(Thread *thread, ucontext_t* context, std::mutex* mutex)
+void Thread::coroWrapper(Thread *thread, CoroContext* context, std::mutex* mutex)
 {
 	if (mutex)
 	{
@@ -154,7 +154,7 @@ void Thread::coroWrapper(Thread *thread, ucontext_t* context, std::mutex* mutex)
 
 		ThreadPool::getInstance()._contextsMutex.unlock();
 
-		setcontext(contextForReplace);
+		coroRestoreContext(contextForReplace);
 	}
 	ThreadPool::getInstance()._contextsMutex.unlock();
 }
@@ -163,13 +163,13 @@ void Thread::yield(Task::Func&& func)
 {
 	volatile bool first = true;
 
-	ucontext_t* context = nullptr;
+	CoroContext* context = nullptr;
 
 	std::mutex orderMutex;
-	ucontext_t retContext{};
+	CoroContext retContext{};
 
 	// Получить контекст
-	getcontext(&retContext);
+	coroSaveContext(&retContext);
 
 	if (first)
 	{
@@ -194,57 +194,22 @@ void Thread::yield(Task::Func&& func)
 			"yield"
 		);
 
-		context = new ucontext_t{};
-		getcontext(context);
-		context->uc_link = (ucontext_t*)0xDEAD;
-		context->uc_stack.ss_flags = 0;
-		context->uc_stack.ss_size = 1ull<<20; // PTHREAD_STACK_MIN;
-		context->uc_stack.ss_sp = mmap(
-			nullptr, context->uc_stack.ss_size,
-			PROT_READ | PROT_WRITE | PROT_EXEC,
-			MAP_PRIVATE | MAP_ANON, -1, 0
-		);
-
-		if (context->uc_stack.ss_sp == MAP_FAILED)
-		{
-			_log.warn("Can't to map memory for stack of context");
+		// Стек берем из пула: отображение с охранной страницей переиспользуется
+		context = StackPool::acquire();
 
-			delete context;
-
-			throw std::runtime_error("Can't to map memory for stack of context");
-		}
+		coroMakeContext(context, reinterpret_cast<void (*)(void*, void*, void*)>(coroWrapper), this, context, &orderMutex);
 
-//		_log.info(
-//			"Map memory for stack of context %p (%zu on %p) => %lld",
-//			context,
-//			context->uc_stack.ss_size,
-//			context->uc_stack.ss_sp
-//		);
-
-		makecontext(context, reinterpret_cast<void (*)()>(coroWrapper), sizeof(void*) * 3 / sizeof(int), this, context, &orderMutex);
-
-		if (setcontext(context))
-		{
-			throw std::runtime_error("Can't change context");
-		}
+		coroRestoreContext(context);
 	}
 
 	if (_obsoletedContext)
 	{
-//		_log.info(
-//			"UnMap memory for stack of context %p (%zu on %p)",
-//			_obsoletedContext,
-//			_obsoletedContext->uc_stack.ss_size,
-//			_obsoletedContext->uc_stack.ss_sp
-//		);
-
-		munmap(_obsoletedContext->uc_stack.ss_sp, _obsoletedContext->uc_stack.ss_size);
-		delete _obsoletedContext;
+		StackPool::release(_obsoletedContext);
 		_obsoletedContext = nullptr;
 	}
 }
 
-void Thread::setCurrTaskContext(ucontext_t* context)
+void Thread::setCurrTaskContext(CoroContext* context)
 {
 	if (_currentTaskContextPtrBuffer && context)
 	{
@@ -254,23 +219,23 @@ void Thread::setCurrTaskContext(ucontext_t* context)
 //	_self->_log.info("setCurrTaskContext <= %p", context);
 }
 
-ucontext_t* Thread::getCurrTaskContext()
+CoroContext* Thread::getCurrTaskContext()
 {
-	ucontext_t* context = _currentTaskContextPtrBuffer;
+	CoroContext* context = _currentTaskContextPtrBuffer;
 //	_self->_log.info("getCurrTaskContext => %p", context);
 	return context;
 }
 
-void Thread::putContext(ucontext_t* context)
+void Thread::putContext(CoroContext* context)
 {
 	_contextPtrBuffer = context;
 //	_self->_log.info("putContext <= %p", context);
 }
 
 // Извлекаем указатель на контекст из буффера потока
-ucontext_t* Thread::getContext()
+CoroContext* Thread::getContext()
 {
-	ucontext_t* context = _contextPtrBuffer;
+	CoroContext* context = _contextPtrBuffer;
 	_contextPtrBuffer = nullptr;
 //	if (_self)
 //	{
@@ -279,15 +244,15 @@ ucontext_t* Thread::getContext()
 	return context;
 }
 
-void Thread::putContextForReplace(ucontext_t* context)
+void Thread::putContextForReplace(CoroContext* context)
 {
 	_replacedContexts.emplace(context);
 //	_self->_log.info("setContextForReplace <= %p (%zu)", context, _replacedContexts.size());
 }
 
-ucontext_t* Thread::getContextForReplace()
+CoroContext* Thread::getContextForReplace()
 {
-	ucontext_t* context = _replacedContexts.front();
+	CoroContext* context = _replacedContexts.front();
 	_replacedContexts.pop();
 
 //	_self->_log.info("getContextForReplace => %p (%zu)", context, _replacedContexts.size());
@@ -23,9 +23,9 @@
 
 #include <functional>
 #include <mutex>
-#include <ucontext.h>
 #include <stack>
 #include <queue>
+#include "CoroContext.hpp"
 #include "../log/Log.hpp"
 #include "Task.hpp"
 
@@ -46,14 +46,14 @@ private:
 
 public:// TODO временно
 	static thread_local Thread* _self;
-	static thread_local ucontext_t* _currentContext;
+	static thread_local CoroContext* _currentContext;
 	static thread_local size_t _currentContextCount;
-	static thread_local ucontext_t* _obsoletedContext;
-	static thread_local ucontext_t* _replacedContext;
-	static thread_local std::queue<ucontext_t*> _replacedContexts;
+	static thread_local CoroContext* _obsoletedContext;
+	static thread_local CoroContext* _replacedContext;
+	static thread_local std::queue<CoroContext*> _replacedContexts;
 
-	static thread_local ucontext_t* _contextPtrBuffer;
-	static thread_local ucontext_t* _currentTaskContextPtrBuffer;
+	static thread_local CoroContext* _contextPtrBuffer;
+	static thread_local CoroContext* _currentTaskContextPtrBuffer;
 
 	static void run(Thread* thread);
 
@@ -96,15 +96,15 @@ public:
 	}
 
 	// Кладем указатель на контекст в буффер потока
-	static void putContext(ucontext_t* context);
+	static void putContext(CoroContext* context);
 	// Извлекаем указатель на контекст из буффера потока
-	static ucontext_t* getContext();
+	static CoroContext* getContext();
 
-	static void setCurrTaskContext(ucontext_t* context);
-	static ucontext_t* getCurrTaskContext();
+	static void setCurrTaskContext(CoroContext* context);
+	static CoroContext* getCurrTaskContext();
 
-	static void putContextForReplace(ucontext_t* context);
-	static ucontext_t* getContextForReplace();
+	static void putContextForReplace(CoroContext* context);
+	static CoroContext* getContextForReplace();
 	static size_t sizeContextForReplace();
 
 	static size_t getCurrContextCount();
@@ -119,7 +119,7 @@ public:
 
 	void postpone(Task::Duration duration);
 
-	static void coroWrapper(Thread* thread, ucontext_t* context, std::mutex* mutex);
+	static void coroWrapper(Thread* thread, CoroContext* context, std::mutex* mutex);
 
 private:
 	static std::mutex _atCloseMutex;
@@ -19,7 +19,6 @@
 // ThreadPool.cpp
 
 
-#include <ucontext.h>
 #include "ThreadPool.hpp"
 #include "../utils/Time.hpp"
 #include "../utils/Daemon.hpp"
@@ -29,9 +28,28 @@
 ThreadPool::ThreadPool()
 : _log("ThreadPool")
 , _lastWorkerId(0)
+, _sleeping(0)
 {
 }
 
+void ThreadPool::wakeup()
+{
+	auto& pool = getInstance();
+
+	// Задача уже опубликована: поток, заснувший после этой проверки, ее увидит
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (pool._sleeping.load() == 0)
+	{
+		return;
+	}
+
+	// Проходим через мьютекс, чтобы не разбудить раньше, чем ожидающий проверит условие и уснет
+	{
+		std::lock_guard<std::mutex> lockGuard(pool._workerMutex);
+	}
+	pool._workersWakeupCondition.notify_one();
+}
+
 void ThreadPool::hold()
 {
 	auto& pool = getInstance();
@@ -104,7 +122,10 @@ void ThreadPool::createThread()
 				std::unique_lock<std::mutex> lock(_workerMutex);
 
 				// Condition for run thread
-				if (!_workersWakeupCondition.wait_until(lock, waitUntil, continueCondition))
+				++_sleeping;
+				auto ready = _workersWakeupCondition.wait_until(lock, waitUntil, continueCondition);
+				--_sleeping;
+				if (!ready)
 				{
 					continue;
 				}
@@ -209,7 +230,7 @@ bool ThreadPool::empty()
 	return pool._workers.empty();
 }
 
-void ThreadPool::continueContext(ucontext_t* context)
+void ThreadPool::continueContext(CoroContext* context)
 {
 	if (!context)
 	{
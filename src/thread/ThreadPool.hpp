@@ -21,6 +21,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <mutex>
 #include <map>
 #include <deque>
@@ -38,10 +39,8 @@ public:
 
 	static bool empty();
 
-	static void wakeup()
-	{
-		getInstance()._workersWakeupCondition.notify_one();
-	}
+	/// Разбудить простаивающий поток, если такой есть
+	static void wakeup();
 
 private:
 	ThreadPool();
@@ -72,9 +71,9 @@ public:
 
 public:// TODO временно
 	std::mutex _contextsMutex;
-	std::queue<ucontext_t *> _readyForContinueContexts;
+	std::queue<CoroContext *> _readyForContinueContexts;
 public:
-	static void continueContext(ucontext_t* context);
+	static void continueContext(CoroContext* context);
 
 private:
 	Log _log;
@@ -91,5 +90,8 @@ private:
 	std::mutex _workerMutex;
 	std::condition_variable _workersWakeupCondition;
 
+	/// Потоки, ожидающие работы (будить имеет смысл, только если они есть)
+	std::atomic_size_t _sleeping;
+
 	void createThread();
 };
@@ -23,6 +23,10 @@
 #include "http/HttpContext.hpp"
 #include "websocket/WsContext.hpp"
 #include "../compression/CompressorFactory.hpp"
+#include "../net/TcpConnection.hpp"
+
+/// Сколько сообщений копить для приостановленного соединения, прежде чем отбрасывать старые
+static const size_t maxDeferredOutput = 1u << 10;
 
 LpsContext::LpsContext(
 	const std::shared_ptr<ServicePart>& servicePart,
@@ -36,6 +40,7 @@ LpsContext::LpsContext(
 , _compression(compression)
 , _close(false)
 , _closed(false)
+, _backpressureWatched(false)
 {
 	if (dynamic_cast<WsContext*>(_context.get()))
 	{
@@ -177,6 +182,19 @@ void LpsContext::out(SVal value, bool close)
 		_close = true;
 	}
 
+	// Соединение перегружено - откладываем и склеиваем вывод, при переполнении отбрасываем старое
+	if (throttled())
+	{
+		if (_output.size() > maxDeferredOutput)
+		{
+			_output.pop();
+
+			auto service = _service.lock();
+			if (service) service->log().warn("%s: drop outgoing message because connection is overloaded", tag().c_str());
+		}
+		return;
+	}
+
 	if (!_aggregation && std::dynamic_pointer_cast<WsContext>(_context))
 	{
 		try { send(); } catch (...) {}
@@ -206,6 +224,41 @@ void LpsContext::out(SVal value, bool close)
 	}
 }
 
+bool LpsContext::throttled()
+{
+	if (!dynamic_cast<WsContext*>(_context.get()))
+	{
+		return false;
+	}
+
+	auto connection = std::dynamic_pointer_cast<TcpConnection>(_context->connection());
+	if (!connection)
+	{
+		return false;
+	}
+
+	if (!_backpressureWatched)
+	{
+		_backpressureWatched = true;
+
+		// После разгрузки соединения отправляем накопленное
+		connection->addBackpressureHandler(
+			[wp = std::weak_ptr<LpsContext>(std::dynamic_pointer_cast<LpsContext>(ptr()))]
+			(TcpConnection&, bool throttled)
+			{
+				if (throttled)
+				{
+					return;
+				}
+				auto iam = wp.lock();
+				if (iam) try { iam->send(); } catch (...) {}
+			}
+		);
+	}
+
+	return connection->isThrottled();
+}
+
 void LpsContext::send()
 {
 	static Log log_("_lpsContext");
@@ -227,6 +280,12 @@ void LpsContext::send()
 	{
 		context_ = 'W';
 
+		// Отправим одним сообщением, когда соединение разгрузится
+		if (!_close && throttled())
+		{
+			return;
+		}
+
 		_closed = _closed || _close;
 
 		if (_output.size() == 1)
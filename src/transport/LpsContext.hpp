@@ -42,6 +42,12 @@ private:
 	bool _close;
 	bool _closed;
 
+	/// Обработчик противодавления соединения уже установлен
+	bool _backpressureWatched;
+
+	/// Соединение не успевает отправлять: вывод копится и уходит одним сообщением после разгрузки
+	bool throttled();
+
 protected:
 	mutable std::string _tag;
 
@@ -22,12 +22,14 @@
 #include <sstream>
 #include "ServerTransport.hpp"
 #include "../net/ConnectionManager.hpp"
+#include "../net/Acceptor.hpp"
 #include "../thread/ThreadPool.hpp"
 #include "../telemetry/TelemetryManager.hpp"
 
 static uint32_t id4noname = 0;
 
 ServerTransport::ServerTransport(const Setting& setting)
+: _socketOptions(setting)
 {
 	std::string name;
 	if (setting.exists("name"))
@@ -43,33 +45,95 @@ ServerTransport::ServerTransport(const Setting& setting)
 	_name = std::move(name);
 
 	_acceptorCreator = AcceptorFactory::creator(setting);
+	_listenerCount = AcceptorFactory::listeners(setting);
+
+	unsigned int highWatermark = 4u << 20;
+	if (setting.exists("highWatermark"))
+	{
+		setting.lookupValue("highWatermark", highWatermark);
+	}
+	unsigned int lowWatermark = highWatermark / 4;
+	if (setting.exists("lowWatermark"))
+	{
+		setting.lookupValue("lowWatermark", lowWatermark);
+	}
+	if (highWatermark != 0 && lowWatermark >= highWatermark)
+	{
+		throw std::runtime_error("Bad config: lowWatermark must be less than highWatermark");
+	}
+	_highWatermark = highWatermark;
+	_lowWatermark = lowWatermark;
+
+	unsigned int idleTimeout = 30;
+	if (setting.exists("idleTimeout"))
+	{
+		setting.lookupValue("idleTimeout", idleTimeout);
+	}
+	_idleTimeout = std::chrono::seconds(idleTimeout);
+
+	_idleSocketBuffer = 0;
+	if (setting.exists("idleSocketBuffer"))
+	{
+		setting.lookupValue("idleSocketBuffer", _idleSocketBuffer);
+	}
+	if (_idleSocketBuffer < 0)
+	{
+		throw std::runtime_error("Bad config: idleSocketBuffer must be non-negative");
+	}
+
+	_memoryAccount = std::make_shared<MemoryBudget::Account>();
 
 	metricConnectCount = TelemetryManager::metric("transport/" + _name + "/connections", 1);
 	metricRequestCount = TelemetryManager::metric("transport/" + _name + "/requests", 1);
 	metricAvgRequestPerSec = TelemetryManager::metric("transport/" + _name + "/requests_per_second", std::chrono::seconds(15));
 	metricAvgExecutionTime = TelemetryManager::metric("transport/" + _name + "/requests_exec_time", std::chrono::seconds(15));
+	metricSyscallCount = TelemetryManager::metric("transport/" + _name + "/syscalls", 1);
+	metricAvgSyscallPerSec = TelemetryManager::metric("transport/" + _name + "/syscalls_per_second", std::chrono::seconds(15));
+	metricBackpressureOn = TelemetryManager::metric("transport/" + _name + "/backpressure_on", 1);
+	metricBackpressureOff = TelemetryManager::metric("transport/" + _name + "/backpressure_off", 1);
+	metricMemoryUsage = TelemetryManager::metric("transport/" + _name + "/memory", 1);
+	metricShedCount = TelemetryManager::metric("transport/" + _name + "/shed", 1);
 }
 
 bool ServerTransport::enable()
 {
-	if (!_acceptor.expired())
+	if (!_acceptors.empty())
 	{
 		_log.trace("Transport '%s' already enabled", name().c_str());
 		return true;
 	}
 
+	// По одному слушающему сокету на реактор, если количество не задано явно
+	auto listenerCount = _listenerCount ? _listenerCount : ConnectionManager::reactorCount();
+
 	try
 	{
 		auto t = this->ptr();
-		auto acceptor = (*_acceptorCreator)(t);
 
-		_acceptor = acceptor->ptr();
+		std::vector<std::shared_ptr<Connection>> acceptors;
+		for (size_t i = 0; i < listenerCount; ++i)
+		{
+			auto acceptor = (*_acceptorCreator)(t);
+
+			auto listener = std::dynamic_pointer_cast<Acceptor>(acceptor);
+			if (listener)
+			{
+				listener->metricAcceptRate = TelemetryManager::metric("transport/" + _name + "/listener" + std::to_string(i) + "/accepts_per_second", std::chrono::seconds(15));
+			}
+
+			acceptors.emplace_back(std::move(acceptor));
+		}
 
 		ThreadPool::hold();
 
-		ConnectionManager::add(_acceptor.lock());
+		for (auto& acceptor : acceptors)
+		{
+			_acceptors.emplace_back(acceptor);
+
+			ConnectionManager::add(acceptor);
+		}
 
-		_log.debug("Transport '%s' enabled", name().c_str());
+		_log.debug("Transport '%s' enabled (%zu listener(s))", name().c_str(), _acceptors.size());
 
 		return true;
 	}
@@ -83,17 +147,20 @@ bool ServerTransport::enable()
 
 bool ServerTransport::disable()
 {
-	if (_acceptor.expired())
+	if (_acceptors.empty())
 	{
 		_log.debug("Transport '%s' not enable", name().c_str());
 		return true;
 	}
 
-	ConnectionManager::remove(_acceptor.lock());
+	for (auto& acceptor : _acceptors)
+	{
+		ConnectionManager::remove(acceptor.lock());
+	}
 
 	ThreadPool::unhold();
 
-	_acceptor.reset();
+	_acceptors.clear();
 
 	_log.debug("Transport '%s' disabled", name().c_str());
 	return true;
@@ -27,19 +27,40 @@
 
 #include "../log/Log.hpp"
 #include "../net/AcceptorFactory.hpp"
+#include "../net/SocketOptions.hpp"
 #include "../configs/Setting.hpp"
 #include "../serialization/SerializerFactory.hpp"
 #include "../utils/Context.hpp"
+#include "../utils/MemoryBudget.hpp"
 #include "../telemetry/Metric.hpp"
 
 #include <memory>
 #include <functional>
+#include <vector>
 
 class ServerTransport : public Shareable<ServerTransport>, public Transport
 {
 private:
 	std::shared_ptr<AcceptorFactory::Creator> _acceptorCreator;
-	std::weak_ptr<Connection> _acceptor;
+	size_t _listenerCount;
+	std::vector<std::weak_ptr<Connection>> _acceptors;
+
+	/// Пороги исходящего буфера соединения: выше верхнего чтение приостанавливается,
+	/// ниже нижнего - возобновляется (0 - без ограничения)
+	size_t _highWatermark;
+	size_t _lowWatermark;
+
+	/// Простой соединения, после которого его память возвращается (0 - не возвращать)
+	std::chrono::milliseconds _idleTimeout;
+
+	/// Размер приемного буфера сокета простаивающего соединения (0 - не уменьшать)
+	int _idleSocketBuffer;
+
+	/// Параметры сокетов подключений
+	SocketOptions _socketOptions;
+
+	/// Учет памяти буферов соединений и запросов транспорта
+	std::shared_ptr<MemoryBudget::Account> _memoryAccount;
 
 public:
 	ServerTransport() = delete;
@@ -55,6 +76,40 @@ public:
 	std::shared_ptr<Metric> metricRequestCount;
 	std::shared_ptr<Metric> metricAvgRequestPerSec;
 	std::shared_ptr<Metric> metricAvgExecutionTime;
+	std::shared_ptr<Metric> metricSyscallCount;
+	std::shared_ptr<Metric> metricAvgSyscallPerSec;
+	std::shared_ptr<Metric> metricBackpressureOn;
+	std::shared_ptr<Metric> metricBackpressureOff;
+	std::shared_ptr<Metric> metricMemoryUsage;
+	std::shared_ptr<Metric> metricShedCount;
+
+	size_t highWatermark() const
+	{
+		return _highWatermark;
+	}
+	size_t lowWatermark() const
+	{
+		return _lowWatermark;
+	}
+
+	std::chrono::milliseconds idleTimeout() const
+	{
+		return _idleTimeout;
+	}
+	int idleSocketBuffer() const
+	{
+		return _idleSocketBuffer;
+	}
+
+	const SocketOptions& socketOptions() const
+	{
+		return _socketOptions;
+	}
+
+	const std::shared_ptr<MemoryBudget::Account>& memoryAccount() const
+	{
+		return _memoryAccount;
+	}
 
 	virtual bool enable() final;
 	virtual bool disable() final;
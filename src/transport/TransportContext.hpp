@@ -38,6 +38,11 @@ public:
 	{};
 	virtual ~TransportContext()	= default;
 
+	std::shared_ptr<Connection> connection() const
+	{
+		return _connection.lock();
+	}
+
 	void setTransmitter(const std::shared_ptr<Transport::Transmitter>& transmitter)
 	{
 		_transmitter = transmitter;
@@ -0,0 +1,206 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// HttpClientPool.cpp
+
+
+#include "HttpClientPool.hpp"
+
+#include <sys/socket.h>
+#include "HttpClient.hpp"
+#include "HttpUri.hpp"
+#include "../../net/TcpConnection.hpp"
+#include "../../telemetry/TelemetryManager.hpp"
+
+HttpClientPool::HttpClientPool()
+: _idleCount(0)
+, _maxIdle(256)
+, _maxIdlePerHost(16)
+, _idleTimeout(std::chrono::seconds(60))
+, _transport(std::make_shared<HttpClient>())
+{
+	_metricConnectCount = TelemetryManager::metric("http_client/connects", 1);
+	_metricReuseCount = TelemetryManager::metric("http_client/reuses", 1);
+	_metricReuseRatio = TelemetryManager::metric("http_client/reuse_ratio", std::chrono::seconds(60));
+}
+
+void HttpClientPool::setLimits(size_t maxIdle, size_t maxIdlePerHost, std::chrono::seconds idleTimeout)
+{
+	auto& instance = getInstance();
+
+	std::lock_guard<std::mutex> lockGuard(instance._mutex);
+
+	instance._maxIdle = maxIdle;
+	instance._maxIdlePerHost = maxIdlePerHost;
+	instance._idleTimeout = idleTimeout;
+}
+
+std::shared_ptr<HttpClient> HttpClientPool::transport()
+{
+	return getInstance()._transport;
+}
+
+bool HttpClientPool::healthy(const std::shared_ptr<TcpConnection>& connection)
+{
+	if (connection->isClosed() || connection->noRead() || connection->dataLen() > 0)
+	{
+		return false;
+	}
+
+	// Без ожидания заглядываем в сокет: закрытие узлом (0) или непрошенные данные (>0)
+	// делают соединение непригодным, пустой сокет (EAGAIN) - нормальное состояние
+	char byte;
+	auto n = ::recv(connection->fd(), &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+	return n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK);
+}
+
+std::string HttpClientPool::peer(const HttpUri& uri)
+{
+	return (uri.scheme() == HttpUri::Scheme::HTTPS ? "https://" : "http://") + uri.host() + ":" + std::to_string(uri.port());
+}
+
+void HttpClientPool::setUpstream(const std::string& peer, const std::shared_ptr<ConnectorFactory::Creator>& creator)
+{
+	auto& instance = getInstance();
+
+	std::lock_guard<std::mutex> lockGuard(instance._mutex);
+
+	instance._upstreams[peer] = creator;
+}
+
+std::shared_ptr<ConnectorFactory::Creator> HttpClientPool::upstream(const std::string& peer)
+{
+	auto& instance = getInstance();
+
+	std::lock_guard<std::mutex> lockGuard(instance._mutex);
+
+	auto i = instance._upstreams.find(peer);
+	return i != instance._upstreams.end() ? i->second : nullptr;
+}
+
+std::shared_ptr<TcpConnection> HttpClientPool::acquire(const std::string& peer)
+{
+	auto& instance = getInstance();
+
+	for (;;)
+	{
+		std::shared_ptr<TcpConnection> connection;
+		bool expired = false;
+		{
+			std::lock_guard<std::mutex> lockGuard(instance._mutex);
+
+			auto i = instance._idle.find(peer);
+			if (i == instance._idle.end())
+			{
+				break;
+			}
+
+			// Берем самое свежее: у него меньше шансов быть закрытым узлом
+			auto idle = std::move(i->second.back());
+			i->second.pop_back();
+			--instance._idleCount;
+			if (i->second.empty())
+			{
+				instance._idle.erase(i);
+			}
+
+			connection = idle.connection.lock();
+			expired = std::chrono::steady_clock::now() - idle.since > instance._idleTimeout;
+		}
+
+		if (!connection)
+		{
+			continue;
+		}
+
+		if (expired || !healthy(connection))
+		{
+			connection->setTtl(std::chrono::milliseconds(50));
+			continue;
+		}
+
+		instance._metricReuseCount->addValue();
+		instance._metricReuseRatio->addValue(1);
+
+		return connection;
+	}
+
+	return nullptr;
+}
+
+void HttpClientPool::connected()
+{
+	auto& instance = getInstance();
+
+	instance._metricConnectCount->addValue();
+	instance._metricReuseRatio->addValue(0);
+}
+
+bool HttpClientPool::release(const std::string& peer, const std::shared_ptr<TcpConnection>& connection)
+{
+	auto& instance = getInstance();
+
+	std::chrono::seconds idleTimeout;
+	std::shared_ptr<TcpConnection> evicted;
+	{
+		std::lock_guard<std::mutex> lockGuard(instance._mutex);
+
+		if (instance._maxIdle == 0 || instance._idleTimeout.count() == 0)
+		{
+			return false;
+		}
+
+		auto& idle = instance._idle[peer];
+
+		// Узел уже держит предельное число соединений - вытесняем самое старое
+		if (idle.size() >= instance._maxIdlePerHost)
+		{
+			if (instance._maxIdlePerHost == 0)
+			{
+				instance._idle.erase(peer);
+				return false;
+			}
+			evicted = idle.front().connection.lock();
+			idle.pop_front();
+			--instance._idleCount;
+		}
+		else if (instance._idleCount >= instance._maxIdle)
+		{
+			if (idle.empty())
+			{
+				instance._idle.erase(peer);
+			}
+			return false;
+		}
+
+		idle.push_back({connection, std::chrono::steady_clock::now()});
+		++instance._idleCount;
+
+		idleTimeout = instance._idleTimeout;
+	}
+
+	if (evicted)
+	{
+		evicted->setTtl(std::chrono::milliseconds(50));
+	}
+
+	// Невостребованное соединение закроется само по истечении простоя
+	connection->setTtl(idleTimeout);
+
+	return true;
+}
@@ -0,0 +1,110 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// HttpClientPool.hpp
+
+
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "../../net/ConnectorFactory.hpp"
+#include "../../telemetry/Metric.hpp"
+
+class HttpClient;
+class HttpUri;
+class TcpConnection;
+
+/// Пул простаивающих исходящих HTTP-соединений (keep-alive), разложенных по узлам.
+/// Соединение, ответ по которому прочитан целиком, возвращается сюда и отдается
+/// следующему запросу к тому же узлу, избавляя его от подключения и TLS-рукопожатия
+class HttpClientPool final
+{
+public:
+	HttpClientPool(HttpClientPool const&) = delete;
+	void operator= (HttpClientPool const&) = delete;
+	HttpClientPool(HttpClientPool&&) noexcept = delete;
+	HttpClientPool& operator=(HttpClientPool&&) noexcept = delete;
+
+private:
+	HttpClientPool();
+	~HttpClientPool() = default;
+
+	static HttpClientPool &getInstance()
+	{
+		static HttpClientPool instance;
+		return instance;
+	}
+
+	struct Idle final
+	{
+		std::weak_ptr<TcpConnection> connection;
+		std::chrono::steady_clock::time_point since;
+	};
+
+	std::mutex _mutex;
+	std::map<std::string, std::deque<Idle>> _idle;
+	size_t _idleCount;
+
+	/// Пределы простаивающих соединений: всего и на один узел
+	size_t _maxIdle;
+	size_t _maxIdlePerHost;
+
+	/// Простой, после которого соединение закрывается
+	std::chrono::seconds _idleTimeout;
+
+	/// Общий транспорт исходящих соединений (соединения в пуле переживают свой запрос)
+	std::shared_ptr<HttpClient> _transport;
+
+	/// Узлы, к которым подключаемся не по адресу из URI (например, через UNIX-сокет)
+	std::map<std::string, std::shared_ptr<ConnectorFactory::Creator>> _upstreams;
+
+	std::shared_ptr<Metric> _metricConnectCount;
+	std::shared_ptr<Metric> _metricReuseCount;
+	std::shared_ptr<Metric> _metricReuseRatio;
+
+	/// Соединение пригодно для нового запроса: не закрыто узлом и не содержит непрошенных данных
+	static bool healthy(const std::shared_ptr<TcpConnection>& connection);
+
+public:
+	static void setLimits(size_t maxIdle, size_t maxIdlePerHost, std::chrono::seconds idleTimeout);
+
+	static std::shared_ptr<HttpClient> transport();
+
+	/// Адрес узла по URI запроса (ключ пула и маршрутов)
+	static std::string peer(const HttpUri& uri);
+
+	/// Подключаться к узлу создателем из конфига (setting - как для ConnectorFactory)
+	static void setUpstream(const std::string& peer, const std::shared_ptr<ConnectorFactory::Creator>& creator);
+
+	/// Создатель подключений к узлу (nullptr - подключаться по адресу из URI)
+	static std::shared_ptr<ConnectorFactory::Creator> upstream(const std::string& peer);
+
+	/// Взять простаивающее соединение с узлом (nullptr, если подходящего нет)
+	static std::shared_ptr<TcpConnection> acquire(const std::string& peer);
+
+	/// Учесть новое подключение (для доли повторного использования)
+	static void connected();
+
+	/// Вернуть соединение в пул. Возвращает false, если пул полон и соединение надо закрыть
+	static bool release(const std::string& peer, const std::shared_ptr<TcpConnection>& connection);
+};
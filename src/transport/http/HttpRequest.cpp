@@ -125,6 +125,11 @@ const char* HttpRequest::parseMethod(const char* s)
 		_method = Method::POST;
 		s += 4;
 	}
+	else if (strncasecmp(s, "HEAD ", 4) == 0)
+	{
+		_method = Method::HEAD;
+		s += 4;
+	}
 	else
 	{
 		throw std::runtime_error("Unknown method");
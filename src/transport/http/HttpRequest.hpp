@@ -25,6 +25,7 @@
 #include <memory>
 #include "../../log/Log.hpp"
 #include "../../utils/Buffer.hpp"
+#include "../../utils/ObjectPool.hpp"
 #include "HttpUri.hpp"
 
 class HttpRequest final : public Buffer
@@ -34,6 +35,7 @@ public:
 		UNKNOWN,
 		GET,
 		POST,
+		HEAD,
 	};
 	enum class TransferEncoding {
 		NONE,
@@ -46,7 +48,11 @@ private:
 	HttpUri _uri;
 	uint8_t _protocolVersion;
 
-	std::multimap<std::string, std::string> _headers;
+	/// Узлы заголовков - из пула, без обращения к аллокатору общего назначения
+	std::multimap<
+		std::string, std::string, std::less<std::string>,
+		PoolAllocator<std::pair<const std::string, std::string>>
+	> _headers;
 
 	bool _hasContentLength;
 	size_t _contentLength;
@@ -88,6 +94,7 @@ public:
 		return
 			_method == Method::GET ? "GET" :
 			_method == Method::POST ? "POST" :
+			_method == Method::HEAD ? "HEAD" :
 			"*method*";
 	}
 
@@ -24,6 +24,7 @@
 #include "../../net/SslConnector.hpp"
 #include "../../net/ConnectionManager.hpp"
 #include "HttpContext.hpp"
+#include "HttpClientPool.hpp"
 #include "../../thread/RollbackStackAndRestoreContext.hpp"
 
 HttpRequestExecutor::HttpRequestExecutor(
@@ -35,13 +36,14 @@ HttpRequestExecutor::HttpRequestExecutor(
 )
 : _savedCtx(nullptr)
 , _log("HttpRequestExecutor")
-, _clientTransport(new HttpClient())
+, _clientTransport(HttpClientPool::transport())
 , _method(method)
 , _uri(uri)
 , _body(body)
 , _contentType(contentType)
 , _timeout(timeout)
 , _error("No run")
+, _reused(false)
 , _state(State::INIT)
 {
 //	_log.setDetail(Log::Detail::TRACE);
@@ -74,15 +76,65 @@ void HttpRequestExecutor::operator()()
 	_savedCtx = Thread::getCurrTaskContext();
 	Thread::setCurrTaskContext(nullptr);
 
+	start();
+}
+
+void HttpRequestExecutor::operator()(std::function<void(HttpRequestExecutor&)>&& handler)
+{
+	std::lock_guard<std::recursive_mutex> lockGuard(_mutex);
+	if (_state != State::INIT)
+	{
+		throw std::runtime_error("Request already executed (step " + std::to_string(static_cast<int>(_state)) + ")");
+	}
+
+	_doneHandler = std::move(handler);
+
+	start();
+}
+
+void HttpRequestExecutor::start()
+{
 	_error.clear();
 	_log.trace("--------------------------------------------------------------------------------------------------------");
+
+	_peer = HttpClientPool::peer(_uri);
+
+	connect(true);
+}
+
+void HttpRequestExecutor::connect(bool fromPool)
+{
+	std::lock_guard<std::recursive_mutex> lockGuard(_mutex);
+
 	_log.trace("Connect...");
 
+	_state = State::CONNECT;
+
+	if (fromPool)
+	{
+		_connection = HttpClientPool::acquire(_peer);
+		if (_connection)
+		{
+			_log.trace("Reuse pooled connection");
+
+			_reused = true;
+			onConnected();
+			return;
+		}
+	}
+
+	_reused = false;
+
 	try
 	{
-		_state = State::CONNECT;
+		HttpClientPool::connected();
 
-		if (_uri.scheme() == HttpUri::Scheme::HTTPS)
+		auto upstream = HttpClientPool::upstream(_peer);
+		if (upstream)
+		{
+			_connector = (*upstream)(_clientTransport);
+		}
+		else if (_uri.scheme() == HttpUri::Scheme::HTTPS)
 		{
 			auto context = SslHelper::getClientContext();
 			_connector = std::make_shared<SslConnector>(_clientTransport, _uri.host(), _uri.port(), context);
@@ -186,6 +238,12 @@ void HttpRequestExecutor::onConnected()
 
 	_state = State::CONNECTED;
 
+	// У соединения из пула может остаться контекст прошлого ответа
+	if (_reused)
+	{
+		_connection->resetContext();
+	}
+
 	if (!_connection->getContext())
 	{
 		_connection->setContext(std::make_shared<HttpContext>(_connection));
@@ -196,12 +254,13 @@ void HttpRequestExecutor::onConnected()
 		throw std::runtime_error("Bad context");
 	}
 
+	// События соединения, уже возвращенного в пул или брошенного ради повтора, не наши
 	_connection->addCompleteHandler(
 		[wp = std::weak_ptr<HttpRequestExecutor>(ptr())]
-		(TcpConnection&, const std::shared_ptr<Context>&)
+		(TcpConnection& connection, const std::shared_ptr<Context>&)
 		{
 			auto iam = wp.lock();
-			if (iam)
+			if (iam && iam->_connection.get() == &connection)
 			{
 				iam->onComplete();
 			}
@@ -210,10 +269,10 @@ void HttpRequestExecutor::onConnected()
 
 	_connection->addErrorHandler(
 		[wp = std::weak_ptr<HttpRequestExecutor>(ptr())]
-		(TcpConnection&)
+		(TcpConnection& connection)
 		{
 			auto iam = wp.lock();
-			if (iam)
+			if (iam && iam->_connection.get() == &connection)
 			{
 				iam->failProcessing();
 			}
@@ -248,7 +307,7 @@ void HttpRequestExecutor::submit()
 			  : "UNKNOWN "
 		) << _uri.path() << (_uri.hasQuery() ? "?" : "") << (_uri.hasQuery() ? _uri.query() : "") << " HTTP/1.1\r\n"
 			<< "Host: " << _uri.host() << ':' << _uri.port() << "\r\n"
-			<< "Connection: Close\r\n";
+			<< "Connection: Keep-Alive\r\n";
 		if (_method == HttpRequest::Method::POST)
 		{
 			oss << "Content-Length: " << _body.length() << "\r\n";
@@ -324,6 +383,23 @@ void HttpRequestExecutor::failProcessing()
 		return;
 	}
 
+	// Соединение из пула могло быть закрыто узлом, пока запрос уходил: повторяем по новому.
+	// Только для GET - прочие запросы узел мог успеть выполнить
+	if (_reused && _state == State::SUBMITED && _method == HttpRequest::Method::GET)
+	{
+		auto context = std::dynamic_pointer_cast<HttpContext>(_connection->getContext());
+		if (!context || !context->getResponse())
+		{
+			_log.trace("Pooled connection lost, retry with new one");
+
+			_connection->setTtl(std::chrono::milliseconds(50));
+			_connection.reset();
+
+			connect(false);
+			return;
+		}
+	}
+
 	_log.trace("Error after connected");
 
 	_state = State::ERROR;
@@ -364,6 +440,9 @@ void HttpRequestExecutor::onComplete()
 
 	_answer = std::string(context->getResponse()->dataPtr(), context->getResponse()->dataLen());
 
+	// Ответ прочитан целиком - соединение можно отдать следующему запросу
+	recycle();
+
 	if (context->getResponse()->statusCode() != 200)
 	{
 		_error = "No OK response: " + std::to_string(context->getResponse()->statusCode()) + " " + context->getResponse()->statusMessage();
@@ -376,11 +455,40 @@ void HttpRequestExecutor::onComplete()
 	_log.trace("Completed");
 	_state = State::COMPLETE;
 
-	_connection->setTtl(std::chrono::milliseconds(50));
+	if (_connection)
+	{
+		_connection->setTtl(std::chrono::milliseconds(50));
+	}
 
 	done();
 }
 
+void HttpRequestExecutor::recycle()
+{
+	auto context = std::dynamic_pointer_cast<HttpContext>(_connection->getContext());
+	auto response = context ? context->getResponse() : nullptr;
+	if (!response || response->mustClose())
+	{
+		return;
+	}
+
+	// Граница ответа известна только по длине или по чанкам; лишние данные означают рассинхронизацию
+	if (!response->hasContentLength() && !response->ifTransferEncoding(HttpResponse::TransferEncoding::CHUNKED))
+	{
+		return;
+	}
+	if (_connection->noRead() || _connection->dataLen() > 0)
+	{
+		return;
+	}
+
+	if (HttpClientPool::release(_peer, _connection))
+	{
+		_log.trace("Connection returned into pool");
+		_connection.reset();
+	}
+}
+
 void HttpRequestExecutor::onError()
 {
 	std::lock_guard<std::recursive_mutex> lockGuard(_mutex);
@@ -405,7 +513,10 @@ void HttpRequestExecutor::onError()
 		_error = "Error at processing";
 	}
 
-	_connection->setTtl(std::chrono::milliseconds(50));
+	if (_connection)
+	{
+		_connection->setTtl(std::chrono::milliseconds(50));
+	}
 
 	done();
 }
@@ -432,7 +543,8 @@ void HttpRequestExecutor::badStep(const std::string& msg)
 
 void HttpRequestExecutor::done()
 {
-	ucontext_t* ctx = nullptr;
+	CoroContext* ctx = nullptr;
+	std::function<void(HttpRequestExecutor&)> handler;
 
 	{
 		std::lock_guard<std::recursive_mutex> lockGuard(_mutex);
@@ -445,8 +557,18 @@ void HttpRequestExecutor::done()
 		ctx = _savedCtx;
 		_savedCtx = nullptr;
 
+		handler = std::move(_doneHandler);
+		_doneHandler = nullptr;
+
 		_log.trace("Done");
 	}
 
+	// Запрос выполнялся без сопрограммы ucontext - возвращаться некуда
+	if (handler)
+	{
+		handler(*this);
+		return;
+	}
+
 	throw RollbackStackAndRestoreContext(ctx);
 }
@@ -21,7 +21,7 @@
 
 #pragma once
 
-#include <sys/ucontext.h>
+#include "../../thread/CoroContext.hpp"
 #include "../../utils/Shareable.hpp"
 #include "../../log/Log.hpp"
 #include "HttpClient.hpp"
@@ -31,7 +31,10 @@
 class HttpRequestExecutor final: public Shareable<HttpRequestExecutor>
 {
 private:
-	ucontext_t* _savedCtx;
+	CoroContext* _savedCtx;
+
+	/// Обработчик завершения (вместо возврата в сохраненный контекст)
+	std::function<void(HttpRequestExecutor&)> _doneHandler;
 	Log _log;
 	std::shared_ptr<HttpClient> _clientTransport;
 	HttpRequest::Method _method;
@@ -45,6 +48,12 @@ private:
 	std::shared_ptr<TcpConnector> _connector;
 	std::shared_ptr<TcpConnection> _connection;
 
+	/// Адрес узла (ключ пула соединений)
+	std::string _peer;
+
+	/// Соединение взято из пула (запрос можно повторить по новому, если узел его уже закрыл)
+	bool _reused;
+
 	enum class State
 	{
 		INIT 		= 0,
@@ -56,6 +65,9 @@ private:
 		ERROR		= 255
 	} _state;
 
+	void start();
+
+	void connect(bool fromPool);
 	void onConnected();
 	void failConnect();
 	void exceptionAtConnect();
@@ -64,6 +76,7 @@ private:
 	void exceptionAtSubmit();
 
 	void onComplete();
+	void recycle();
 	void failProcessing();
 	void onError();
 
@@ -82,6 +95,10 @@ public:
 
 	void operator()();
 
+	/// Выполнить запрос без сопрограммы ucontext: handler будет вызван по завершении
+	/// (успешном или нет) из потока, завершившего запрос
+	void operator()(std::function<void(HttpRequestExecutor&)>&& handler);
+
 	const std::string& uri() const
 	{
 		return _uri.str();
@@ -21,8 +21,10 @@
 
 #include <sstream>
 #include "HttpResponse.hpp"
+#include "HttpContext.hpp"
 #include "../../server/Server.hpp"
 #include "../../utils/Time.hpp"
+#include "../../utils/ObjectPool.hpp"
 #include "HttpHelper.hpp"
 
 HttpResponse::HttpResponse(int status, const std::string& message, uint8_t protocolVersion)
@@ -225,7 +227,15 @@ const char* HttpResponse::parseProtocol(const char* s)
 	}
 	s += 5;
 
-	if (strncasecmp(s, "1.1", 3) != 0 && strncasecmp(s, "1.0", 3) != 0)
+	if (strncasecmp(s, "1.1", 3) == 0)
+	{
+		_protocolVersion = 101;
+	}
+	else if (strncasecmp(s, "1.0", 3) == 0)
+	{
+		_protocolVersion = 100;
+	}
+	else
 	{
 		throw std::runtime_error("Wrong version");
 	}
@@ -239,6 +249,7 @@ const char* HttpResponse::parseHeaders(const char *begin, const char *end)
 {
 	auto s = begin;
 	std::string *prevHeaderValue = nullptr;
+	bool keepAlive = false;
 
 	try
 	{
@@ -252,6 +263,11 @@ const char* HttpResponse::parseHeaders(const char *begin, const char *end)
 			// Пустой заголовок - заголовки закончились
 			if (endHeader == s)
 			{
+				// HTTP/1.0 держит соединение, только если об этом сказано явно
+				if (_protocolVersion < 101 && !keepAlive)
+				{
+					_close = true;
+				}
 				s += 2;
 				return s;
 			}
@@ -316,6 +332,17 @@ const char* HttpResponse::parseHeaders(const char *begin, const char *end)
 				_hasContentLength = true;
 				_contentLength = static_cast<size_t>(atoll(value.c_str()));
 			}
+			else if (strcasecmp(name.c_str(), "Connection") == 0)
+			{
+				if (strcasestr(value.c_str(), "close") != nullptr)
+				{
+					_close = true;
+				}
+				else if (strcasestr(value.c_str(), "keep-alive") != nullptr)
+				{
+					keepAlive = true;
+				}
+			}
 		}
 	}
 	catch (std::exception &exception)
@@ -360,8 +387,9 @@ void HttpResponse::operator>>(TcpConnection& connection)
 
 	if (_statusCode == 100)
 	{
-		connection.write(oss.str().data(), oss.str().size());
-		connection.write("\r\n", 2);
+		oss << "\r\n";
+		auto head = oss.str();
+		connection.write(head.data(), head.size());
 		if (_close)
 		{
 			connection.close();
@@ -369,27 +397,34 @@ void HttpResponse::operator>>(TcpConnection& connection)
 		return;
 	}
 
+	// Тело отдаем соединению как отдельный фрагмент - без склейки с заголовками
+	std::shared_ptr<const std::string> body = makePooled<std::string>(_body.str());
+
 	oss << "Server: " << Server::httpName() << "\r\n"
 		<< "Date: " << Time::httpDate() << "\r\n";
 
-	if (_body.str().size())
+	if (!body->empty())
 	{
-		oss << "Content-Length: " << _body.str().size() << "\r\n";
+		oss << "Content-Length: " << body->size() << "\r\n";
 	}
 
-	connection.write(oss.str().data(), oss.str().size());
-
 	for (const auto& i : _headers)
 	{
-		connection.write(i.first.data(), i.first.size());
-		connection.write(": ", 2);
-		connection.write(i.second.data(), i.second.size());
-		connection.write("\r\n", 2);
+		oss << i.first << ": " << i.second << "\r\n";
 	}
 
-	connection.write("\r\n", 2);
+	oss << "\r\n";
+
+	connection.writeShared(makePooled<std::string>(oss.str()));
 
-	connection.write(_body.str().data(), _body.str().size());
+	// Ответ на HEAD - те же заголовки (включая Content-Length), но без тела:
+	// иначе клиент примет тело за начало следующего ответа
+	auto context = std::dynamic_pointer_cast<HttpContext>(connection.getContext());
+	auto request = context ? context->getRequest() : nullptr;
+	if (!request || request->method() != HttpRequest::Method::HEAD)
+	{
+		connection.writeShared(body);
+	}
 
 	if (_close)
 	{
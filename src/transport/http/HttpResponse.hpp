@@ -116,5 +116,11 @@ public:
 		return _contentLength;
 	}
 
+	/// Соединение закрывается после этого ответа
+	bool mustClose() const
+	{
+		return _close;
+	}
+
 	bool ifTransferEncoding(TransferEncoding transferEncoding);
 };
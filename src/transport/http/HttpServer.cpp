@@ -25,6 +25,7 @@
 #include "../../net/ConnectionManager.hpp"
 #include "../../net/TcpConnection.hpp"
 #include "../../server/Server.hpp"
+#include "../../utils/ObjectPool.hpp"
 #include "HttpContext.hpp"
 #include "HttpServer.hpp"
 
@@ -45,7 +46,7 @@ bool HttpServer::processing(const std::shared_ptr<Connection>& connection_)
 	{
 		if (!connection->getContext())
 		{
-			connection->setContext(std::make_shared<HttpContext>(connection));
+			connection->setContext(makePooled<HttpContext>(connection));
 		}
 		auto context = std::dynamic_pointer_cast<HttpContext>(connection->getContext());
 		if (!context)
@@ -60,7 +61,8 @@ bool HttpServer::processing(const std::shared_ptr<Connection>& connection_)
 			{
 				if (
 					strncasecmp(connection->dataPtr(), "GET", 3) &&
-					strncasecmp(connection->dataPtr(), "POST", 4)
+					strncasecmp(connection->dataPtr(), "POST", 4) &&
+					strncasecmp(connection->dataPtr(), "HEAD", 4)
 				)
 				{
 					_log.debug("Bad request");
@@ -115,7 +117,7 @@ bool HttpServer::processing(const std::shared_ptr<Connection>& connection_)
 			try
 			{
 				// Читаем запрос
-				auto request = std::make_shared<HttpRequest>(connection->dataPtr(), connection->dataPtr() + headersSize);
+				auto request = makePooled<HttpRequest>(connection->dataPtr(), connection->dataPtr() + headersSize);
 
 				if (!context->isHttp100ContinueSent())
 				{
@@ -131,6 +133,8 @@ bool HttpServer::processing(const std::shared_ptr<Connection>& connection_)
 					}
 				}
 
+				request->setAccount(memoryAccount());
+
 				context->setRequest(request);
 			}
 			catch (std::exception& exception)
@@ -153,6 +157,25 @@ bool HttpServer::processing(const std::shared_ptr<Connection>& connection_)
 			connection->setTtl(std::chrono::seconds(5));
 		}
 
+		// Заявленное тело не поместится в бюджет памяти - отказываем, не читая его
+		if (
+			context->getRequest()->hasContentLength() &&
+			!MemoryBudget::affordable(context->getRequest()->contentLength() - context->getRequest()->dataLen())
+		)
+		{
+			HttpResponse(503, "", context->getRequest()->protocol())
+				<< HttpHeader("Connection", "Close")
+				<< HttpHeader("Retry-After", "1")
+				<< "Request body too large for now" << "\r\n"
+				>> *connection;
+
+			if (metricShedCount) metricShedCount->addValue();
+
+			_log.info("HTTP Rejected request with body of %zu bytes (memory budget exceeded)", context->getRequest()->contentLength());
+			connection->setTtl(std::chrono::milliseconds(50));
+			return true;
+		}
+
 		// Читаем тело запроса
 		if (context->getRequest()->method() == HttpRequest::Method::POST)
 		{
@@ -221,6 +244,22 @@ bool HttpServer::processing(const std::shared_ptr<Connection>& connection_)
 						return true;
 					}
 
+					// Чанк не поместится в бюджет памяти
+					if (!MemoryBudget::affordable(size))
+					{
+						HttpResponse(503)
+							<< HttpHeader("Connection", "Close")
+							<< HttpHeader("Retry-After", "1")
+							<< "Request body too large for now" << "\r\n"
+							>> *connection;
+
+						if (metricShedCount) metricShedCount->addValue();
+
+						_log.info("HTTP Rejected chunk of %zu bytes (memory budget exceeded)", size);
+						connection->setTtl(std::chrono::milliseconds(50));
+						return true;
+					}
+
 					// Недостаточно данных для получения чанка целиком
 					if (connection->dataLen() < (endHeader - connection->dataPtr()) + 2 + size + 2)
 					{
@@ -310,7 +349,7 @@ bool HttpServer::processing(const std::shared_ptr<Connection>& connection_)
 			context->setHandler(std::move(handler));
 
 			context->setTransmitter(
-				std::make_shared<Transport::Transmitter>(
+				makePooled<Transport::Transmitter>(
 					[this,connection]
 					(const char*data, size_t size, const std::string& contentType, bool close)
 					{
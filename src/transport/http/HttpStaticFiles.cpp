@@ -0,0 +1,498 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// HttpStaticFiles.cpp
+
+
+#include "HttpStaticFiles.hpp"
+#include "HttpContext.hpp"
+#include "../../utils/encoding/PercentEncoding.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sstream>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/// События, после которых закешированный дескриптор или stat устаревают
+static const uint32_t watchMask =
+	IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE |
+	IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+
+/// Дата в формате HTTP (всегда GMT)
+static std::string gmtDate(std::time_t ts)
+{
+	std::tm tm{};
+	::gmtime_r(&ts, &tm);
+
+	char buff[40];
+	std::strftime(buff, sizeof(buff), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+
+	return buff;
+}
+
+static bool parseGmtDate(const std::string& string, std::time_t& ts)
+{
+	std::tm tm{};
+	if (::strptime(string.c_str(), "%a, %d %b %Y %H:%M:%S", &tm) == nullptr)
+	{
+		return false;
+	}
+	ts = ::timegm(&tm);
+	return true;
+}
+
+HttpStaticFiles::File::~File()
+{
+	if (fd >= 0)
+	{
+		::close(fd);
+	}
+}
+
+HttpStaticFiles::HttpStaticFiles(const std::string& root, const std::string& prefix, size_t maxFiles)
+: _log("HttpStaticFiles")
+, _root(root.size() > 1 && root.back() == '/' ? root.substr(0, root.size() - 1) : root)
+, _prefix(prefix)
+, _maxFiles(maxFiles)
+{
+	_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (_inotify == -1)
+	{
+		_log.warn("Can't init inotify for '%s' (%s): files will not be cached", _root.c_str(), strerror(errno));
+	}
+}
+
+HttpStaticFiles::~HttpStaticFiles()
+{
+	if (_inotify != -1)
+	{
+		::close(_inotify);
+	}
+}
+
+std::shared_ptr<ServerTransport::Handler> HttpStaticFiles::handler(const std::string& root, const std::string& prefix, size_t maxFiles)
+{
+	return std::make_shared<ServerTransport::Handler>(
+		[files = std::make_shared<HttpStaticFiles>(root, prefix, maxFiles)]
+		(const std::shared_ptr<Context>& context)
+		{
+			files->handle(context);
+		}
+	);
+}
+
+const std::string& HttpStaticFiles::contentType(const std::string& path)
+{
+	static const std::unordered_map<std::string, std::string> types = {
+		{"html",  "text/html;charset=utf-8"},
+		{"htm",   "text/html;charset=utf-8"},
+		{"css",   "text/css;charset=utf-8"},
+		{"js",    "application/javascript;charset=utf-8"},
+		{"mjs",   "application/javascript;charset=utf-8"},
+		{"json",  "application/json;charset=utf-8"},
+		{"map",   "application/json;charset=utf-8"},
+		{"txt",   "text/plain;charset=utf-8"},
+		{"xml",   "application/xml"},
+		{"svg",   "image/svg+xml"},
+		{"png",   "image/png"},
+		{"jpg",   "image/jpeg"},
+		{"jpeg",  "image/jpeg"},
+		{"gif",   "image/gif"},
+		{"webp",  "image/webp"},
+		{"ico",   "image/x-icon"},
+		{"woff",  "font/woff"},
+		{"woff2", "font/woff2"},
+		{"ttf",   "font/ttf"},
+		{"otf",   "font/otf"},
+		{"wasm",  "application/wasm"},
+		{"mp3",   "audio/mpeg"},
+		{"mp4",   "video/mp4"},
+		{"webm",  "video/webm"},
+		{"pdf",   "application/pdf"},
+		{"zip",   "application/zip"},
+	};
+	static const std::string unknown("application/octet-stream");
+
+	auto dot = path.rfind('.');
+	auto slash = path.rfind('/');
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+	{
+		return unknown;
+	}
+
+	std::string ext = path.substr(dot + 1);
+	std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+	auto i = types.find(ext);
+	return i != types.end() ? i->second : unknown;
+}
+
+std::string HttpStaticFiles::resolve(const std::string& uriPath) const
+{
+	if (uriPath.compare(0, _prefix.size(), _prefix) != 0)
+	{
+		return std::string();
+	}
+
+	auto path = PercentEncoding::decode(uriPath.substr(_prefix.size()));
+
+	if (path.find('\0') != std::string::npos)
+	{
+		return std::string();
+	}
+
+	// Не выпускаем за пределы корня
+	std::istringstream iss(path);
+	std::string segment;
+	while (std::getline(iss, segment, '/'))
+	{
+		if (segment == "..")
+		{
+			return std::string();
+		}
+	}
+
+	if (path.empty() || path.back() == '/')
+	{
+		path += "index.html";
+	}
+	if (path.front() != '/')
+	{
+		path.insert(path.begin(), '/');
+	}
+
+	return _root + path;
+}
+
+std::map<std::string, HttpStaticFiles::Entry>::iterator HttpStaticFiles::erase(std::map<std::string, Entry>::iterator i)
+{
+	_recent.erase(i->second.use);
+	return _files.erase(i);
+}
+
+void HttpStaticFiles::evict(const std::string& path)
+{
+	auto i = _files.find(path);
+	if (i != _files.end())
+	{
+		erase(i);
+	}
+
+	auto dir = path + "/";
+	for (i = _files.lower_bound(dir); i != _files.end() && i->first.compare(0, dir.size(), dir) == 0; )
+	{
+		i = erase(i);
+	}
+}
+
+void HttpStaticFiles::invalidate()
+{
+	if (_inotify == -1)
+	{
+		return;
+	}
+
+	alignas(inotify_event) char buff[4096];
+	for (;;)
+	{
+		auto n = ::read(_inotify, buff, sizeof(buff));
+		if (n == -1 && errno == EINTR)
+		{
+			continue;
+		}
+		if (n <= 0)
+		{
+			break;
+		}
+
+		for (auto p = buff; p < buff + n; )
+		{
+			auto event = reinterpret_cast<const inotify_event*>(p);
+			p += sizeof(inotify_event) + event->len;
+
+			// Часть событий потеряна - доверять кешу больше нельзя
+			if (event->mask & IN_Q_OVERFLOW)
+			{
+				_files.clear();
+				_recent.clear();
+				continue;
+			}
+
+			auto i = _watchToDir.find(event->wd);
+			if (i == _watchToDir.end())
+			{
+				continue;
+			}
+
+			if (event->len)
+			{
+				evict(i->second + "/" + event->name);
+			}
+
+			// Каталог удален или перемещен - наблюдение снято ядром
+			if (event->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF))
+			{
+				evict(i->second);
+			}
+			if (event->mask & IN_IGNORED)
+			{
+				_dirToWatch.erase(i->second);
+				_watchToDir.erase(i);
+			}
+		}
+	}
+}
+
+std::shared_ptr<HttpStaticFiles::File> HttpStaticFiles::lookup(const std::string& path)
+{
+	std::lock_guard<std::mutex> lockGuard(_mutex);
+
+	invalidate();
+
+	auto i = _files.find(path);
+	if (i != _files.end())
+	{
+		// Запрошенный файл - теперь самый недавний
+		_recent.splice(_recent.end(), _recent, i->second.use);
+		return i->second.file;
+	}
+
+	auto file = std::make_shared<File>();
+
+	file->fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (file->fd == -1)
+	{
+		return nullptr;
+	}
+
+	struct stat st{};
+	if (::fstat(file->fd, &st) == -1 || !S_ISREG(st.st_mode))
+	{
+		return nullptr;
+	}
+
+	file->size = st.st_size;
+	file->mtime = st.st_mtime;
+
+	char etag[64];
+	snprintf(etag, sizeof(etag), "\"%lx-%lx-%lx\"",
+		static_cast<unsigned long>(st.st_ino),
+		static_cast<unsigned long>(st.st_size),
+		static_cast<unsigned long>(st.st_mtim.tv_sec * 1000 + st.st_mtim.tv_nsec / 1000000)
+	);
+	file->etag = etag;
+	file->lastModified = gmtDate(file->mtime);
+	file->contentType = contentType(path);
+
+	if (_inotify == -1 || _maxFiles == 0)
+	{
+		return file;
+	}
+
+	// Кешируем только под наблюдением за каталогом
+	auto dir = path.substr(0, path.rfind('/'));
+	if (_dirToWatch.find(dir) == _dirToWatch.end())
+	{
+		auto wd = inotify_add_watch(_inotify, dir.empty() ? "/" : dir.c_str(), watchMask);
+		if (wd == -1)
+		{
+			_log.debug("Can't watch '%s' (%s)", dir.c_str(), strerror(errno));
+			return file;
+		}
+		_watchToDir[wd] = dir;
+		_dirToWatch[dir] = wd;
+	}
+
+	// Вытесняем дольше всех не запрашиваемый файл
+	if (_files.size() >= _maxFiles)
+	{
+		erase(_files.find(_recent.front()));
+	}
+	_files.emplace(path, Entry{file, _recent.insert(_recent.end(), path)});
+
+	return file;
+}
+
+void HttpStaticFiles::reply(TcpConnection& connection, HttpResponse& response)
+{
+	response << HttpHeader("Keep-Alive", "timeout=15, max=100");
+	connection.setTtl(std::chrono::seconds(20));
+
+	response >> connection;
+}
+
+void HttpStaticFiles::handle(const std::shared_ptr<Context>& context_)
+{
+	auto context = std::dynamic_pointer_cast<HttpContext>(context_);
+	if (!context)
+	{
+		throw std::runtime_error("Bad context-type for static files");
+	}
+
+	auto connection = std::dynamic_pointer_cast<TcpConnection>(context->connection());
+	if (!connection)
+	{
+		return;
+	}
+
+	auto request = context->getRequest();
+
+	// HEAD - те же заголовки, что и для GET, но без тела (тело HttpResponse отбросит сам, файл не пишем)
+	bool head = request->method() == HttpRequest::Method::HEAD;
+
+	if (request->method() != HttpRequest::Method::GET && !head)
+	{
+		HttpResponse response(405, "", request->protocol());
+		response
+			<< HttpHeader("Allow", "GET, HEAD")
+			<< "Method not allowed\r\n";
+		reply(*connection, response);
+		return;
+	}
+
+	auto path = resolve(request->uri().path());
+	auto file = path.empty() ? nullptr : lookup(path);
+	if (!file)
+	{
+		HttpResponse response(404, "Not Found", request->protocol());
+		response << "Not found file for uri " << request->uri().path() << "\r\n";
+		reply(*connection, response);
+
+		_log.debug("RESPONSE: 404 Not found file '%s'", path.c_str());
+		return;
+	}
+
+	// Условные запросы: If-None-Match приоритетнее If-Modified-Since
+	bool notModified = false;
+	auto ifNoneMatch = request->getHeader("If-None-Match");
+	if (!ifNoneMatch.empty())
+	{
+		notModified = ifNoneMatch == "*" || ifNoneMatch.find(file->etag) != std::string::npos;
+	}
+	else
+	{
+		std::time_t since;
+		auto ifModifiedSince = request->getHeader("If-Modified-Since");
+		if (!ifModifiedSince.empty() && parseGmtDate(ifModifiedSince, since))
+		{
+			notModified = file->mtime <= since;
+		}
+	}
+
+	if (notModified)
+	{
+		HttpResponse response(304, "", request->protocol());
+		response
+			<< HttpHeader("ETag", file->etag)
+			<< HttpHeader("Last-Modified", file->lastModified);
+		reply(*connection, response);
+		return;
+	}
+
+	auto size = static_cast<size_t>(file->size);
+	size_t begin = 0;
+	size_t end = size;
+	bool partial = false;
+
+	// Поддерживается только один диапазон; несколько - отдаем файл целиком
+	auto range = request->getHeader("Range");
+	auto ifRange = request->getHeader("If-Range");
+	if (
+		range.compare(0, 6, "bytes=") == 0 && range.find(',') == std::string::npos &&
+		(ifRange.empty() || ifRange == file->etag || ifRange == file->lastModified)
+	)
+	{
+		auto spec = range.substr(6);
+		auto dash = spec.find('-');
+		char* tail = nullptr;
+
+		if (dash == 0 && spec.size() > 1)
+		{
+			// Последние N байт (нулевой суффикс невыполним)
+			auto suffix = std::strtoull(spec.c_str() + 1, &tail, 10);
+			if (*tail == '\0')
+			{
+				partial = true;
+				begin = suffix == 0 ? size : suffix < size ? size - suffix : 0;
+			}
+		}
+		else if (dash != std::string::npos && dash > 0)
+		{
+			auto first = std::strtoull(spec.c_str(), &tail, 10);
+			if (tail == spec.c_str() + dash)
+			{
+				partial = true;
+				begin = first;
+				if (dash + 1 < spec.size())
+				{
+					auto last = std::strtoull(spec.c_str() + dash + 1, &tail, 10);
+					if (*tail != '\0' || last < first)
+					{
+						partial = false;
+					}
+					else if (last + 1 < size)
+					{
+						end = last + 1;
+					}
+				}
+			}
+		}
+
+		if (partial && begin >= size)
+		{
+			HttpResponse response(416, "", request->protocol());
+			response
+				<< HttpHeader("Content-Range", "bytes */" + std::to_string(size))
+				<< "Requested range not satisfiable\r\n";
+			reply(*connection, response);
+			return;
+		}
+		if (!partial)
+		{
+			begin = 0;
+			end = size;
+		}
+	}
+
+	HttpResponse response(partial ? 206 : 200, "", request->protocol());
+	response
+		<< HttpHeader("Content-Type", file->contentType)
+		<< HttpHeader("Content-Length", std::to_string(end - begin))
+		<< HttpHeader("Accept-Ranges", "bytes")
+		<< HttpHeader("ETag", file->etag)
+		<< HttpHeader("Last-Modified", file->lastModified);
+	if (partial)
+	{
+		response << HttpHeader(
+			"Content-Range",
+			"bytes " + std::to_string(begin) + "-" + std::to_string(end - 1) + "/" + std::to_string(size)
+		);
+	}
+	reply(*connection, response);
+
+	// Тело - участком файла, без чтения в память
+	if (!head)
+	{
+		connection->writeFile(file, file->fd, static_cast<off_t>(begin), end - begin);
+	}
+
+	_log.debug("RESPONSE: %d '%s' %zu-%zu/%zu%s", partial ? 206 : 200, path.c_str(), begin, end, size, head ? " (head)" : "");
+}
@@ -0,0 +1,136 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// HttpStaticFiles.hpp
+
+
+#pragma once
+
+#include "../ServerTransport.hpp"
+#include "../../log/Log.hpp"
+
+#include <ctime>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <sys/types.h>
+
+class HttpContext;
+class HttpRequest;
+class HttpResponse;
+class TcpConnection;
+
+/// Раздача статических файлов из каталога.
+/// Содержимое уходит в сокет через sendfile (для TLS - блоками через промежуточный буфер),
+/// открытые дескрипторы и результаты stat кешируются и сбрасываются по событиям inotify.
+/// Поддерживаются Range (один диапазон), ETag/If-None-Match, If-Modified-Since и If-Range.
+///
+/// Подключение: transport->bindHandler("/static/", HttpStaticFiles::handler("/var/www", "/static/"));
+class HttpStaticFiles final
+{
+public:
+	/// Открытый файл. Живет, пока на него ссылаются кеш или неотправленные фрагменты соединений
+	struct File final
+	{
+		int fd;
+		off_t size;
+		std::time_t mtime;
+		std::string etag;
+		std::string lastModified;
+		std::string contentType;
+
+		File(const File&) = delete;
+		File& operator=(const File&) = delete;
+
+		File()
+		: fd(-1)
+		, size(0)
+		, mtime(0)
+		{
+		}
+		~File();
+	};
+
+private:
+	Log _log;
+
+	/// Корневой каталог и префикс URI, отбрасываемый от пути запроса
+	const std::string _root;
+	const std::string _prefix;
+
+	/// Предельное количество файлов в кеше
+	const size_t _maxFiles;
+
+	std::mutex _mutex;
+
+	/// Запись кеша: файл и его место в порядке использования
+	struct Entry final
+	{
+		std::shared_ptr<File> file;
+		std::list<std::string>::iterator use;
+	};
+
+	/// Кеш открытых файлов по полному пути
+	std::map<std::string, Entry> _files;
+
+	/// Пути кешированных файлов от давно не запрашиваемых к недавним (вытесняется первый)
+	std::list<std::string> _recent;
+
+	/// Отслеживание изменений (-1 - кеширование отключено)
+	int _inotify;
+	std::unordered_map<int, std::string> _watchToDir;
+	std::unordered_map<std::string, int> _dirToWatch;
+
+	/// Разобрать накопившиеся события inotify и сбросить затронутые записи кеша
+	void invalidate();
+
+	/// Сбросить запись файла и все записи внутри каталога с этим путем
+	void evict(const std::string& path);
+
+	/// Удалить запись кеша
+	std::map<std::string, Entry>::iterator erase(std::map<std::string, Entry>::iterator i);
+
+	/// Найти файл в кеше или открыть его
+	std::shared_ptr<File> lookup(const std::string& path);
+
+	/// Путь к файлу по URI запроса (пустая строка - недопустимый путь)
+	std::string resolve(const std::string& uriPath) const;
+
+	void reply(TcpConnection& connection, HttpResponse& response);
+
+public:
+	HttpStaticFiles() = delete;
+	HttpStaticFiles(const HttpStaticFiles&) = delete;
+	HttpStaticFiles& operator=(const HttpStaticFiles&) = delete;
+	HttpStaticFiles(HttpStaticFiles&&) noexcept = delete;
+	HttpStaticFiles& operator=(HttpStaticFiles&&) noexcept = delete;
+
+	HttpStaticFiles(const std::string& root, const std::string& prefix, size_t maxFiles = 1024);
+	~HttpStaticFiles();
+
+	void handle(const std::shared_ptr<Context>& context);
+
+	/// Обработчик для HttpServer::bindHandler
+	static std::shared_ptr<ServerTransport::Handler> handler(const std::string& root, const std::string& prefix, size_t maxFiles = 1024);
+
+	/// MIME-тип по расширению файла
+	static const std::string& contentType(const std::string& path);
+};
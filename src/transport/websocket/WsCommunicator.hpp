@@ -21,7 +21,7 @@
 
 #pragma once
 
-#include <sys/ucontext.h>
+#include "../../thread/CoroContext.hpp"
 #include <mutex>
 #include "../../utils/Shareable.hpp"
 #include "../../log/Log.hpp"
@@ -32,7 +32,7 @@
 class WsCommunicator: public Shareable<WsCommunicator>
 {
 private:
-	ucontext_t* _savedCtx;
+	CoroContext* _savedCtx;
 	Log _log;
 	std::shared_ptr<WsClient> _websocketClient;
 	HttpUri _uri;
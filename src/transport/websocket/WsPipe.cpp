@@ -23,6 +23,7 @@
 #include "WsPipe.hpp"
 #include "WsContext.hpp"
 #include "../../net/ConnectionManager.hpp"
+#include "../../utils/MemoryBudget.hpp"
 
 static uint32_t id4noname = 0;
 
@@ -98,6 +99,22 @@ bool WsPipe::processing(const std::shared_ptr<Connection>& connection_)
 			auto frame = std::make_shared<WsFrame>(connection->dataPtr(), connection->dataPtr() + connection->dataLen());
 			_log.debug("Read %zu bytes of frame header. Size of data: %zu bytes", headerSize, frame->contentLength());
 
+			// Тело фрейма не поместится в бюджет памяти - закрываем, не читая его
+			if (!MemoryBudget::affordable(frame->contentLength()))
+			{
+				_log.info("Rejected frame of %zu bytes (memory budget exceeded)", frame->contentLength());
+
+				std::string msg("##Try again later\n");
+				uint16_t code = htobe16(1013); // Try Again Later
+				memcpy(const_cast<char*>(msg.data()), &code, sizeof(code));
+				WsFrame::send(connection, WsFrame::Opcode::Close, msg.c_str(), msg.length());
+				connection->setTtl(std::chrono::milliseconds(50));
+
+				connection->close();
+				connection->resetContext();
+				goto end;
+			}
+
 			context->setFrame(frame);
 
 			// Пропускаем байты заголовка фрейма
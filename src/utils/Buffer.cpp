@@ -20,15 +20,82 @@
 
 
 #include "Buffer.hpp"
+#include "BufferPool.hpp"
 #include <algorithm>
 #include <cstring>
 
 Buffer::Buffer()
 : _getPosition(0)
 , _putPosition(0)
+, _charged(0)
 {
 }
 
+Buffer::~Buffer()
+{
+	MemoryBudget::release(_charged, _account.get());
+}
+
+void Buffer::account()
+{
+	auto capacity = _data.capacity();
+	if (capacity > _charged)
+	{
+		MemoryBudget::charge(capacity - _charged, _account.get());
+	}
+	else if (capacity < _charged)
+	{
+		MemoryBudget::release(_charged - capacity, _account.get());
+	}
+	_charged = capacity;
+}
+
+void Buffer::setAccount(const std::shared_ptr<MemoryBudget::Account>& account)
+{
+	std::lock_guard<std::recursive_mutex> guard(_mutex);
+
+	MemoryBudget::release(_charged, _account.get());
+	_account = account;
+	MemoryBudget::charge(_charged, _account.get());
+}
+
+void Buffer::shrink()
+{
+	std::lock_guard<std::recursive_mutex> guard(_mutex);
+
+	// Смещаем непрочитанные данные в начало буффера
+	if (_getPosition > 0)
+	{
+		std::copy_n(_data.cbegin() + _getPosition, _putPosition - _getPosition, _data.begin());
+
+		_putPosition -= _getPosition;
+		_getPosition = 0;
+	}
+
+	_data.resize(_putPosition);
+	_data.shrink_to_fit();
+
+	account();
+}
+
+void Buffer::release()
+{
+	std::lock_guard<std::recursive_mutex> guard(_mutex);
+
+	if (_putPosition != _getPosition || _data.capacity() == 0)
+	{
+		return;
+	}
+
+	_getPosition = 0;
+	_putPosition = 0;
+
+	BufferPool::give(std::move(_data));
+	_data = std::vector<char>();
+
+	account();
+}
+
 const std::vector<char>& Buffer::data()
 {
 	std::lock_guard<std::recursive_mutex> guard(_mutex);
@@ -154,7 +221,19 @@ bool Buffer::prepare(size_t length)
 	// Все еще недостаточно места в конце буффера
 	if (_putPosition + length > _data.size())
 	{
-		_data.resize(((_putPosition + length) / (1ull<<12) + 1) * (1ull<<12));
+		auto size = ((_putPosition + length) / (1ull<<12) + 1) * (1ull<<12);
+
+		// Пустой буфер берет память из общего пула
+		if (_data.capacity() == 0)
+		{
+			_data = BufferPool::take(size);
+		}
+		if (_data.size() < size)
+		{
+			_data.resize(size);
+		}
+
+		account();
 	}
 	return true;
 }
@@ -23,8 +23,10 @@
 
 #include "Reader.hpp"
 #include "Writer.hpp"
+#include "MemoryBudget.hpp"
 
 #include <cstddef>
+#include <memory>
 #include <mutex>
 #include <vector>
 
@@ -43,6 +45,13 @@ protected:
 	/// Смещение на точку, куда будут добавляться данные в буфер
 	size_t _putPosition;
 
+	/// Учетная группа памяти и учтенная в бюджете емкость
+	std::shared_ptr<MemoryBudget::Account> _account;
+	size_t _charged;
+
+	/// Привести учтенную емкость к фактической
+	void account();
+
 public:
 	Buffer(const Buffer&) = delete;
 	Buffer& operator=(const Buffer&) = delete;
@@ -50,13 +59,22 @@ public:
 	Buffer& operator=(Buffer&&) noexcept = delete;
 
 	Buffer();
-	virtual ~Buffer() = default;
+	virtual ~Buffer();
 
 	inline auto& mutex()
 	{ return _mutex; }
 
 	size_t size() const;
 
+	/// Учитывать память буфера в группе (например, транспорта)
+	void setAccount(const std::shared_ptr<MemoryBudget::Account>& account);
+
+	/// Вернуть неиспользуемую память (непрочитанные данные сохраняются)
+	void shrink();
+
+	/// Отдать хранилище опустевшего буфера в общий пул (с новыми данными память берется оттуда же)
+	void release();
+
 	virtual const std::vector<char>& data();
 	const char* dataPtr() const override;
 	size_t dataLen() const override;
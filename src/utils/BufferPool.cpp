@@ -0,0 +1,114 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// BufferPool.cpp
+
+
+#include "BufferPool.hpp"
+#include "MemoryBudget.hpp"
+
+const size_t BufferPool::minSize;
+const size_t BufferPool::classCount;
+const size_t BufferPool::classLimit;
+
+BufferPool::BufferPool()
+: _pooled(0)
+{
+}
+
+std::vector<char> BufferPool::take(size_t size)
+{
+	auto& instance = getInstance();
+
+	for (size_t i = 0; i < classCount; ++i)
+	{
+		if ((minSize << i) < size)
+		{
+			continue;
+		}
+
+		auto& cls = instance._classes[i];
+		std::lock_guard<std::mutex> lockGuard(cls.mutex);
+
+		// Класс пуст - берем из следующего, большего
+		if (cls.blocks.empty())
+		{
+			continue;
+		}
+
+		auto storage = std::move(cls.blocks.back());
+		cls.blocks.pop_back();
+		cls.bytes -= storage.capacity();
+
+		instance._pooled -= storage.capacity();
+		MemoryBudget::release(storage.capacity());
+
+		return storage;
+	}
+
+	return std::vector<char>();
+}
+
+void BufferPool::give(std::vector<char>&& storage_)
+{
+	// Забираем хранилище в любом случае: у вызывающего оно должно остаться пустым
+	std::vector<char> storage(std::move(storage_));
+
+	auto& instance = getInstance();
+
+	auto capacity = storage.capacity();
+	if (capacity < minSize)
+	{
+		return;
+	}
+
+	// Наибольший класс, который хранилище вмещает целиком
+	size_t i = 0;
+	while (i + 1 < classCount && (minSize << (i + 1)) <= capacity)
+	{
+		++i;
+	}
+
+	// Слишком крупное не удерживаем, чтобы не подменять им мелкие
+	if (capacity >= (minSize << i) * 2)
+	{
+		return;
+	}
+
+	auto& cls = instance._classes[i];
+	std::lock_guard<std::mutex> lockGuard(cls.mutex);
+
+	if (cls.bytes + capacity > classLimit)
+	{
+		return;
+	}
+
+	// Буфер считает доступным объем по размеру вектора
+	storage.resize(capacity);
+
+	cls.bytes += capacity;
+	cls.blocks.emplace_back(std::move(storage));
+
+	instance._pooled += capacity;
+	MemoryBudget::charge(capacity);
+}
+
+size_t BufferPool::pooled()
+{
+	return getInstance()._pooled;
+}
@@ -0,0 +1,77 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// BufferPool.hpp
+
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+/// Общий пул памяти опустевших буферов. Простаивающие соединения возвращают сюда
+/// хранилище своих буферов и получают его обратно с приходом новых данных.
+/// Хранилища разложены по классам размеров 4..64 КиБ; более крупные не удерживаются
+class BufferPool final
+{
+public:
+	BufferPool(BufferPool const&) = delete;
+	void operator= (BufferPool const&) = delete;
+	BufferPool(BufferPool&&) noexcept = delete;
+	BufferPool& operator=(BufferPool&&) noexcept = delete;
+
+private:
+	BufferPool();
+	~BufferPool() = default;
+
+	static BufferPool &getInstance()
+	{
+		static BufferPool instance;
+		return instance;
+	}
+
+	/// Размер младшего класса и количество классов (каждый следующий вдвое больше)
+	static const size_t minSize = 1u << 12;
+	static const size_t classCount = 5;
+
+	/// Предельный объем памяти, удерживаемый в одном классе
+	static const size_t classLimit = 1u << 24;
+
+	struct Class final
+	{
+		std::mutex mutex;
+		std::vector<std::vector<char>> blocks;
+		size_t bytes = 0;
+	};
+
+	Class _classes[classCount];
+
+	std::atomic_size_t _pooled;
+
+public:
+	/// Взять хранилище емкостью не меньше size (пустое, если подходящего нет)
+	static std::vector<char> take(size_t size);
+
+	/// Вернуть хранилище в пул (не подошедшее по размеру или сверх предела освобождается)
+	static void give(std::vector<char>&& storage);
+
+	/// Объем памяти в пуле
+	static size_t pooled();
+};
@@ -0,0 +1,122 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// IntrusiveQueue.hpp
+
+
+#pragma once
+
+#include <atomic>
+
+/// Интрузивная очередь Вьюкова: много производителей без блокировок, один потребитель
+class IntrusiveQueue final
+{
+public:
+	/// Звено очереди (встраивается в элемент наследованием)
+	class Node
+	{
+		friend class IntrusiveQueue;
+
+	private:
+		std::atomic<Node*> _next;
+
+	public:
+		Node() noexcept
+		: _next(nullptr)
+		{
+		}
+		virtual ~Node() = default;
+	};
+
+private:
+	/// Куда добавляют производители
+	std::atomic<Node*> _head;
+
+	/// Откуда забирает потребитель
+	Node* _tail;
+
+	/// Заглушка, не дающая очереди стать пустой физически
+	Node _stub;
+
+public:
+	IntrusiveQueue(const IntrusiveQueue&) = delete; // Copy-constructor
+	IntrusiveQueue& operator=(const IntrusiveQueue&) = delete; // Copy-assignment
+	IntrusiveQueue(IntrusiveQueue&&) noexcept = delete; // Move-constructor
+	IntrusiveQueue& operator=(IntrusiveQueue&&) noexcept = delete; // Move-assignment
+
+	IntrusiveQueue()
+	: _head(&_stub)
+	, _tail(&_stub)
+	{
+	}
+	~IntrusiveQueue() = default;
+
+	/// Добавить звено (из любого потока)
+	void push(Node* node)
+	{
+		node->_next.store(nullptr, std::memory_order_relaxed);
+		Node* prev = _head.exchange(node, std::memory_order_acq_rel);
+		prev->_next.store(node, std::memory_order_release);
+	}
+
+	/// Извлечь звено (только потребитель). nullptr - очередь пуста или производитель еще не завершил добавление
+	Node* pop()
+	{
+		Node* tail = _tail;
+		Node* next = tail->_next.load(std::memory_order_acquire);
+
+		if (tail == &_stub)
+		{
+			if (next == nullptr)
+			{
+				return nullptr;
+			}
+			_tail = next;
+			tail = next;
+			next = next->_next.load(std::memory_order_acquire);
+		}
+
+		if (next != nullptr)
+		{
+			_tail = next;
+			return tail;
+		}
+
+		if (tail != _head.load(std::memory_order_acquire))
+		{
+			return nullptr;
+		}
+
+		push(&_stub);
+
+		next = tail->_next.load(std::memory_order_acquire);
+		if (next != nullptr)
+		{
+			_tail = next;
+			return tail;
+		}
+
+		return nullptr;
+	}
+
+	/// Проверить наличие звеньев (только потребитель)
+	bool empty() const
+	{
+		return _tail == &_stub && _stub._next.load(std::memory_order_acquire) == nullptr;
+	}
+};
@@ -0,0 +1,128 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// MemoryBudget.hpp
+
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+/// Общий учет памяти буферов процесса с ограничением (бюджетом).
+/// Буферы сообщают об изменении своей емкости; при превышении бюджета
+/// новые подключения отклоняются, простаивающие буферы сжимаются,
+/// а запросы, которые заведомо не поместятся, отвергаются до чтения тела
+class MemoryBudget final
+{
+public:
+	/// Учетная группа (например, транспорт) - своя сумма внутри общего учета
+	class Account final
+	{
+		friend class MemoryBudget;
+
+	private:
+		std::atomic_size_t _used;
+
+	public:
+		Account(const Account&) = delete;
+		Account& operator=(const Account&) = delete;
+
+		Account()
+		: _used(0)
+		{
+		}
+
+		size_t used() const
+		{
+			return _used;
+		}
+	};
+
+	MemoryBudget(MemoryBudget const&) = delete;
+	void operator= (MemoryBudget const&) = delete;
+	MemoryBudget(MemoryBudget&&) noexcept = delete;
+	MemoryBudget& operator=(MemoryBudget&&) noexcept = delete;
+
+private:
+	MemoryBudget()
+	: _used(0)
+	, _limit(0)
+	{
+	}
+	~MemoryBudget() = default;
+
+	static MemoryBudget &getInstance()
+	{
+		static MemoryBudget instance;
+		return instance;
+	}
+
+	std::atomic_size_t _used;
+
+	/// Бюджет (0 - без ограничения)
+	std::atomic_size_t _limit;
+
+public:
+	static void setLimit(size_t limit)
+	{
+		getInstance()._limit = limit;
+	}
+	static size_t limit()
+	{
+		return getInstance()._limit;
+	}
+	static size_t used()
+	{
+		return getInstance()._used;
+	}
+
+	static void charge(size_t size, Account* account = nullptr)
+	{
+		getInstance()._used += size;
+		if (account)
+		{
+			account->_used += size;
+		}
+	}
+	static void release(size_t size, Account* account = nullptr)
+	{
+		getInstance()._used -= size;
+		if (account)
+		{
+			account->_used -= size;
+		}
+	}
+
+	/// Бюджет превышен
+	static bool exceeded()
+	{
+		auto& instance = getInstance();
+		size_t limit = instance._limit;
+		return limit != 0 && instance._used > limit;
+	}
+
+	/// Дополнительный объем помещается в бюджет
+	static bool affordable(size_t size)
+	{
+		auto& instance = getInstance();
+		size_t limit = instance._limit;
+		return limit == 0 || instance._used + size <= limit;
+	}
+};
@@ -26,7 +26,8 @@
 class Named
 {
 protected:
-	std::string _name;
+	/// mutable - наследники могут формировать имя лениво, при первом обращении
+	mutable std::string _name;
 
 public:
 	Named() = default;
@@ -0,0 +1,253 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// ObjectPool.hpp
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+
+/// Пул блоков одного размера. Освобожденные блоки не возвращаются аллокатору общего назначения,
+/// а переиспользуются: у каждого потока свой небольшой запас без блокировок,
+/// излишки и запас завершившихся потоков уходят в общий список под мютексом
+template<size_t Size>
+class SlabPool final
+{
+private:
+	union Block
+	{
+		Block* next;
+		alignas(std::max_align_t) char data[Size];
+	};
+
+	/// Блоков в одном выделении у аллокатора общего назначения
+	static const size_t slabBlocks = 64;
+
+	/// Предельный запас потока; при превышении половина уходит в общий список
+	static const size_t cacheLimit = 128;
+
+	struct Shared final
+	{
+		std::mutex mutex;
+		Block* head = nullptr;
+		size_t count = 0;
+	};
+
+	/// Общий список не разрушается при завершении процесса: блоки могут освобождаться до самого конца
+	static Shared& shared()
+	{
+		static Shared& instance = *new Shared;
+		return instance;
+	}
+
+	/// Запас потока (тривиальный тип - доступен и после разрушения объектов потока)
+	struct Cache final
+	{
+		Block* head;
+		size_t count;
+		bool exited;
+	};
+
+	static Cache& cache()
+	{
+		static thread_local Cache instance{nullptr, 0, false};
+		return instance;
+	}
+
+	/// Возвращает запас потока в общий список при завершении потока
+	struct Flusher final
+	{
+		~Flusher()
+		{
+			cache().exited = true;
+			release(cache().count);
+		}
+	};
+
+	static void holdFlusher()
+	{
+		static thread_local Flusher flusher;
+		(void)flusher;
+	}
+
+	/// Перенести count блоков из запаса потока в общий список
+	static void release(size_t count)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+
+		auto& local = cache();
+
+		Block* first = local.head;
+		Block* last = first;
+		for (size_t i = 1; i < count; ++i)
+		{
+			last = last->next;
+		}
+		local.head = last->next;
+		local.count -= count;
+
+		auto& pool = shared();
+		std::lock_guard<std::mutex> lockGuard(pool.mutex);
+		last->next = pool.head;
+		pool.head = first;
+		pool.count += count;
+	}
+
+	/// Пополнить запас потока из общего списка или новым выделением
+	static void refill()
+	{
+		auto& local = cache();
+		{
+			auto& pool = shared();
+			std::lock_guard<std::mutex> lockGuard(pool.mutex);
+			while (pool.head != nullptr && local.count < cacheLimit / 2)
+			{
+				auto block = pool.head;
+				pool.head = block->next;
+				--pool.count;
+				block->next = local.head;
+				local.head = block;
+				++local.count;
+			}
+		}
+		if (local.head != nullptr)
+		{
+			return;
+		}
+
+		auto slab = static_cast<Block*>(::operator new(sizeof(Block) * slabBlocks));
+		for (size_t i = 0; i < slabBlocks; ++i)
+		{
+			slab[i].next = local.head;
+			local.head = &slab[i];
+		}
+		local.count += slabBlocks;
+	}
+
+public:
+	static void* allocate()
+	{
+		auto& local = cache();
+		if (!local.exited)
+		{
+			holdFlusher();
+		}
+
+		if (local.head == nullptr)
+		{
+			refill();
+		}
+
+		auto block = local.head;
+		local.head = block->next;
+		--local.count;
+		return block;
+	}
+
+	static void deallocate(void* ptr)
+	{
+		auto block = static_cast<Block*>(ptr);
+
+		auto& local = cache();
+
+		// Поток завершается - запас уже возвращен, отдаем сразу в общий список
+		if (local.exited)
+		{
+			auto& pool = shared();
+			std::lock_guard<std::mutex> lockGuard(pool.mutex);
+			block->next = pool.head;
+			pool.head = block;
+			++pool.count;
+			return;
+		}
+
+		holdFlusher();
+
+		block->next = local.head;
+		local.head = block;
+		if (++local.count > cacheLimit)
+		{
+			release(cacheLimit / 2);
+		}
+	}
+};
+
+/// Аллокатор поштучных объектов из SlabPool (для std::allocate_shared и узловых контейнеров).
+/// Размеры округляются до 16 байт, так что близкие по размеру типы делят один пул
+template<class T>
+class PoolAllocator
+{
+private:
+	static const size_t blockSize = (sizeof(T) + 15) & ~size_t(15);
+
+	static_assert(alignof(T) <= alignof(std::max_align_t), "Over-aligned types are not supported by pool");
+
+public:
+	typedef T value_type;
+
+	PoolAllocator() noexcept = default;
+	template<class U>
+	PoolAllocator(const PoolAllocator<U>&) noexcept
+	{
+	}
+
+	T* allocate(size_t n)
+	{
+		if (n == 1)
+		{
+			return static_cast<T*>(SlabPool<blockSize>::allocate());
+		}
+		return static_cast<T*>(::operator new(n * sizeof(T)));
+	}
+
+	void deallocate(T* ptr, size_t n) noexcept
+	{
+		if (n == 1)
+		{
+			SlabPool<blockSize>::deallocate(ptr);
+			return;
+		}
+		::operator delete(ptr);
+	}
+
+	template<class U>
+	bool operator==(const PoolAllocator<U>&) const noexcept
+	{
+		return true;
+	}
+	template<class U>
+	bool operator!=(const PoolAllocator<U>&) const noexcept
+	{
+		return false;
+	}
+};
+
+/// Аналог std::make_shared, размещающий объект вместе со счетчиком ссылок в пуле
+template<class T, class... Args>
+inline std::shared_ptr<T> makePooled(Args&&... args)
+{
+	return std::allocate_shared<T>(PoolAllocator<T>(), std::forward<Args>(args)...);
+}
@@ -0,0 +1,305 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// OutputChain.cpp
+
+
+#include "OutputChain.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+const size_t OutputChain::chunkSize;
+
+OutputChain::OutputChain()
+: _dataLen(0)
+{
+}
+
+bool OutputChain::chunkIsTail() const
+{
+	if (!_chunk || _slices.empty())
+	{
+		return false;
+	}
+	auto& last = _slices.back();
+	return last._fd < 0 && last._holder == _chunk && last._data + last._length == _chunk->data.get() + _chunk->used;
+}
+
+bool OutputChain::write(const void* data, size_t length)
+{
+	if (length == 0)
+	{
+		return true;
+	}
+
+	std::lock_guard<std::recursive_mutex> guard(_mutex);
+
+	// Крупное не копируем в блок, а кладем отдельным собственным фрагментом
+	if (length > chunkSize / 2)
+	{
+		auto copy = std::make_shared<Chunk>(length, _account);
+		memcpy(copy->data.get(), data, length);
+		copy->used = length;
+		_slices.emplace_back(copy, copy->data.get(), length);
+		_dataLen += length;
+		return true;
+	}
+
+	prepare(length);
+
+	memcpy(spacePtr(), data, length);
+
+	return forward(length);
+}
+
+bool OutputChain::writeBorrowed(const void* data, size_t length)
+{
+	if (length == 0)
+	{
+		return true;
+	}
+
+	std::lock_guard<std::recursive_mutex> guard(_mutex);
+
+	_slices.emplace_back(nullptr, static_cast<const char*>(data), length);
+	_dataLen += length;
+	return true;
+}
+
+bool OutputChain::writeShared(const std::shared_ptr<const std::string>& payload)
+{
+	if (!payload)
+	{
+		return true;
+	}
+	return writeShared(payload, payload->data(), payload->size());
+}
+
+bool OutputChain::writeShared(std::shared_ptr<const void> holder, const char* data, size_t length)
+{
+	if (length == 0)
+	{
+		return true;
+	}
+
+	std::lock_guard<std::recursive_mutex> guard(_mutex);
+
+	_slices.emplace_back(std::move(holder), data, length);
+	_dataLen += length;
+	return true;
+}
+
+bool OutputChain::writeFile(std::shared_ptr<const void> holder, int fd, off_t offset, size_t length)
+{
+	if (length == 0)
+	{
+		return true;
+	}
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	std::lock_guard<std::recursive_mutex> guard(_mutex);
+
+	_slices.emplace_back(std::move(holder), fd, offset, length);
+	_dataLen += length;
+	return true;
+}
+
+char* OutputChain::spacePtr() const
+{
+	std::lock_guard<std::recursive_mutex> guard(_mutex);
+	if (!_chunk)
+	{
+		return nullptr;
+	}
+	return _chunk->data.get() + _chunk->used;
+}
+
+size_t OutputChain::spaceLen() const
+{
+	std::lock_guard<std::recursive_mutex> guard(_mutex);
+	if (!_chunk)
+	{
+		return 0;
+	}
+	return _chunk->capacity - _chunk->used;
+}
+
+bool OutputChain::prepare(size_t length)
+{
+	std::lock_guard<std::recursive_mutex> guard(_mutex);
+
+	if (_chunk && _chunk->capacity - _chunk->used >= length)
+	{
+		return true;
+	}
+
+	// Заполненный блок остается жить во фрагментах, пока они не отправлены
+	_chunk = std::make_shared<Chunk>(std::max(chunkSize, length), _account);
+	return true;
+}
+
+bool OutputChain::forward(size_t length)
+{
+	if (length == 0)
+	{
+		return true;
+	}
+
+	std::lock_guard<std::recursive_mutex> guard(_mutex);
+
+	if (!_chunk || _chunk->capacity - _chunk->used < length)
+	{
+		return false;
+	}
+
+	bool tail = chunkIsTail();
+
+	auto begin = _chunk->data.get() + _chunk->used;
+	_chunk->used += length;
+
+	if (tail)
+	{
+		_slices.back()._length += length;
+	}
+	else
+	{
+		_slices.emplace_back(_chunk, begin, length);
+	}
+
+	_dataLen += length;
+	return true;
+}
+
+void OutputChain::shrink()
+{
+	std::lock_guard<std::recursive_mutex> guard(_mutex);
+
+	if (_chunk && _chunk.use_count() == 1)
+	{
+		_chunk.reset();
+	}
+}
+
+int OutputChain::fill(iovec* iov, int count) const
+{
+	std::lock_guard<std::recursive_mutex> guard(_mutex);
+
+	int n = 0;
+	for (auto i = _slices.cbegin(); i != _slices.cend() && n < count; ++i, ++n)
+	{
+		// Участок файла отправляется отдельно
+		if (i->_fd >= 0)
+		{
+			break;
+		}
+		iov[n].iov_base = const_cast<char*>(i->_data);
+		iov[n].iov_len = i->_length;
+	}
+	return n;
+}
+
+bool OutputChain::multipart(int count) const
+{
+	std::lock_guard<std::recursive_mutex> guard(_mutex);
+
+	if (_slices.size() > static_cast<size_t>(count))
+	{
+		return true;
+	}
+	if (_slices.size() < 2)
+	{
+		return false;
+	}
+	for (const auto& slice : _slices)
+	{
+		if (slice._fd >= 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+const char* OutputChain::frontPtr() const
+{
+	std::lock_guard<std::recursive_mutex> guard(_mutex);
+	return _slices.empty() ? nullptr : _slices.front()._data;
+}
+
+size_t OutputChain::frontLen() const
+{
+	std::lock_guard<std::recursive_mutex> guard(_mutex);
+	return _slices.empty() ? 0 : _slices.front()._length;
+}
+
+int OutputChain::frontFd() const
+{
+	std::lock_guard<std::recursive_mutex> guard(_mutex);
+	return _slices.empty() ? -1 : _slices.front()._fd;
+}
+
+off_t OutputChain::frontOffset() const
+{
+	std::lock_guard<std::recursive_mutex> guard(_mutex);
+	return _slices.empty() ? 0 : _slices.front()._offset;
+}
+
+bool OutputChain::skip(size_t length)
+{
+	std::lock_guard<std::recursive_mutex> guard(_mutex);
+
+	if (length > _dataLen)
+	{
+		return false;
+	}
+
+	_dataLen -= length;
+
+	while (length > 0)
+	{
+		auto& front = _slices.front();
+		if (front._length > length)
+		{
+			if (front._fd >= 0)
+			{
+				front._offset += length;
+			}
+			else
+			{
+				front._data += length;
+			}
+			front._length -= length;
+			break;
+		}
+		length -= front._length;
+		_slices.pop_front();
+	}
+
+	// Все отправлено - блок можно переиспользовать с начала
+	if (_slices.empty() && _chunk && _chunk.use_count() == 1)
+	{
+		_chunk->used = 0;
+	}
+
+	return true;
+}
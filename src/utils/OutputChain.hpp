@@ -0,0 +1,183 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// OutputChain.hpp
+
+
+#pragma once
+
+#include "Writer.hpp"
+#include "MemoryBudget.hpp"
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+/// Очередь исходящих данных из фрагментов (собственных, заимствованных или разделяемых),
+/// отправляемая одним вызовом writev без склейки в непрерывный буфер
+class OutputChain : public Writer
+{
+public:
+	/// Фрагмент данных (участок памяти или участок файла)
+	class Slice final
+	{
+		friend class OutputChain;
+
+	private:
+		/// Владелец памяти или дескриптора фрагмента (пуст для заимствованных данных)
+		std::shared_ptr<const void> _holder;
+		const char* _data;
+		size_t _length;
+
+		/// Дескриптор и смещение участка файла (-1 для фрагментов в памяти)
+		int _fd;
+		off_t _offset;
+
+	public:
+		Slice(std::shared_ptr<const void> holder, const char* data, size_t length)
+		: _holder(std::move(holder))
+		, _data(data)
+		, _length(length)
+		, _fd(-1)
+		, _offset(0)
+		{
+		}
+		Slice(std::shared_ptr<const void> holder, int fd, off_t offset, size_t length)
+		: _holder(std::move(holder))
+		, _data(nullptr)
+		, _length(length)
+		, _fd(fd)
+		, _offset(offset)
+		{
+		}
+	};
+
+private:
+	/// Размер собственного блока для мелких записей
+	static const size_t chunkSize = 1u << 12;
+
+	/// Мютекс защиты очереди
+	mutable std::recursive_mutex _mutex;
+
+	std::deque<Slice> _slices;
+
+	/// Объем неотправленных данных
+	std::atomic_size_t _dataLen;
+
+	/// Учетная группа памяти собственных блоков
+	std::shared_ptr<MemoryBudget::Account> _account;
+
+	/// Собственный блок под записи с копированием (не перевыделяется, поэтому адреса фрагментов стабильны)
+	struct Chunk final
+	{
+		std::unique_ptr<char[]> data;
+		size_t capacity;
+		size_t used;
+		std::shared_ptr<MemoryBudget::Account> account;
+
+		Chunk(size_t size, std::shared_ptr<MemoryBudget::Account> account_)
+		: data(new char[size])
+		, capacity(size)
+		, used(0)
+		, account(std::move(account_))
+		{
+			MemoryBudget::charge(capacity, account.get());
+		}
+		~Chunk()
+		{
+			MemoryBudget::release(capacity, account.get());
+		}
+	};
+
+	/// Текущий блок, в который дописываются мелкие записи
+	std::shared_ptr<Chunk> _chunk;
+
+	/// Последний фрагмент ссылается на конец текущего блока
+	bool chunkIsTail() const;
+
+public:
+	OutputChain(const OutputChain&) = delete;
+	OutputChain& operator=(const OutputChain&) = delete;
+	OutputChain(OutputChain&&) noexcept = delete;
+	OutputChain& operator=(OutputChain&&) noexcept = delete;
+
+	OutputChain();
+	virtual ~OutputChain() = default;
+
+	inline auto& mutex()
+	{ return _mutex; }
+
+	inline size_t dataLen() const
+	{
+		return _dataLen;
+	}
+
+	/// Учитывать память собственных блоков в группе (например, транспорта)
+	void setAccount(const std::shared_ptr<MemoryBudget::Account>& account)
+	{
+		std::lock_guard<std::recursive_mutex> guard(_mutex);
+		_account = account;
+	}
+
+	/// Отпустить текущий блок для мелких записей, если в нем ничего не ждет отправки
+	void shrink();
+
+	/// Добавить копию данных
+	bool write(const void* data, size_t length) override;
+
+	/// Добавить данные без копирования (должны жить до отправки)
+	bool writeBorrowed(const void* data, size_t length);
+
+	/// Добавить разделяемые данные без копирования
+	bool writeShared(const std::shared_ptr<const std::string>& payload);
+
+	/// Добавить разделяемые данные без копирования (произвольный владелец)
+	bool writeShared(std::shared_ptr<const void> holder, const char* data, size_t length);
+
+	/// Добавить участок файла (отправляется без чтения в память, где это возможно).
+	/// Владелец должен держать дескриптор открытым до отправки
+	bool writeFile(std::shared_ptr<const void> holder, int fd, off_t offset, size_t length);
+
+	char* spacePtr() const override;
+	size_t spaceLen() const override;
+	bool prepare(size_t length) override;
+	bool forward(size_t length) override;
+
+	/// Заполнить вектор ввода-вывода с начала очереди (до первого участка файла).
+	/// Возвращает количество элементов
+	int fill(iovec* iov, int count) const;
+
+	/// Отправка займет больше одного вызова (участок файла среди прочих данных или
+	/// фрагментов больше, чем вмещает вектор ввода-вывода)
+	bool multipart(int count) const;
+
+	/// Первый фрагмент (для участка файла frontPtr() возвращает nullptr)
+	const char* frontPtr() const;
+	size_t frontLen() const;
+
+	/// Первый фрагмент - участок файла: его дескриптор и текущее смещение (иначе -1)
+	int frontFd() const;
+	off_t frontOffset() const;
+
+	/// Отбросить отправленное
+	bool skip(size_t length);
+};
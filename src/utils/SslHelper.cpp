@@ -23,7 +23,20 @@
 
 #include <openssl/ssl.h>
 #include <openssl/err.h>
+#include <openssl/rand.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#else
+#include <openssl/hmac.h>
+#endif
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <stdexcept>
+#include "../telemetry/TelemetryManager.hpp"
+
+/// Контекст кеша сессий (сессии одного контекста не принимаются другим)
+static const unsigned char sessionIdContext[] = "primitive";
 
 static std::string certificate = R"(-----BEGIN CERTIFICATE-----
 MIIGJzCCBA+gAwIBAgIBATANBgkqhkiG9w0BAQUFADCBsjELMAkGA1UEBhMCRlIx
@@ -114,6 +127,8 @@ v3TGd3xXD9yQIjmugNgxNiwAZzhJs/ZJy++fPSJ1XQxbd9qPghgGoe/ff6G7
 -----END RSA PRIVATE KEY-----)";
 
 SslHelper::SslHelper()
+: _ticketKeyLifetime(3600)
+, _sessionTimeout(300)
 {
 	SSL_load_error_strings();
 	ERR_load_crypto_strings();
@@ -144,28 +159,277 @@ SslHelper::SslHelper()
 	SSL_CTX_use_certificate(_serverContext.get(), cert);
 	SSL_CTX_use_RSAPrivateKey(_serverContext.get(), rsa);
 
+	// Возобновление сессий: по идентификатору из кеша и по билету, зашифрованному нашим ключом
+	SSL_CTX_set_session_id_context(_serverContext.get(), sessionIdContext, sizeof(sessionIdContext) - 1);
+	SSL_CTX_set_session_cache_mode(_serverContext.get(), SSL_SESS_CACHE_SERVER);
+	SSL_CTX_sess_set_cache_size(_serverContext.get(), 20480);
+	SSL_CTX_set_timeout(_serverContext.get(), _sessionTimeout.count());
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	SSL_CTX_set_tlsext_ticket_key_evp_cb(_serverContext.get(), onTicketKey);
+#else
+	SSL_CTX_set_tlsext_ticket_key_cb(_serverContext.get(), onTicketKey);
+#endif
+
 	X509_free(cert);
 	RSA_free(rsa);
+
+	// Общий контекст исходящих соединений: сессии сохраняем сами, по адресу узла
+	_clientContext = std::shared_ptr<SSL_CTX>(SSL_CTX_new(SSLv23_client_method()), SSL_CTX_Deleter());
+
+	SSL_CTX_set_session_cache_mode(_clientContext.get(), SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+	SSL_CTX_sess_set_new_cb(_clientContext.get(), onNewClientSession);
+
+	_metricFullHandshakes = TelemetryManager::metric("tls/handshakes/full", 1);
+	_metricResumedHandshakes = TelemetryManager::metric("tls/handshakes/resumed", 1);
+	_metricResumeRatio = TelemetryManager::metric("tls/handshakes/resume_ratio", std::chrono::seconds(60));
 }
 
 SslHelper::~SslHelper()
 {
 	_serverContext.reset();
+	_clientContext.reset();
+	_clientSessions.clear();
 	ERR_free_strings();
 	EVP_cleanup();
 }
 
-std::shared_ptr<SSL_CTX> SslHelper::getClientContext()
+int SslHelper::onNewClientSession(SSL* ssl, SSL_SESSION* session)
 {
-	getInstance();
+	auto peer = static_cast<const std::string*>(SSL_get_app_data(ssl));
+	if (peer == nullptr || peer->empty())
+	{
+		return 0;
+	}
 
-	struct SSL_CTX_Deleter {
-		void operator()(SSL_CTX* ctx) const {
-			SSL_CTX_free(ctx);
+	auto& instance = getInstance();
+
+	std::lock_guard<std::mutex> guard(instance._clientSessionsMutex);
+
+	// Сессия переходит в наше владение (возвращаем 1)
+	instance._clientSessions[*peer] = std::shared_ptr<SSL_SESSION>(session, SSL_SESSION_free);
+
+	return 1;
+}
+
+void SslHelper::prepareClient(SSL* ssl, const std::string& host, const std::string* peer)
+{
+	SSL_set_tlsext_host_name(ssl, host.c_str());
+
+	SSL_set_app_data(ssl, const_cast<std::string*>(peer));
+
+	auto& instance = getInstance();
+
+	std::shared_ptr<SSL_SESSION> session;
+	{
+		std::lock_guard<std::mutex> guard(instance._clientSessionsMutex);
+
+		auto i = instance._clientSessions.find(*peer);
+		if (i != instance._clientSessions.end())
+		{
+			session = i->second;
 		}
-	};
+	}
+
+	if (session)
+	{
+		SSL_set_session(ssl, session.get());
+	}
+}
+
+void SslHelper::setSessionCache(size_t size, std::chrono::seconds timeout, std::chrono::seconds ticketKeyLifetime)
+{
+	auto& instance = getInstance();
+	auto ctx = instance._serverContext.get();
 
-    return std::shared_ptr<SSL_CTX>(
-		SSL_CTX_new(SSLv23_client_method()), SSL_CTX_Deleter()
+	if (size > 0)
+	{
+		SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+		SSL_CTX_sess_set_cache_size(ctx, static_cast<long>(size));
+	}
+	else
+	{
+		SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+	}
+	SSL_CTX_set_timeout(ctx, static_cast<long>(timeout.count()));
+
+	if (ticketKeyLifetime.count() > 0)
+	{
+		SSL_CTX_clear_options(ctx, SSL_OP_NO_TICKET);
+	}
+	else
+	{
+		SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+	}
+
+	std::lock_guard<std::mutex> guard(instance._ticketKeysMutex);
+
+	instance._sessionTimeout = timeout;
+	instance._ticketKeyLifetime = ticketKeyLifetime;
+}
+
+void SslHelper::setKernelOffload(bool enable)
+{
+#ifdef SSL_OP_ENABLE_KTLS
+	auto& instance = getInstance();
+
+	for (auto ctx : {instance._serverContext.get(), instance._clientContext.get()})
+	{
+		if (enable)
+		{
+			SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+		}
+		else
+		{
+			SSL_CTX_clear_options(ctx, SSL_OP_ENABLE_KTLS);
+		}
+	}
+#else
+	if (enable)
+	{
+		throw std::runtime_error("Kernel TLS isn't supported by used OpenSSL");
+	}
+#endif
+}
+
+void SslHelper::rotateTicketKeys()
+{
+	auto now = std::chrono::steady_clock::now();
+
+	if (_ticketKeys.empty() || now - _ticketKeys.front().created >= _ticketKeyLifetime)
+	{
+		TicketKey key{};
+		if (RAND_bytes(key.name, sizeof(key.name)) != 1
+			|| RAND_bytes(key.aesKey, sizeof(key.aesKey)) != 1
+			|| RAND_bytes(key.hmacKey, sizeof(key.hmacKey)) != 1)
+		{
+			return;
+		}
+		key.created = now;
+		_ticketKeys.emplace_front(key);
+	}
+
+	// Ключ нужен, пока живы выданные им билеты: он выдавал их до появления следующего ключа
+	while (_ticketKeys.size() > 1 && now - _ticketKeys[_ticketKeys.size() - 2].created >= _sessionTimeout)
+	{
+		auto& key = _ticketKeys.back();
+		OPENSSL_cleanse(&key, sizeof(key));
+		_ticketKeys.pop_back();
+	}
+}
+
+const SslHelper::TicketKey* SslHelper::prepareTicketKey(unsigned char* keyName, unsigned char* iv, EVP_CIPHER_CTX* cipherCtx, int encrypt, int& result)
+{
+	rotateTicketKeys();
+
+	result = -1;
+
+	if (encrypt)
+	{
+		if (_ticketKeys.empty())
+		{
+			return nullptr;
+		}
+
+		const auto& key = _ticketKeys.front();
+
+		memcpy(keyName, key.name, sizeof(key.name));
+		if (RAND_bytes(iv, EVP_MAX_IV_LENGTH) != 1)
+		{
+			return nullptr;
+		}
+		if (EVP_EncryptInit_ex(cipherCtx, EVP_aes_256_cbc(), nullptr, key.aesKey, iv) != 1)
+		{
+			return nullptr;
+		}
+		result = 1;
+		return &key;
+	}
+
+	auto i = std::find_if(_ticketKeys.begin(), _ticketKeys.end(),
+		[keyName](const TicketKey& key)
+		{
+			return memcmp(key.name, keyName, sizeof(key.name)) == 0;
+		}
 	);
+
+	// Ключ неизвестен или уже удален - полное рукопожатие
+	if (i == _ticketKeys.end())
+	{
+		result = 0;
+		return nullptr;
+	}
+
+	if (EVP_DecryptInit_ex(cipherCtx, EVP_aes_256_cbc(), nullptr, i->aesKey, iv) != 1)
+	{
+		return nullptr;
+	}
+
+	// Билет на прежнем ключе принимаем, но выдаем взамен новый
+	result = i == _ticketKeys.begin() ? 1 : 2;
+	return &*i;
+}
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+int SslHelper::onTicketKey(SSL*, unsigned char* keyName, unsigned char* iv, EVP_CIPHER_CTX* cipherCtx, EVP_MAC_CTX* macCtx, int encrypt)
+{
+	auto& instance = getInstance();
+
+	std::lock_guard<std::mutex> guard(instance._ticketKeysMutex);
+
+	int result;
+	auto key = instance.prepareTicketKey(keyName, iv, cipherCtx, encrypt, result);
+	if (key == nullptr)
+	{
+		return result;
+	}
+
+	// Контекст MAC уже создан библиотекой (HMAC) - задаем ему хеш и ключ
+	char digest[] = "SHA256";
+	OSSL_PARAM params[] = {
+		OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, const_cast<unsigned char*>(key->hmacKey), sizeof(key->hmacKey)),
+		OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, digest, 0),
+		OSSL_PARAM_construct_end()
+	};
+	if (EVP_MAC_CTX_set_params(macCtx, params) != 1)
+	{
+		return -1;
+	}
+	return result;
+}
+#else
+int SslHelper::onTicketKey(SSL*, unsigned char* keyName, unsigned char* iv, EVP_CIPHER_CTX* cipherCtx, HMAC_CTX* hmacCtx, int encrypt)
+{
+	auto& instance = getInstance();
+
+	std::lock_guard<std::mutex> guard(instance._ticketKeysMutex);
+
+	int result;
+	auto key = instance.prepareTicketKey(keyName, iv, cipherCtx, encrypt, result);
+	if (key == nullptr)
+	{
+		return result;
+	}
+
+	if (HMAC_Init_ex(hmacCtx, key->hmacKey, sizeof(key->hmacKey), EVP_sha256(), nullptr) != 1)
+	{
+		return -1;
+	}
+	return result;
+}
+#endif
+
+void SslHelper::accountHandshake(SSL* ssl)
+{
+	auto& instance = getInstance();
+
+	if (SSL_session_reused(ssl))
+	{
+		instance._metricResumedHandshakes->addValue();
+		instance._metricResumeRatio->addValue(1);
+	}
+	else
+	{
+		instance._metricFullHandshakes->addValue();
+		instance._metricResumeRatio->addValue(0);
+	}
 }
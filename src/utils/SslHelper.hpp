@@ -21,8 +21,14 @@
 
 #pragma once
 
-#include <openssl/ossl_typ.h>
+#include <openssl/ssl.h>
+#include <chrono>
+#include <deque>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <string>
+#include "../telemetry/Metric.hpp"
 
 class SslHelper final
 {
@@ -43,6 +49,44 @@ private:
 	}
 
 	std::shared_ptr<SSL_CTX> _serverContext;
+	std::shared_ptr<SSL_CTX> _clientContext;
+
+	/// Сессии исходящих соединений для возобновления без полного рукопожатия (по адресу узла)
+	std::mutex _clientSessionsMutex;
+	std::map<std::string, std::shared_ptr<SSL_SESSION>> _clientSessions;
+
+	static int onNewClientSession(SSL* ssl, SSL_SESSION* session);
+
+	/// Ключ шифрования сессионных билетов (RFC 5077)
+	struct TicketKey final
+	{
+		unsigned char name[16];
+		unsigned char aesKey[32];
+		unsigned char hmacKey[32];
+		std::chrono::steady_clock::time_point created;
+	};
+
+	/// Ключи билетов: первый выпускает новые билеты, прочие только принимают ранее выданные
+	std::mutex _ticketKeysMutex;
+	std::deque<TicketKey> _ticketKeys;
+	std::chrono::seconds _ticketKeyLifetime;
+	std::chrono::seconds _sessionTimeout;
+
+	void rotateTicketKeys();
+
+	/// Выбрать ключ билета и запустить шифр (под _ticketKeysMutex). Возвращает ключ для MAC
+	/// и в result - ответ обработчика билетов; nullptr - ответ уже окончательный
+	const TicketKey* prepareTicketKey(unsigned char* keyName, unsigned char* iv, EVP_CIPHER_CTX* cipherCtx, int encrypt, int& result);
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	static int onTicketKey(SSL* ssl, unsigned char* keyName, unsigned char* iv, EVP_CIPHER_CTX* cipherCtx, EVP_MAC_CTX* macCtx, int encrypt);
+#else
+	static int onTicketKey(SSL* ssl, unsigned char* keyName, unsigned char* iv, EVP_CIPHER_CTX* cipherCtx, HMAC_CTX* hmacCtx, int encrypt);
+#endif
+
+	std::shared_ptr<Metric> _metricFullHandshakes;
+	std::shared_ptr<Metric> _metricResumedHandshakes;
+	std::shared_ptr<Metric> _metricResumeRatio;
 
 public:
 	static std::shared_ptr<SSL_CTX> getServerContext()
@@ -50,5 +94,22 @@ public:
 		return getInstance()._serverContext;
 	}
 
-	static std::shared_ptr<SSL_CTX> getClientContext();
+	static std::shared_ptr<SSL_CTX> getClientContext()
+	{
+		return getInstance()._clientContext;
+	}
+
+	/// Кеш сессий входящих соединений: размер (0 - выключен), время жизни сессии
+	/// и срок, после которого ключ билетов сменяется (0 - билеты не выдаются)
+	static void setSessionCache(size_t size, std::chrono::seconds timeout, std::chrono::seconds ticketKeyLifetime);
+
+	/// Передавать шифрование установленных соединений ядру (kTLS), если ядро и шифр это позволяют
+	static void setKernelOffload(bool enable);
+
+	/// Учесть завершенное рукопожатие входящего соединения
+	static void accountHandshake(SSL* ssl);
+
+	/// Подготовить исходящее соединение к узлу: SNI и возобновление сохраненной сессии.
+	/// Строка адреса должна жить, пока живет SSL
+	static void prepareClient(SSL* ssl, const std::string& host, const std::string* peer);
 };
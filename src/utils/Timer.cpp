@@ -20,78 +20,36 @@
 
 
 #include "Timer.hpp"
-#include "../thread/TaskManager.hpp"
 #include "Daemon.hpp"
 
-Timer::Helper::Helper(const std::shared_ptr<Timer>& timer)
-: _wp(timer)
-, _refCounter(0)
+void Timer::onTime()
 {
-}
-
-void Timer::Helper::onTime()
-{
-	auto timeout = _wp.lock();
-	if (!timeout)
-	{
-		return;
-	}
-
-	timeout->_mutex.lock();
-
-	_refCounter--;
+	_mutex.lock();
 
-	if (timeout->alarm())
+	// Остановлен или уже сработал
+	if (!_armed)
 	{
+		_mutex.unlock();
 		return;
 	}
 
-	if (_refCounter == 0)
-	{
-		start(timeout->_actualAlarmTime);
-	}
-
-	timeout->_mutex.unlock();
-}
-
-void Timer::Helper::start(std::chrono::steady_clock::time_point time)
-{
-	auto timeout = _wp.lock();
-	if (!timeout)
+	if (alarm())
 	{
 		return;
 	}
 
-	++_refCounter;
-
-	TaskManager::enqueue(
-		[p = ptr()]
-		{
-			p->onTime();
-		},
-		time,
-		timeout->label()
-	);
-}
+	// Сработали раньше (время сдвинули, пока задача ждала исполнения) - встаем на новое время
+	TimerWheel::schedule(_entry, _actualAlarmTime);
 
-void Timer::Helper::cancel()
-{
-	auto timer = _wp.lock();
-	if (!timer)
-	{
-		return;
-	}
-
-	timer->_helper.reset();
-	_wp.reset();
+	_mutex.unlock();
 }
 
-
-Timer::Timer(std::function<void()> handler, const char* label)
+Timer::Timer(Task::Func handler, const char* label)
 : _label(label)
 , _handler(std::move(handler))
 , _actualAlarmTime(std::chrono::steady_clock::now())
-, _nextAlarmTime(std::chrono::time_point<std::chrono::steady_clock>::max())
+, _armed(false)
+, _entry(label)
 {
 }
 
@@ -102,6 +60,7 @@ bool Timer::alarm()
 		return false;
 	}
 
+	_armed = false;
 	_mutex.unlock();
 	_handler();
 	return true;
@@ -109,44 +68,27 @@ bool Timer::alarm()
 
 Timer::AlarmTime Timer::appoint(AlarmTime currentTime, AlarmTime alarmTime, bool once)
 {
-	if (once)
+	if (once && _actualAlarmTime > currentTime)
 	{
-		if (_actualAlarmTime > currentTime)
-		{
-			return _actualAlarmTime;
-		}
-
-		_actualAlarmTime = alarmTime;
-
-		_nextAlarmTime = _actualAlarmTime;
-	}
-	else
-	{
-		_actualAlarmTime = alarmTime;
-
-		auto prevExpireTime = _nextAlarmTime;
-
-		if (_actualAlarmTime < std::max(currentTime, _nextAlarmTime))
-		{
-			_nextAlarmTime = _actualAlarmTime;
-		}
-		else
-		{
-			_nextAlarmTime = std::max(currentTime, _nextAlarmTime);
-		}
-
-		if (prevExpireTime <= _nextAlarmTime)
-		{
-			return _actualAlarmTime;
-		}
+		return _actualAlarmTime;
 	}
 
-	if (!_helper)
+	_actualAlarmTime = alarmTime;
+	_armed = true;
+
+	if (!_entry.isBound())
 	{
-		_helper = std::make_shared<Helper>(ptr());
+		_entry.bind(
+			std::weak_ptr<Timer>(ptr()),
+			[](const std::shared_ptr<void>& owner)
+			{
+				static_cast<Timer*>(owner.get())->onTime();
+			}
+		);
 	}
 
-	_helper->start(_nextAlarmTime);
+	// Перестановка в колесе - O(1), без новой задачи в очереди
+	TimerWheel::schedule(_entry, _actualAlarmTime);
 
 	return _actualAlarmTime;
 }
@@ -206,5 +148,9 @@ void Timer::stop()
 {
 	std::lock_guard<mutex_t> lockGuard(_mutex);
 
-	_helper->cancel();
+	TimerWheel::cancel(_entry);
+
+	_armed = false;
+
+	_actualAlarmTime = std::chrono::steady_clock::now();
 }
@@ -21,9 +21,10 @@
 
 #pragma once
 
-#include <functional>
 #include <mutex>
 #include "Shareable.hpp"
+#include "TimerWheel.hpp"
+#include "../thread/Task.hpp"
 
 class Timer final: public Shareable<Timer>
 {
@@ -31,40 +32,21 @@ public:
 	typedef std::chrono::steady_clock::time_point AlarmTime;
 
 private:
-	class Helper final: public Shareable<Helper>
-	{
-	private:
-		std::weak_ptr<Timer> _wp;
-		size_t _refCounter;
-
-		void onTime();
-
-	public:
-		Helper() = delete; // Default-constructor
-		Helper(const Helper&) = delete; // Copy-constructor
-		Helper& operator=(const Helper&) = delete; // Copy-assignment
-		Helper(Helper&&) noexcept = delete; // Move-constructor
-		Helper& operator=(Helper&&) noexcept = delete; // Move-assignment
-
-		explicit Helper(const std::shared_ptr<Timer>& timer);
-		~Helper() override = default;
-
-		void start(AlarmTime time);
-
-		void cancel();
-	};
-
-
 	using mutex_t = std::mutex;
 	mutex_t _mutex;
 
 	const char *_label;
-	std::function<void()> _handler;
+	Task::Func _handler;
 
 	AlarmTime _actualAlarmTime;
-	AlarmTime _nextAlarmTime;
 
-	std::shared_ptr<Helper> _helper;
+	/// Взведен (ожидает срабатывания)
+	bool _armed;
+
+	/// Место в колесе таймеров
+	TimerWheel::Entry _entry;
+
+	void onTime();
 
 	AlarmTime appoint(AlarmTime currentTime, AlarmTime alarmTime, bool once);
 	bool alarm();
@@ -76,7 +58,7 @@ public:
 	Timer(Timer&&) noexcept = delete; // Move-constructor
 	Timer& operator=(Timer&&) noexcept = delete; // Move-assignment
 
-	explicit Timer(std::function<void()> handler, const char* label);
+	explicit Timer(Task::Func handler, const char* label);
 	~Timer() override = default;
 
 	// Метка задачи (имя, название и т.п., для отладки)
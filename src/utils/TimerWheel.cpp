@@ -0,0 +1,307 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// TimerWheel.cpp
+
+
+#include "TimerWheel.hpp"
+#include "../thread/TaskManager.hpp"
+#include "Daemon.hpp"
+
+#include <vector>
+
+constexpr std::chrono::milliseconds TimerWheel::tick;
+
+TimerWheel::Entry::~Entry()
+{
+	TimerWheel::cancel(*this);
+}
+
+TimerWheel::TimerWheel()
+: _origin(Clock::now())
+, _now(0)
+, _count(0)
+, _due(std::numeric_limits<uint64_t>::max())
+{
+	for (auto& level : _slots)
+	{
+		for (auto& head : level)
+		{
+			head._prev = head._next = &head;
+		}
+	}
+}
+
+uint64_t TimerWheel::toTick(Time time) const
+{
+	if (time <= _origin)
+	{
+		return 0;
+	}
+	// Округляем вверх, чтобы не сработать раньше времени
+	return static_cast<uint64_t>((time - _origin + tick - Clock::duration(1)) / tick);
+}
+
+uint64_t TimerWheel::passedTicks(Time time) const
+{
+	if (time <= _origin)
+	{
+		return 0;
+	}
+	return static_cast<uint64_t>((time - _origin) / tick);
+}
+
+TimerWheel::Time TimerWheel::toTime(uint64_t tick_) const
+{
+	return _origin + tick * tick_;
+}
+
+void TimerWheel::link(Entry& entry)
+{
+	uint64_t expire = std::max(entry._expire, _now);
+	uint64_t delta = expire - _now;
+
+	// Слишком далекие ставим на край колеса - при перекладывании они уйдут дальше
+	if (delta >= (1ull << (levelBits * levels)))
+	{
+		expire = _now + (1ull << (levelBits * levels)) - 1;
+		delta = expire - _now;
+	}
+
+	unsigned level = 0;
+	while (delta >= (1ull << (levelBits * (level + 1))))
+	{
+		++level;
+	}
+
+	Link& head = _slots[level][(expire >> (levelBits * level)) & levelMask];
+
+	entry._next = &head;
+	entry._prev = head._prev;
+	head._prev->_next = &entry;
+	head._prev = &entry;
+}
+
+void TimerWheel::unlink(Link& link)
+{
+	link._prev->_next = link._next;
+	link._next->_prev = link._prev;
+	link._prev = link._next = nullptr;
+}
+
+void TimerWheel::cascade(unsigned level)
+{
+	Link& head = _slots[level][(_now >> (levelBits * level)) & levelMask];
+
+	while (head._next != &head)
+	{
+		auto& entry = static_cast<Entry&>(*head._next);
+		unlink(entry);
+		link(entry);
+	}
+}
+
+void TimerWheel::updateDue()
+{
+	if (_count == 0)
+	{
+		_due = std::numeric_limits<uint64_t>::max();
+		return;
+	}
+
+	// Ближайший занятый слот нижнего уровня, но не дальше очередного перекладывания
+	uint64_t tick_ = _now;
+	if ((tick_ & levelMask) == 0)
+	{
+		_due = tick_;
+		return;
+	}
+	do
+	{
+		Link& head = _slots[0][tick_ & levelMask];
+		if (head._next != &head)
+		{
+			break;
+		}
+		++tick_;
+	}
+	while ((tick_ & levelMask) != 0);
+
+	_due = tick_;
+}
+
+void TimerWheel::schedule(Entry& entry, Time time)
+{
+	auto& instance = getInstance();
+
+	std::lock_guard<std::mutex> guard(instance._mutex);
+
+	if (entry._prev != nullptr)
+	{
+		unlink(entry);
+	}
+	else
+	{
+		// Пустое колесо не проворачивается - догоняем текущее время перед постановкой
+		if (instance._count == 0)
+		{
+			instance._now = std::max(instance._now, instance.passedTicks(Clock::now()));
+		}
+		++instance._count;
+	}
+
+	entry._expire = instance.toTick(time);
+	instance.link(entry);
+
+	uint64_t expire = std::max(entry._expire, instance._now);
+	if (expire < instance._due)
+	{
+		instance._due = expire;
+	}
+}
+
+void TimerWheel::cancel(Entry& entry)
+{
+	auto& instance = getInstance();
+
+	std::lock_guard<std::mutex> guard(instance._mutex);
+
+	if (entry._prev == nullptr)
+	{
+		return;
+	}
+
+	unlink(entry);
+	--instance._count;
+}
+
+TimerWheel::Time TimerWheel::nextExpiry()
+{
+	auto& instance = getInstance();
+
+	uint64_t due = instance._due;
+	if (due == std::numeric_limits<uint64_t>::max())
+	{
+		return Time::max();
+	}
+	return instance.toTime(due);
+}
+
+void TimerWheel::advance()
+{
+	auto& instance = getInstance();
+
+	// Тик считается наступившим, только когда он полностью прошел
+	uint64_t target = instance.passedTicks(Clock::now());
+
+	bool shutdown = Daemon::shutingdown();
+
+	// Быстрый выход без блокировки, если время еще не пришло
+	if (!shutdown && instance._due > target)
+	{
+		return;
+	}
+
+	struct Expired final
+	{
+		std::weak_ptr<void> owner;
+		void (*fire)(const std::shared_ptr<void>&);
+		const char* label;
+	};
+
+	// Список сработавших переиспользуется потоком, чтобы не выделять его при каждом проходе
+	static thread_local std::vector<Expired> expired;
+	expired.clear();
+
+	{
+		std::lock_guard<std::mutex> guard(instance._mutex);
+
+		// При остановке сервера срабатывают все таймеры сразу
+		if (shutdown)
+		{
+			for (auto& level : instance._slots)
+			{
+				for (auto& head : level)
+				{
+					while (head._next != &head)
+					{
+						auto& entry = static_cast<Entry&>(*head._next);
+						unlink(entry);
+						--instance._count;
+						expired.push_back({entry._owner, entry._fire, entry._label});
+					}
+				}
+			}
+		}
+
+		if (instance._count == 0)
+		{
+			instance._now = std::max(instance._now, target + 1);
+		}
+
+		while (instance._count > 0 && instance._now <= target)
+		{
+			// Переход через границу уровня - перекладываем элементы вышестоящих уровней
+			for (unsigned level = 1; level < levels; ++level)
+			{
+				if ((instance._now & ((1ull << (levelBits * level)) - 1)) != 0)
+				{
+					break;
+				}
+				instance.cascade(level);
+			}
+
+			Link& head = instance._slots[0][instance._now & levelMask];
+			while (head._next != &head)
+			{
+				auto& entry = static_cast<Entry&>(*head._next);
+				unlink(entry);
+				--instance._count;
+				expired.push_back({entry._owner, entry._fire, entry._label});
+			}
+
+			++instance._now;
+		}
+
+		instance.updateDue();
+	}
+
+	for (auto& i : expired)
+	{
+		TaskManager::enqueue(
+			[owner = std::move(i.owner), fire = i.fire]
+			{
+				if (auto ptr = owner.lock())
+				{
+					fire(ptr);
+				}
+			},
+			i.label
+		);
+	}
+	expired.clear();
+}
+
+bool TimerWheel::empty()
+{
+	auto& instance = getInstance();
+
+	std::lock_guard<std::mutex> guard(instance._mutex);
+
+	return instance._count == 0;
+}
@@ -0,0 +1,171 @@
+// Copyright © 2017-2019 Dmitriy Khaustov
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Dmitriy Khaustov aka xDimon
+// Contacts: khaustov.dm@gmail.com
+// File created on: 2026.10.17
+
+// TimerWheel.hpp
+
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+/// Иерархическое колесо таймеров: постановка, перестановка и отмена за O(1).
+/// Сработавшие таймеры отдаются в TaskManager как немедленные задачи,
+/// поэтому в очереди задач не копятся устаревшие отложенные задачи.
+/// Колесо проворачивают реакторы (таймаут ожидания событий) и рабочие потоки
+class TimerWheel final
+{
+public:
+	using Clock = std::chrono::steady_clock;
+	using Time = Clock::time_point;
+
+private:
+	/// Звено двусвязного кольцевого списка слота
+	class Link
+	{
+		friend class TimerWheel;
+
+	protected:
+		Link* _prev;
+		Link* _next;
+
+	public:
+		Link() noexcept
+		: _prev(nullptr)
+		, _next(nullptr)
+		{
+		}
+		virtual ~Link() = default;
+	};
+
+public:
+	/// Элемент колеса (встраивается во владельца)
+	class Entry final: public Link
+	{
+		friend class TimerWheel;
+
+	private:
+		uint64_t _expire;
+		const char* _label;
+
+		/// Владелец и его обработчик срабатывания: задача держит лишь слабую ссылку
+		/// и указатель на функцию, поэтому помещается в Callable без выделения памяти
+		std::weak_ptr<void> _owner;
+		void (*_fire)(const std::shared_ptr<void>& owner);
+
+	public:
+		Entry() = delete;
+		Entry(const Entry&) = delete;
+		Entry& operator=(const Entry&) = delete;
+		Entry(Entry&&) noexcept = delete;
+		Entry& operator=(Entry&&) noexcept = delete;
+
+		explicit Entry(const char* label) noexcept
+		: _expire(0)
+		, _label(label)
+		, _fire(nullptr)
+		{
+		}
+		~Entry() override;
+
+		/// Задать владельца и обработчик срабатывания (до первой постановки в колесо)
+		void bind(std::weak_ptr<void> owner, void (*fire)(const std::shared_ptr<void>& owner))
+		{
+			_owner = std::move(owner);
+			_fire = fire;
+		}
+
+		bool isBound() const
+		{
+			return _fire != nullptr;
+		}
+	};
+
+	TimerWheel(const TimerWheel&) = delete;
+	TimerWheel& operator=(const TimerWheel&) = delete;
+	TimerWheel(TimerWheel&&) noexcept = delete;
+	TimerWheel& operator=(TimerWheel&&) noexcept = delete;
+
+private:
+	TimerWheel();
+	~TimerWheel() = default;
+
+	static TimerWheel& getInstance()
+	{
+		static TimerWheel instance;
+		return instance;
+	}
+
+	/// Длительность одного тика
+	static constexpr std::chrono::milliseconds tick{1};
+
+	static const unsigned levelBits = 8;
+	static const unsigned levelSize = 1u << levelBits;
+	static const unsigned levelMask = levelSize - 1;
+	static const unsigned levels = 4;
+
+	std::mutex _mutex;
+
+	/// Момент нулевого тика
+	const Time _origin;
+
+	/// Следующий необработанный тик
+	uint64_t _now;
+
+	/// Количество элементов в колесе
+	size_t _count;
+
+	/// Головы списков слотов
+	Link _slots[levels][levelSize];
+
+	/// Ближайший момент, когда колесу есть что делать (тики от _origin)
+	std::atomic<uint64_t> _due;
+
+	/// Тик, на котором наступает момент (с округлением вверх)
+	uint64_t toTick(Time time) const;
+	/// Количество полностью прошедших к моменту тиков
+	uint64_t passedTicks(Time time) const;
+	Time toTime(uint64_t tick) const;
+
+	void link(Entry& entry);
+	static void unlink(Link& link);
+
+	/// Переложить элементы слота верхнего уровня на нижние
+	void cascade(unsigned level);
+
+	/// Пересчитать ближайший момент срабатывания
+	void updateDue();
+
+public:
+	/// Поставить (или переставить) элемент на указанное время
+	static void schedule(Entry& entry, Time time);
+
+	/// Снять элемент с колеса
+	static void cancel(Entry& entry);
+
+	/// Момент, до которого колесо можно не проворачивать
+	static Time nextExpiry();
+
+	/// Провернуть колесо до текущего момента, отдав сработавшие таймеры на исполнение
+	static void advance();
+
+	/// Колесо пусто
+	static bool empty();
+};